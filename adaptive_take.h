@@ -0,0 +1,136 @@
+// (c) Copyright, Real-Time Innovations, 2021.  All rights reserved.
+// RTI grants Licensee a license to use, modify, compile, and create derivative
+// works of the software solely for use with RTI Connext DDS. Licensee may
+// redistribute copies of the software provided that all such copies are subject
+// to this license. The software is provided "as is", with no warranty of any
+// type, including any warranty for fitness for any purpose. RTI is under no
+// obligation to maintain or support the software. RTI shall not be liable for
+// any incidental or consequential damages arising out of the use or inability
+// to use the software.
+
+#ifndef ADAPTIVE_TAKE_H
+#define ADAPTIVE_TAKE_H
+
+#include <atomic>
+#include <cstdint>
+#include <iostream>
+
+#include "rti_me_c.h"
+
+// Picks the max_samples argument for the next take() from the size of the
+// backlog observed by the previous one. A take that comes back full means
+// more data is queued, so the batch doubles; a take that comes back mostly
+// empty halves it again. The batch never exceeds the reader's
+// resource_limits.max_samples, which is the most a single take can loan out.
+class AdaptiveTakeSizer {
+public:
+    AdaptiveTakeSizer(DDS_Long min_batch, DDS_Long max_batch)
+        : min_batch_(min_batch < 1 ? 1 : min_batch),
+          max_batch_(max_batch < min_batch_ ? min_batch_ : max_batch),
+          batch_(min_batch_)
+    {
+    }
+
+    DDS_Long next() const { return batch_; }
+
+    // feed back how many samples the last take() returned
+    void update(DDS_Long taken)
+    {
+        if (taken >= batch_) {
+            batch_ = (batch_ > max_batch_ / 2) ? max_batch_ : batch_ * 2;
+        } else if (taken < batch_ / 4) {
+            batch_ = (batch_ / 2 < min_batch_) ? min_batch_ : batch_ / 2;
+        }
+    }
+
+    DDS_Long max_batch() const { return max_batch_; }
+
+private:
+    const DDS_Long min_batch_;
+    const DDS_Long max_batch_;
+    DDS_Long batch_;
+};
+
+// Counters describing how much work each on_data_available callback did.
+// Written by one listener thread at a time, read by the main thread for
+// reporting.
+struct TakeStats {
+    static const int k_histogram_buckets = 8;  // 1, 2-3, 4-7, ... 128+
+
+    std::atomic<std::uint64_t> callbacks{0};
+    std::atomic<std::uint64_t> takes{0};
+    std::atomic<std::uint64_t> samples{0};
+    std::atomic<std::uint64_t> max_samples_per_callback{0};
+    std::atomic<std::uint64_t> max_callback_ns{0};
+    std::atomic<std::uint64_t> total_callback_ns{0};
+    // log2 histogram of samples drained per callback
+    std::atomic<std::uint64_t> per_callback[k_histogram_buckets];
+
+    TakeStats()
+    {
+        for (auto &bucket : per_callback) {
+            bucket.store(0, std::memory_order_relaxed);
+        }
+    }
+
+    void record_callback(
+            std::uint64_t callback_samples,
+            std::uint64_t callback_takes,
+            std::uint64_t callback_ns)
+    {
+        callbacks.fetch_add(1, std::memory_order_relaxed);
+        takes.fetch_add(callback_takes, std::memory_order_relaxed);
+        samples.fetch_add(callback_samples, std::memory_order_relaxed);
+        total_callback_ns.fetch_add(callback_ns, std::memory_order_relaxed);
+        // only one listener thread writes at a time, so load/store is enough
+        // for max
+        if (callback_samples >
+                max_samples_per_callback.load(std::memory_order_relaxed)) {
+            max_samples_per_callback.store(
+                    callback_samples,
+                    std::memory_order_relaxed);
+        }
+        if (callback_ns > max_callback_ns.load(std::memory_order_relaxed)) {
+            max_callback_ns.store(callback_ns, std::memory_order_relaxed);
+        }
+        auto bucket = 0;
+        while (callback_samples > 1 && bucket < k_histogram_buckets - 1) {
+            callback_samples >>= 1;
+            ++bucket;
+        }
+        per_callback[bucket].fetch_add(1, std::memory_order_relaxed);
+    }
+
+    // time spent taking and processing, per sample
+    double ns_per_sample() const
+    {
+        auto n_samples = samples.load(std::memory_order_relaxed);
+        return n_samples ? static_cast<double>(total_callback_ns.load(
+                std::memory_order_relaxed)) / n_samples : 0.0;
+    }
+
+    void print(std::ostream &os) const
+    {
+        auto n_callbacks = callbacks.load(std::memory_order_relaxed);
+        auto n_samples = samples.load(std::memory_order_relaxed);
+        os << "take stats: callbacks = " << n_callbacks
+                << ", takes = " << takes.load(std::memory_order_relaxed)
+                << ", samples = " << n_samples
+                << ", avg samples/callback = "
+                << (n_callbacks ? (double)n_samples / n_callbacks : 0.0)
+                << ", max samples/callback = "
+                << max_samples_per_callback.load(std::memory_order_relaxed)
+                << ", max callback time = "
+                << max_callback_ns.load(std::memory_order_relaxed) / 1000
+                << " us, time/sample = " << ns_per_sample() << " ns"
+                << std::endl;
+        os << "\tsamples/callback histogram:";
+        for (auto i = 0; i < k_histogram_buckets; ++i) {
+            os << " [" << (1 << i) << (i == k_histogram_buckets - 1 ? "+" : "")
+                    << "]=" << per_callback[i].load(std::memory_order_relaxed);
+        }
+        os << std::endl;
+    }
+};
+
+#endif
@@ -0,0 +1,589 @@
+// (c) Copyright, Real-Time Innovations, 2021.  All rights reserved.
+// RTI grants Licensee a license to use, modify, compile, and create derivative
+// works of the software solely for use with RTI Connext DDS. Licensee may
+// redistribute copies of the software provided that all such copies are subject
+// to this license. The software is provided "as is", with no warranty of any
+// type, including any warranty for fitness for any purpose. RTI is under no
+// obligation to maintain or support the software. RTI shall not be liable for
+// any incidental or consequential damages arising out of the use or inability
+// to use the software.
+
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <vector>
+
+#include "app_config.h"
+#include "batch_accumulator.h"
+#include "backpressure_writer.h"
+#include "columnar_export.h"
+#include "lane_router.h"
+#include "cyclic_scheduler.h"
+#include "payload_integrity.h"
+
+namespace {
+
+// One table per value type maps "section.key" to the AppConfig member
+struct IntSetting {
+    const char *key;
+    int AppConfig::*member;
+    int min;
+    int max;
+};
+
+struct BoolSetting {
+    const char *key;
+    bool AppConfig::*member;
+};
+
+struct StringSetting {
+    const char *key;
+    std::string AppConfig::*member;
+};
+
+// IPv4 addresses and masks, written in dotted-decimal form
+struct IpSetting {
+    const char *key;
+    unsigned int AppConfig::*member;
+};
+
+const int k_int_max = 0x7fffffff;
+const int k_int_min = -k_int_max - 1;
+
+const IntSetting k_int_settings[] = {
+    { "domain.id", &AppConfig::domain_id, 0, 232 },
+    { "discovery.publisher_writer_object_id",
+            &AppConfig::publisher_writer_object_id, 1, 0xffffff },
+    { "discovery.subscriber_reader_object_id",
+            &AppConfig::subscriber_reader_object_id, 1, 0xffffff },
+    { "discovery.initial_participant_announcements",
+            &AppConfig::initial_participant_announcements, 0, 1000 },
+    { "discovery.initial_participant_announcement_period_ms",
+            &AppConfig::initial_participant_announcement_period_ms, 1, 60000 },
+    { "discovery.remote_participant_allocation",
+            &AppConfig::remote_participant_allocation, 1, 1024 },
+    { "fanout.subscribers", &AppConfig::fanout_subscribers, 1, 1024 },
+    { "fanout.subscriber_index",
+            &AppConfig::fanout_subscriber_index, 0, 1023 },
+    { "qos.max_instances", &AppConfig::max_instances, 1, k_int_max },
+    { "qos.max_samples_per_instance",
+            &AppConfig::max_samples_per_instance, 1, k_int_max },
+    { "qos.history_depth", &AppConfig::history_depth, 1, k_int_max },
+    { "qos.heartbeat_period_ms", &AppConfig::heartbeat_period_ms, 1, 3600000 },
+    { "qos.max_remote_writers", &AppConfig::max_remote_writers, 1, 1024 },
+    { "publisher.write_period_ms", &AppConfig::write_period_ms, 0, 3600000 },
+    { "publisher.match_timeout_ms",
+            &AppConfig::match_timeout_ms, 0, k_int_max },
+    { "publisher.payload_bytes", &AppConfig::payload_bytes,
+            0, (int)k_my_type_msg_max_length },
+    { "flow.bytes_per_second",
+            &AppConfig::flow_bytes_per_second, 0, k_int_max },
+    { "flow.burst_bytes", &AppConfig::flow_burst_bytes, 1, k_int_max },
+    { "backpressure.staging_capacity",
+            &AppConfig::backpressure_staging_capacity, 1, 1 << 20 },
+    { "lanes.urgent_writer_object_id",
+            &AppConfig::lanes_urgent_writer_object_id, 1, 0xffffff },
+    { "lanes.urgent_reader_object_id",
+            &AppConfig::lanes_urgent_reader_object_id, 1, 0xffffff },
+    { "lanes.urgent_history_depth",
+            &AppConfig::lanes_urgent_history_depth, 1, k_int_max },
+    { "lanes.urgent_heartbeat_period_ms",
+            &AppConfig::lanes_urgent_heartbeat_period_ms, 1, 3600000 },
+    { "batch.max_records", &AppConfig::batch_max_records,
+            1, MY_TYPE_BATCH_MAX_BYTES },
+    { "batch.max_bytes", &AppConfig::batch_max_bytes,
+            (int)k_batch_record_max, MY_TYPE_BATCH_MAX_BYTES },
+    { "batch.max_delay_us", &AppConfig::batch_max_delay_us, 0, 60000000 },
+    { "inprocess.samples", &AppConfig::inprocess_samples, 1, k_int_max },
+    { "inprocess.write_period_us",
+            &AppConfig::inprocess_write_period_us, 0, 1000000 },
+    { "subscriber.min_samples_per_take",
+            &AppConfig::min_samples_per_take, 1, k_int_max },
+    { "subscriber.latest_value_cache_capacity",
+            &AppConfig::latest_value_cache_capacity, 1, 1 << 20 },
+    { "subscriber.report_period_ms",
+            &AppConfig::report_period_ms, 100, k_int_max },
+    { "downsample.min_separation_ms",
+            &AppConfig::downsample_min_separation_ms, 0, 3600000 },
+    { "columnar.rows", &AppConfig::columnar_rows, 1, 1 << 20 },
+    { "recorder.segment_size_mb",
+            &AppConfig::record_segment_size_mb, 1, 4096 },
+    { "soak.duration_s", &AppConfig::soak_duration_s, 0, k_int_max },
+    { "soak.sample_period_s", &AppConfig::soak_sample_period_s, 1, 86400 },
+    { "soak.warmup_s", &AppConfig::soak_warmup_s, 0, k_int_max },
+    { "soak.max_rss_growth_kb_per_hour",
+            &AppConfig::soak_max_rss_growth_kb_per_hour, 0, k_int_max },
+    { "soak.max_fd_growth_per_hour",
+            &AppConfig::soak_max_fd_growth_per_hour, 0, k_int_max },
+    { "soak.max_latency_growth_pct_per_hour",
+            &AppConfig::soak_max_latency_growth_pct_per_hour, 0, k_int_max },
+    { "soak.max_throughput_decay_pct_per_hour",
+            &AppConfig::soak_max_throughput_decay_pct_per_hour, 0, 100 },
+    { "replay.start_ms", &AppConfig::replay_start_ms, 0, k_int_max },
+    { "replay.id", &AppConfig::replay_id, k_int_min, k_int_max },
+};
+
+const BoolSetting k_bool_settings[] = {
+    { "type.template_plugin", &AppConfig::template_type_plugin },
+    { "type.plugin_check", &AppConfig::type_plugin_check },
+    { "discovery.fast_bringup", &AppConfig::fast_bringup },
+    { "qos.reliable", &AppConfig::reliable },
+    { "publisher.wait_for_match", &AppConfig::wait_for_match },
+    { "latency.monotonic_source_timestamp",
+            &AppConfig::latency_monotonic_source_timestamp },
+    { "latency.per_second_report", &AppConfig::latency_per_second_report },
+    { "batch.enabled", &AppConfig::batch_enabled },
+    { "integrity.enabled", &AppConfig::integrity_enabled },
+    { "integrity.benchmark", &AppConfig::integrity_benchmark },
+    { "durability.transient_local",
+            &AppConfig::durability_transient_local },
+    { "inprocess.intra_transport", &AppConfig::inprocess_intra_transport },
+    { "subscriber.print_samples", &AppConfig::print_samples },
+    { "subscriber.event_loop", &AppConfig::event_loop },
+    { "soak.enabled", &AppConfig::soak_enabled },
+    { "replay.as_fast_as_possible", &AppConfig::replay_as_fast_as_possible },
+    { "replay.filter_by_id", &AppConfig::replay_filter_by_id },
+    { "report.print_config", &AppConfig::print_config },
+};
+
+const StringSetting k_string_settings[] = {
+    { "network.loopback_name", &AppConfig::loopback_name },
+    { "network.real_nic_name", &AppConfig::real_nic_name },
+    { "discovery.publisher_initial_peer",
+            &AppConfig::publisher_initial_peer },
+    { "discovery.publisher_name", &AppConfig::publisher_name },
+    { "discovery.subscriber_initial_peer",
+            &AppConfig::subscriber_initial_peer },
+    { "discovery.subscriber_name", &AppConfig::subscriber_name },
+    { "recorder.prefix", &AppConfig::record_prefix },
+    { "replay.prefix", &AppConfig::replay_prefix },
+    { "backpressure.policy", &AppConfig::backpressure_policy },
+    { "schedule.streams", &AppConfig::schedule_streams },
+    { "lanes.urgent_ids", &AppConfig::lanes_urgent_ids },
+    { "lanes.urgent_backpressure_policy",
+            &AppConfig::lanes_urgent_backpressure_policy },
+    { "fanout.multicast_address", &AppConfig::fanout_multicast_address },
+    { "durability.snapshot_path", &AppConfig::durability_snapshot_path },
+    { "columnar.mode", &AppConfig::columnar_mode },
+    { "trace.output", &AppConfig::trace_output },
+    { "report.stats_output", &AppConfig::stats_output },
+};
+
+const IpSetting k_ip_settings[] = {
+    { "network.loopback_ip", &AppConfig::loopback_ip },
+    { "network.loopback_mask", &AppConfig::loopback_mask },
+    { "network.real_nic_ip", &AppConfig::real_nic_ip },
+    { "network.real_nic_mask", &AppConfig::real_nic_mask },
+};
+
+std::string trim(const std::string &text)
+{
+    const char *whitespace = " \t\r\n";
+    auto first = text.find_first_not_of(whitespace);
+    if (first == std::string::npos) {
+        return std::string();
+    }
+    auto last = text.find_last_not_of(whitespace);
+    return text.substr(first, last - first + 1);
+}
+
+bool parse_int(const std::string &text, long *value)
+{
+    if (text.empty()) {
+        return false;
+    }
+    char *end = NULL;
+    errno = 0;
+    // base 0 so object ids and masks can be given in hex
+    *value = std::strtol(text.c_str(), &end, 0);
+    return errno == 0 && *end == '\0';
+}
+
+bool parse_bool(const std::string &text, bool *value)
+{
+    if (text == "true" || text == "yes" || text == "on" || text == "1") {
+        *value = true;
+        return true;
+    }
+    if (text == "false" || text == "no" || text == "off" || text == "0") {
+        *value = false;
+        return true;
+    }
+    return false;
+}
+
+// a netmask must be a run of ones followed by a run of zeroes
+bool is_contiguous_mask(unsigned int mask)
+{
+    unsigned int inverted = ~mask;
+    return (inverted & (inverted + 1)) == 0;
+}
+
+} // namespace
+
+bool app_config_parse_ip(const std::string &text, unsigned int *ip)
+{
+    unsigned int octets[4];
+    char trailing;
+    if (std::sscanf(
+                text.c_str(),
+                "%u.%u.%u.%u%c",
+                &octets[0], &octets[1], &octets[2], &octets[3],
+                &trailing) != 4) {
+        // also accept a plain number, e.g. 0xffffff00
+        long value;
+        if (!parse_int(text, &value) || value < 0 || value > 0xffffffffL) {
+            return false;
+        }
+        *ip = (unsigned int)value;
+        return true;
+    }
+    *ip = 0;
+    for (auto octet : octets) {
+        if (octet > 255) {
+            return false;
+        }
+        *ip = (*ip << 8) | octet;
+    }
+    return true;
+}
+
+// "a.b.c.d", or "N@a.b.c.d" to announce to participant indexes 0..N there
+static bool valid_initial_peer(const std::string &peer)
+{
+    unsigned int ip;
+    auto at = peer.find('@');
+    if (at == std::string::npos) {
+        return app_config_parse_ip(peer, &ip);
+    }
+    long max_index;
+    return parse_int(peer.substr(0, at), &max_index) && max_index >= 0 &&
+            app_config_parse_ip(peer.substr(at + 1), &ip);
+}
+
+std::string app_config_format_ip(unsigned int ip)
+{
+    std::ostringstream text;
+    text << ((ip >> 24) & 0xff) << "." << ((ip >> 16) & 0xff) << "."
+            << ((ip >> 8) & 0xff) << "." << (ip & 0xff);
+    return text.str();
+}
+
+std::string app_config_subscriber_name(const AppConfig &config, int index)
+{
+    if (config.fanout_subscribers == 1) {
+        return config.subscriber_name;
+    }
+    return config.subscriber_name + "_" + std::to_string(index);
+}
+
+bool app_config_set(
+        AppConfig *config,
+        const std::string &key,
+        const std::string &value,
+        std::ostream &errors)
+{
+    for (const auto &setting : k_int_settings) {
+        if (key == setting.key) {
+            long parsed;
+            if (!parse_int(value, &parsed) ||
+                    parsed < setting.min ||
+                    parsed > setting.max) {
+                errors << "ERROR: " << key << " = '" << value
+                        << "' must be an integer in [" << setting.min
+                        << ", " << setting.max << "]" << std::endl;
+                return false;
+            }
+            config->*setting.member = (int)parsed;
+            return true;
+        }
+    }
+    for (const auto &setting : k_bool_settings) {
+        if (key == setting.key) {
+            if (!parse_bool(value, &(config->*setting.member))) {
+                errors << "ERROR: " << key << " = '" << value
+                        << "' must be true or false" << std::endl;
+                return false;
+            }
+            return true;
+        }
+    }
+    for (const auto &setting : k_string_settings) {
+        if (key == setting.key) {
+            config->*setting.member = value;
+            return true;
+        }
+    }
+    for (const auto &setting : k_ip_settings) {
+        if (key == setting.key) {
+            if (!app_config_parse_ip(value, &(config->*setting.member))) {
+                errors << "ERROR: " << key << " = '" << value
+                        << "' is not an IPv4 address" << std::endl;
+                return false;
+            }
+            return true;
+        }
+    }
+    errors << "ERROR: unknown setting " << key << std::endl;
+    return false;
+}
+
+bool app_config_load(
+        AppConfig *config,
+        const char *path,
+        std::ostream &errors)
+{
+    std::ifstream file(path);
+    if (!file) {
+        errors << "ERROR: failed to open config file " << path << std::endl;
+        return false;
+    }
+
+    auto ok = true;
+    std::string section;
+    std::string line;
+    for (auto line_number = 1; std::getline(file, line); ++line_number) {
+        line = trim(line);
+        if (line.empty() || line[0] == '#' || line[0] == ';') {
+            continue;
+        }
+        if (line[0] == '[') {
+            if (line[line.size() - 1] != ']') {
+                errors << "ERROR: " << path << ":" << line_number
+                        << ": unterminated section header" << std::endl;
+                ok = false;
+                continue;
+            }
+            section = trim(line.substr(1, line.size() - 2));
+            continue;
+        }
+        auto equals = line.find('=');
+        if (equals == std::string::npos || section.empty()) {
+            errors << "ERROR: " << path << ":" << line_number
+                    << ": expected 'key = value' inside a [section]"
+                    << std::endl;
+            ok = false;
+            continue;
+        }
+        auto key = section + "." + trim(line.substr(0, equals));
+        if (!app_config_set(
+                    config,
+                    key,
+                    trim(line.substr(equals + 1)),
+                    errors)) {
+            errors << "\tat " << path << ":" << line_number << std::endl;
+            ok = false;
+        }
+    }
+    return ok;
+}
+
+bool app_config_validate(const AppConfig &config, std::ostream &errors)
+{
+    auto ok = true;
+    auto fail = [&](const std::string &message) {
+        errors << "ERROR: invalid configuration: " << message << std::endl;
+        ok = false;
+    };
+
+    if (!is_contiguous_mask(config.loopback_mask)) {
+        fail("network.loopback_mask is not a contiguous netmask");
+    }
+    if (!is_contiguous_mask(config.real_nic_mask)) {
+        fail("network.real_nic_mask is not a contiguous netmask");
+    }
+    if (config.loopback_name.empty() || config.real_nic_name.empty()) {
+        fail("interface names must not be empty");
+    }
+    if (config.loopback_name == config.real_nic_name) {
+        fail("network.loopback_name and network.real_nic_name are the same");
+    }
+
+    // DPSE finds the remote participant by name, so the two must differ
+    // and fit in the participant_name QoS
+    const std::string::size_type k_max_name_length = 255;
+    if (config.publisher_name.empty() ||
+            config.publisher_name.size() > k_max_name_length ||
+            config.subscriber_name.empty() ||
+            config.subscriber_name.size() > k_max_name_length) {
+        fail("participant names must be 1 to 255 characters long");
+    }
+    if (config.publisher_name == config.subscriber_name) {
+        fail("discovery.publisher_name and discovery.subscriber_name "
+                "must differ");
+    }
+    if (!valid_initial_peer(config.publisher_initial_peer) ||
+            !valid_initial_peer(config.subscriber_initial_peer)) {
+        fail("initial peers must be IPv4 addresses, optionally as N@a.b.c.d");
+    }
+
+    if (config.fanout_subscriber_index >= config.fanout_subscribers) {
+        fail("fanout.subscriber_index must be below fanout.subscribers");
+    }
+    if (config.fanout_subscribers > config.remote_participant_allocation) {
+        fail("fanout.subscribers is larger than "
+                "discovery.remote_participant_allocation");
+    }
+    if (app_config_subscriber_name(config, config.fanout_subscribers - 1)
+                .size() > k_max_name_length) {
+        fail("discovery.subscriber_name is too long for fan-out");
+    }
+    if (!config.fanout_multicast_address.empty()) {
+        unsigned int group;
+        if (!app_config_parse_ip(config.fanout_multicast_address, &group) ||
+                (group >> 28) != 0xe) {
+            fail("fanout.multicast_address is not an IPv4 multicast group");
+        }
+    }
+
+    if (config.history_depth > config.max_samples_per_instance) {
+        fail("qos.history_depth is larger than qos.max_samples_per_instance");
+    }
+    if ((long)config.max_instances * config.max_samples_per_instance >
+            k_int_max) {
+        fail("qos.max_instances * qos.max_samples_per_instance overflows");
+    }
+    BackpressurePolicy policy;
+    if (!parse_backpressure_policy(config.backpressure_policy, &policy)) {
+        fail("backpressure.policy must be block, drop_newest, drop_oldest "
+                "or coalesce");
+    }
+    std::vector<DDS_Long> urgent_ids;
+    if (!parse_lane_ids(config.lanes_urgent_ids, &urgent_ids, errors)) {
+        fail("lanes.urgent_ids is not a list of ids and first-last ranges");
+    }
+    if (!urgent_ids.empty()) {
+        if (!parse_backpressure_policy(
+                    config.lanes_urgent_backpressure_policy, &policy)) {
+            fail("lanes.urgent_backpressure_policy must be block, "
+                    "drop_newest, drop_oldest or coalesce");
+        }
+        if (config.lanes_urgent_writer_object_id ==
+                        config.publisher_writer_object_id ||
+                config.lanes_urgent_reader_object_id ==
+                        config.subscriber_reader_object_id) {
+            fail("the urgent lane needs object ids of its own");
+        }
+        if (config.lanes_urgent_history_depth >
+                config.max_samples_per_instance) {
+            fail("lanes.urgent_history_depth is larger than "
+                    "qos.max_samples_per_instance");
+        }
+    }
+    if (config.batch_enabled && config.backpressure_policy != "block") {
+        fail("batch.enabled needs backpressure.policy = block");
+    }
+    if (config.integrity_enabled &&
+            config.payload_bytes > (int)k_integrity_max_payload) {
+        fail("publisher.payload_bytes leaves no room for the integrity "
+                "trailer");
+    }
+    if (config.durability_transient_local && !config.reliable) {
+        fail("durability.transient_local needs qos.reliable");
+    }
+    ColumnarMode columnar;
+    if (!parse_columnar_mode(config.columnar_mode, &columnar)) {
+        fail("columnar.mode must be off, per_sample or columnar");
+    }
+    std::vector<StreamRate> rates;
+    if (!config.schedule_streams.empty()) {
+        if (!parse_stream_rates(config.schedule_streams, &rates, errors)) {
+            fail("schedule.streams is not a list of rate_hz:count");
+        }
+        long streams = 0;
+        for (const auto &rate : rates) {
+            streams += rate.count;
+        }
+        if (streams > config.max_instances) {
+            fail("schedule.streams has more streams than qos.max_instances");
+        }
+    }
+    if (config.latest_value_cache_capacity < config.max_instances) {
+        fail("subscriber.latest_value_cache_capacity is smaller than "
+                "qos.max_instances");
+    }
+    return ok;
+}
+
+bool app_config_from_command_line(
+        AppConfig *config,
+        int *argc,
+        char *argv[],
+        std::ostream &errors)
+{
+    auto ok = true;
+    auto remaining = 1;
+    for (auto i = 1; i < *argc; ++i) {
+        std::string arg(argv[i]);
+        if (arg == "--config" && i + 1 < *argc) {
+            ok = app_config_load(config, argv[++i], errors) && ok;
+        } else if (arg == "--set" && i + 1 < *argc) {
+            std::string setting(argv[++i]);
+            auto equals = setting.find('=');
+            if (equals == std::string::npos) {
+                errors << "ERROR: --set expects section.key=value"
+                        << std::endl;
+                ok = false;
+                continue;
+            }
+            ok = app_config_set(
+                    config,
+                    trim(setting.substr(0, equals)),
+                    trim(setting.substr(equals + 1)),
+                    errors) && ok;
+        } else {
+            argv[remaining++] = argv[i];
+        }
+    }
+    *argc = remaining;
+    // validate even after an error so every problem is reported at once
+    return app_config_validate(*config, errors) && ok;
+}
+
+void app_config_print(const AppConfig &config, std::ostream &os)
+{
+    // the tables are grouped by type, so collect each section's lines first
+    const char *sections[] = {
+        "domain", "type", "network", "discovery", "fanout", "qos",
+        "publisher", "flow", "backpressure", "schedule", "lanes", "batch",
+        "integrity", "durability", "latency", "inprocess", "subscriber",
+        "downsample", "columnar", "recorder", "replay", "trace", "soak",
+        "report"
+    };
+    for (auto section : sections) {
+        os << "[" << section << "]" << std::endl;
+        auto prefix = std::string(section) + ".";
+        auto in_section = [&](const char *key) {
+            return std::strncmp(key, prefix.c_str(), prefix.size()) == 0;
+        };
+        for (const auto &setting : k_int_settings) {
+            if (in_section(setting.key)) {
+                os << (setting.key + prefix.size()) << " = "
+                        << config.*setting.member << std::endl;
+            }
+        }
+        for (const auto &setting : k_bool_settings) {
+            if (in_section(setting.key)) {
+                os << (setting.key + prefix.size()) << " = "
+                        << (config.*setting.member ? "true" : "false")
+                        << std::endl;
+            }
+        }
+        for (const auto &setting : k_string_settings) {
+            if (in_section(setting.key)) {
+                os << (setting.key + prefix.size()) << " = "
+                        << config.*setting.member << std::endl;
+            }
+        }
+        for (const auto &setting : k_ip_settings) {
+            if (in_section(setting.key)) {
+                os << (setting.key + prefix.size()) << " = "
+                        << app_config_format_ip(config.*setting.member)
+                        << std::endl;
+            }
+        }
+    }
+}
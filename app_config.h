@@ -0,0 +1,247 @@
+// (c) Copyright, Real-Time Innovations, 2021.  All rights reserved.
+// RTI grants Licensee a license to use, modify, compile, and create derivative
+// works of the software solely for use with RTI Connext DDS. Licensee may
+// redistribute copies of the software provided that all such copies are subject
+// to this license. The software is provided "as is", with no warranty of any
+// type, including any warranty for fitness for any purpose. RTI is under no
+// obligation to maintain or support the software. RTI shall not be liable for
+// any incidental or consequential damages arising out of the use or inability
+// to use the software.
+
+#ifndef APP_CONFIG_H
+#define APP_CONFIG_H
+
+#include <iostream>
+#include <string>
+
+#include "common_config.h"
+
+// Runtime configuration shared by example_publisher and example_subscriber.
+// Every member starts out with the compile-time default from
+// common_config.h; a deployment overrides them with an INI file and/or
+// individual settings on the command line:
+//
+//     example_publisher --config config/low_latency.ini --set domain.id=7
+//
+// The INI subset understood is "[section]" headers, "key = value" lines and
+// full-line comments starting with '#' or ';'. A setting is addressed as
+// "section.key"; see the files in config/ for every supported key.
+struct AppConfig {
+    // [domain]
+    int domain_id = k_domain_id;
+
+    // [type]
+    // register type_plugin.h's my_type plugin instead of the generated one
+    bool template_type_plugin = false;
+    // compare the hand-written plugin paths with the generic ones, and
+    // time both, when example_publisher starts
+    bool type_plugin_check = false;
+
+    // [network]
+    std::string loopback_name = k_loopback_name;
+    unsigned int loopback_ip = k_loopback_ip;
+    unsigned int loopback_mask = k_loopback_mask;
+    std::string real_nic_name = k_real_nic_name;
+    unsigned int real_nic_ip = k_real_nic_ip;
+    unsigned int real_nic_mask = k_real_nic_mask;
+
+    // [discovery]
+    std::string publisher_initial_peer = k_publisher_initial_peer;
+    std::string publisher_name = k_PARTICIPANT01_NAME;
+    int publisher_writer_object_id = k_OBJ_ID_PARTICIPANT01_DW01;
+    std::string subscriber_initial_peer = k_subscriber_initial_peer;
+    std::string subscriber_name = k_PARTICIPANT02_NAME;
+    int subscriber_reader_object_id = k_OBJ_ID_PARTICIPANT02_DR01;
+    bool fast_bringup = k_fast_bringup;
+    int initial_participant_announcements =
+            k_fast_initial_participant_announcements;
+    int initial_participant_announcement_period_ms =
+            k_fast_initial_participant_announcement_period_ms;
+    int remote_participant_allocation = 8;
+
+    // [fanout]
+    // number of subscriber processes the publisher asserts with DPSE; each
+    // subscriber is started with its own subscriber_index
+    int fanout_subscribers = 1;
+    int fanout_subscriber_index = 0;
+    // IPv4 multicast group the readers receive on; empty uses unicast
+    std::string fanout_multicast_address;
+
+    // [qos]
+    bool reliable = true;
+    int max_instances = 2;
+    int max_samples_per_instance = 32;
+    int history_depth = 16;
+    int heartbeat_period_ms = 250;
+    int max_remote_writers = 10;
+
+    // [publisher]
+    int write_period_ms = 1000;
+    bool wait_for_match = true;
+    int match_timeout_ms = 30000;
+    // pad msg with filler up to this many characters (0: just the text)
+    int payload_bytes = 0;
+
+    // [flow] (example_publisher)
+    // token bucket in front of the DataWriter; 0 bytes/s disables it
+    int flow_bytes_per_second = 0;
+    int flow_burst_bytes = 65536;
+
+    // [backpressure] (example_publisher)
+    // what a write does when the reliable writer's history is full: block,
+    // drop_newest, drop_oldest or coalesce (see backpressure_writer.h)
+    std::string backpressure_policy = "block";
+    int backpressure_staging_capacity = 64;
+
+    // [schedule] (example_publisher)
+    // "rate_hz:count,..." streams for the cyclic scheduler; each stream
+    // writes its own key (id). Empty keeps the write_period_ms loop.
+    std::string schedule_streams;
+
+    // [lanes]
+    // ids whose samples go on the urgent lane, a writer/reader pair and
+    // topic of their own (see lane_router.h), e.g. "0,7,100-109"; empty
+    // keeps a single lane. Set the same in publisher and subscriber.
+    std::string lanes_urgent_ids;
+    int lanes_urgent_writer_object_id = k_OBJ_ID_PARTICIPANT01_DW02;
+    int lanes_urgent_reader_object_id = k_OBJ_ID_PARTICIPANT02_DR02;
+    int lanes_urgent_history_depth = 4;
+    int lanes_urgent_heartbeat_period_ms = 50;
+    std::string lanes_urgent_backpressure_policy = "block";
+
+    // [batch]
+    // pack samples into my_type_batch samples on a topic of their own (see
+    // batch_accumulator.h); set the same in publisher and subscriber
+    bool batch_enabled = false;
+    int batch_max_records = 32;
+    int batch_max_bytes = 4096;
+    int batch_max_delay_us = 1000;
+
+    // [integrity]
+    // CRC32C trailer on every msg (see payload_integrity.h); set the same
+    // in publisher and subscriber
+    bool integrity_enabled = false;
+    // example_publisher times the CRC at every payload size at startup
+    bool integrity_benchmark = false;
+
+    // [durability]
+    // writer and reader keep/ask for the last qos.history_depth samples
+    // per id for late joiners; set the same in publisher and subscriber
+    bool durability_transient_local = false;
+    // example_publisher keeps the latest sample per id in this file and
+    // republishes its contents when it starts; empty disables it
+    std::string durability_snapshot_path;
+
+    // [latency]
+    // the publisher stamps samples with CLOCK_MONOTONIC instead of letting
+    // the middleware use the realtime clock; publisher and subscriber must
+    // then share a host
+    bool latency_monotonic_source_timestamp = false;
+    // the subscriber prints transport/dispatch/total latency every second
+    bool latency_per_second_report = true;
+
+    // [inprocess] (example_inprocess)
+    // samples written, and the pause between writes (0 writes back to
+    // back); user data goes over the intra-process transport unless
+    // intra_transport is false, which keeps it on UDP loopback
+    int inprocess_samples = 10000;
+    int inprocess_write_period_us = 100;
+    bool inprocess_intra_transport = true;
+
+    // [subscriber]
+    int min_samples_per_take = 4;
+    int latest_value_cache_capacity = 256;
+    bool print_samples = true;
+    // take from the reader on the main thread's epoll loop, woken through
+    // an eventfd, instead of inside the listener
+    bool event_loop = false;
+    int report_period_ms = 10000;
+
+    // [downsample] (example_subscriber)
+    // deliver at most one sample per id every min_separation_ms, by source
+    // timestamp, and discard the rest in the listener; 0 delivers all
+    int downsample_min_separation_ms = 0;
+
+    // [columnar] (example_subscriber)
+    // "off", "per_sample" or "columnar": feed per-id counts and the receive
+    // rate one sample at a time, or through double-buffered columns of
+    // rows samples each for a consumer thread (see columnar_export.h)
+    std::string columnar_mode = "off";
+    int columnar_rows = 1024;
+
+    // [recorder] (example_subscriber)
+    // files are <record_prefix>.<n>.rec/.idx; empty disables recording
+    std::string record_prefix;
+    int record_segment_size_mb = 64;
+
+    // [replay] (example_publisher)
+    // republish a recording instead of the generated samples
+    std::string replay_prefix;
+    bool replay_as_fast_as_possible = false;
+    int replay_start_ms = 0;
+    bool replay_filter_by_id = false;
+    int replay_id = 0;
+
+    // [trace]
+    // Chrome trace JSON written on exit; needs EXAMPLE_ENABLE_TRACING
+    std::string trace_output;
+
+    // [soak]
+    // sample RSS, open FDs, throughput, latency p99 and protocol counters
+    // every sample_period_s, and fit trends to them at the end (see
+    // soak_monitor.h); duration_s > 0 ends the run after that long
+    bool soak_enabled = false;
+    int soak_duration_s = 0;
+    int soak_sample_period_s = 60;
+    int soak_warmup_s = 300;
+    int soak_max_rss_growth_kb_per_hour = 256;
+    int soak_max_fd_growth_per_hour = 1;
+    int soak_max_latency_growth_pct_per_hour = 5;
+    int soak_max_throughput_decay_pct_per_hour = 5;
+
+    // [report]
+    // machine-readable end-of-run stats ("key = value" lines) written here
+    // on exit, see stats_report.h; empty writes none
+    std::string stats_output;
+    // print every effective setting at startup, after the overrides
+    bool print_config = false;
+};
+
+// Apply one "section.key" setting. Returns false (and explains why on
+// errors) if the key is unknown or the value can't be parsed.
+bool app_config_set(
+        AppConfig *config,
+        const std::string &key,
+        const std::string &value,
+        std::ostream &errors);
+
+// Read an INI file into config. Settings not in the file keep their value.
+bool app_config_load(
+        AppConfig *config,
+        const char *path,
+        std::ostream &errors);
+
+// Check the loaded values are consistent before any DDS entity is created
+bool app_config_validate(const AppConfig &config, std::ostream &errors);
+
+// Handle "--config FILE" and "--set section.key=value" (both may repeat and
+// are applied in order), then validate. Unrecognized arguments are left in
+// argv for the caller: *argc is updated to the number that remain.
+bool app_config_from_command_line(
+        AppConfig *config,
+        int *argc,
+        char *argv[],
+        std::ostream &errors);
+
+// write every setting in INI format
+void app_config_print(const AppConfig &config, std::ostream &os);
+
+// DPSE name of subscriber process index: subscriber_name itself when there
+// is a single subscriber, subscriber_name_<index> in fan-out
+std::string app_config_subscriber_name(const AppConfig &config, int index);
+
+// "a.b.c.d" <-> host-order IPv4 address
+bool app_config_parse_ip(const std::string &text, unsigned int *ip);
+std::string app_config_format_ip(unsigned int ip);
+
+#endif
@@ -0,0 +1,197 @@
+// (c) Copyright, Real-Time Innovations, 2021.  All rights reserved.
+// RTI grants Licensee a license to use, modify, compile, and create derivative
+// works of the software solely for use with RTI Connext DDS. Licensee may
+// redistribute copies of the software provided that all such copies are subject
+// to this license. The software is provided "as is", with no warranty of any
+// type, including any warranty for fitness for any purpose. RTI is under no
+// obligation to maintain or support the software. RTI shall not be liable for
+// any incidental or consequential damages arising out of the use or inability
+// to use the software.
+
+#include "backpressure_writer.h"
+
+#include <cstring>
+
+#include "latency_stats.h"
+
+namespace {
+
+const struct {
+    const char *name;
+    BackpressurePolicy policy;
+} k_policy_names[] = {
+    { "block", BACKPRESSURE_BLOCK },
+    { "drop_newest", BACKPRESSURE_DROP_NEWEST },
+    { "drop_oldest", BACKPRESSURE_DROP_OLDEST },
+    { "coalesce", BACKPRESSURE_COALESCE },
+};
+
+void copy_msg(char *dst, const char *src)
+{
+    // strnlen is POSIX, so not in std::
+    auto length = strnlen(src, k_my_type_msg_max_length);
+    std::memcpy(dst, src, length);
+    dst[length] = '\0';
+}
+
+}  // namespace
+
+bool parse_backpressure_policy(
+        const std::string &text,
+        BackpressurePolicy *policy)
+{
+    for (const auto &entry : k_policy_names) {
+        if (text == entry.name) {
+            *policy = entry.policy;
+            return true;
+        }
+    }
+    return false;
+}
+
+const char *backpressure_policy_name(BackpressurePolicy policy)
+{
+    for (const auto &entry : k_policy_names) {
+        if (entry.policy == policy) {
+            return entry.name;
+        }
+    }
+    return "unknown";
+}
+
+BackpressureWriter::BackpressureWriter(
+        my_typeDataWriter *writer,
+        BackpressurePolicy policy,
+        std::size_t staging_capacity,
+        bool monotonic_timestamps)
+    : writer_(writer),
+      policy_(policy),
+      capacity_(staging_capacity > 0 ? staging_capacity : 1),
+      monotonic_timestamps_(monotonic_timestamps),
+      staging_(new StagedSample[capacity_]),
+      head_(0),
+      count_(0),
+      written_(0),
+      backpressure_(0),
+      staged_total_(0),
+      flushed_(0),
+      coalesced_(0),
+      dropped_newest_(0),
+      dropped_oldest_(0),
+      failed_(0)
+{
+    scratch_.id = 0;
+    scratch_msg_[0] = '\0';
+    scratch_.msg = scratch_msg_;
+}
+
+BackpressureWriter::Result BackpressureWriter::write(const my_type &sample)
+{
+    // keep the order of writes: nothing overtakes a staged sample
+    if (flush() > 0) {
+        ++backpressure_;
+        return stage(sample);
+    }
+
+    auto retcode = write_now(&sample);
+    if (retcode == DDS_RETCODE_OK) {
+        ++written_;
+        return RESULT_WRITTEN;
+    }
+    if (!is_backpressure(retcode) || policy_ == BACKPRESSURE_BLOCK) {
+        ++failed_;
+        return RESULT_FAILED;
+    }
+    ++backpressure_;
+    return stage(sample);
+}
+
+std::size_t BackpressureWriter::flush()
+{
+    while (count_ > 0) {
+        const auto &front = at(0);
+        scratch_.id = front.id;
+        copy_msg(scratch_msg_, front.msg);
+        auto retcode = write_now(&scratch_);
+        if (is_backpressure(retcode)) {
+            break;
+        }
+        if (retcode == DDS_RETCODE_OK) {
+            ++flushed_;
+        } else {
+            ++failed_;
+        }
+        head_ = (head_ + 1) % capacity_;
+        --count_;
+    }
+    return count_;
+}
+
+// a staged sample is stamped when it is finally written, not when staged
+DDS_ReturnCode_t BackpressureWriter::write_now(const my_type *sample)
+{
+    if (monotonic_timestamps_) {
+        auto now = ns_to_dds_time(monotonic_now_ns());
+        return my_typeDataWriter_write_w_timestamp(
+                writer_,
+                sample,
+                &DDS_HANDLE_NIL,
+                &now);
+    }
+    return my_typeDataWriter_write(writer_, sample, &DDS_HANDLE_NIL);
+}
+
+BackpressureWriter::Result BackpressureWriter::stage(const my_type &sample)
+{
+    switch (policy_) {
+    case BACKPRESSURE_DROP_NEWEST:
+        ++dropped_newest_;
+        return RESULT_DROPPED;
+
+    case BACKPRESSURE_COALESCE:
+        // one entry per id at most, and the number of ids is bounded by
+        // qos.max_instances, so a scan is cheaper than keeping an index
+        for (std::size_t i = 0; i < count_; ++i) {
+            auto &staged = at(i);
+            if (staged.id == sample.id) {
+                copy_msg(staged.msg, sample.msg);
+                ++coalesced_;
+                return RESULT_STAGED;
+            }
+        }
+        if (count_ == capacity_) {
+            ++dropped_newest_;
+            return RESULT_DROPPED;
+        }
+        break;
+
+    default:
+        if (count_ == capacity_) {
+            head_ = (head_ + 1) % capacity_;
+            --count_;
+            ++dropped_oldest_;
+        }
+        break;
+    }
+
+    auto &staged = at(count_);
+    staged.id = sample.id;
+    copy_msg(staged.msg, sample.msg);
+    ++count_;
+    ++staged_total_;
+    return RESULT_STAGED;
+}
+
+void BackpressureWriter::print_stats(std::ostream &os) const
+{
+    os << "backpressure (" << backpressure_policy_name(policy_)
+            << "): written = " << written()
+            << ", writer full = " << backpressure_
+            << ", staged = " << staged_total_
+            << ", flushed = " << flushed_
+            << ", coalesced = " << coalesced_
+            << ", dropped newest = " << dropped_newest_
+            << ", dropped oldest = " << dropped_oldest_
+            << ", failed = " << failed_
+            << ", still staged = " << count_ << std::endl;
+}
@@ -0,0 +1,138 @@
+// (c) Copyright, Real-Time Innovations, 2021.  All rights reserved.
+// RTI grants Licensee a license to use, modify, compile, and create derivative
+// works of the software solely for use with RTI Connext DDS. Licensee may
+// redistribute copies of the software provided that all such copies are subject
+// to this license. The software is provided "as is", with no warranty of any
+// type, including any warranty for fitness for any purpose. RTI is under no
+// obligation to maintain or support the software. RTI shall not be liable for
+// any incidental or consequential damages arising out of the use or inability
+// to use the software.
+
+#ifndef BACKPRESSURE_WRITER_H
+#define BACKPRESSURE_WRITER_H
+
+#include <cstdint>
+#include <iostream>
+#include <memory>
+#include <string>
+
+#include "rti_me_c.h"
+#include "example.h"
+#include "exampleSupport.h"
+
+#include "common_config.h"
+
+// What to do with a sample the DataWriter has no room for
+enum BackpressurePolicy {
+    // let the write block for up to the reliability max_blocking_time
+    BACKPRESSURE_BLOCK,
+    // discard the sample being written
+    BACKPRESSURE_DROP_NEWEST,
+    // stage it, discarding the oldest staged sample when staging is full
+    BACKPRESSURE_DROP_OLDEST,
+    // stage it, replacing any staged sample with the same id
+    BACKPRESSURE_COALESCE
+};
+
+// "block", "drop_newest", "drop_oldest" or "coalesce"
+bool parse_backpressure_policy(
+        const std::string &text,
+        BackpressurePolicy *policy);
+const char *backpressure_policy_name(BackpressurePolicy policy);
+
+// Write front-end for a reliable my_type DataWriter that never blocks the
+// caller (except with BACKPRESSURE_BLOCK). Run the DataWriter with a
+// max_blocking_time of zero: a write that finds the history full then
+// fails at once with TIMEOUT or OUT_OF_RESOURCES, and the policy decides
+// what happens to the sample.
+//
+// Staged samples are kept in a FIFO sized at construction and copied in
+// place, so backpressure never allocates. Connext Micro has no callback
+// for "the writer freed space", so every write() first retries the staged
+// samples, oldest first, until the writer pushes back again; a new sample
+// queues behind them while any remain. With BACKPRESSURE_COALESCE there is
+// at most one staged sample per id, so a slow reader costs the latest
+// value of each key rather than a growing backlog.
+//
+// Not thread-safe: use it from the one thread that writes.
+class BackpressureWriter {
+public:
+    enum Result {
+        RESULT_WRITTEN,
+        RESULT_STAGED,
+        RESULT_DROPPED,
+        RESULT_FAILED
+    };
+
+    BackpressureWriter(
+            my_typeDataWriter *writer,
+            BackpressurePolicy policy,
+            std::size_t staging_capacity,
+            bool monotonic_timestamps = false);
+    BackpressureWriter(const BackpressureWriter &) = delete;
+    BackpressureWriter &operator=(const BackpressureWriter &) = delete;
+
+    BackpressurePolicy policy() const { return policy_; }
+
+    Result write(const my_type &sample);
+
+    // write staged samples until the writer is full again; returns how
+    // many are still staged
+    std::size_t flush();
+
+    std::size_t staged() const { return count_; }
+    // samples the DataWriter accepted, directly or flushed from staging
+    std::uint64_t written() const { return written_ + flushed_; }
+    // writes that found the DataWriter full (TIMEOUT/OUT_OF_RESOURCES)
+    std::uint64_t writer_full() const { return backpressure_; }
+    std::uint64_t dropped() const
+    {
+        return dropped_newest_ + dropped_oldest_;
+    }
+    std::uint64_t failed() const { return failed_; }
+
+    void print_stats(std::ostream &os) const;
+
+private:
+    struct StagedSample {
+        DDS_Long id;
+        char msg[k_my_type_msg_max_length + 1];
+    };
+
+    static bool is_backpressure(DDS_ReturnCode_t retcode)
+    {
+        return retcode == DDS_RETCODE_TIMEOUT ||
+                retcode == DDS_RETCODE_OUT_OF_RESOURCES;
+    }
+
+    Result stage(const my_type &sample);
+    DDS_ReturnCode_t write_now(const my_type *sample);
+    StagedSample &at(std::size_t index)
+    {
+        return staging_[(head_ + index) % capacity_];
+    }
+
+    my_typeDataWriter *writer_;
+    const BackpressurePolicy policy_;
+    const std::size_t capacity_;
+    // stamp samples from CLOCK_MONOTONIC rather than the middleware's clock
+    const bool monotonic_timestamps_;
+    std::unique_ptr<StagedSample[]> staging_;
+    std::size_t head_;
+    std::size_t count_;
+    // staged samples are written from here, not from the caller's sample;
+    // its msg points at scratch_msg_ (Cert has no my_type_delete)
+    my_type scratch_;
+    char scratch_msg_[k_my_type_msg_max_length + 1];
+
+    std::uint64_t written_;
+    std::uint64_t backpressure_;
+    std::uint64_t staged_total_;
+    std::uint64_t flushed_;
+    std::uint64_t coalesced_;
+    std::uint64_t dropped_newest_;
+    std::uint64_t dropped_oldest_;
+    std::uint64_t failed_;
+};
+
+#endif
@@ -0,0 +1,171 @@
+// (c) Copyright, Real-Time Innovations, 2021.  All rights reserved.
+// RTI grants Licensee a license to use, modify, compile, and create derivative
+// works of the software solely for use with RTI Connext DDS. Licensee may
+// redistribute copies of the software provided that all such copies are subject
+// to this license. The software is provided "as is", with no warranty of any
+// type, including any warranty for fitness for any purpose. RTI is under no
+// obligation to maintain or support the software. RTI shall not be liable for
+// any incidental or consequential damages arising out of the use or inability
+// to use the software.
+
+#include "batch_accumulator.h"
+
+#include <cstring>
+
+#include "latency_stats.h"
+
+namespace {
+
+void write_u32(DDS_Octet *p, std::uint32_t value)
+{
+    p[0] = static_cast<DDS_Octet>(value);
+    p[1] = static_cast<DDS_Octet>(value >> 8);
+    p[2] = static_cast<DDS_Octet>(value >> 16);
+    p[3] = static_cast<DDS_Octet>(value >> 24);
+}
+
+}  // namespace
+
+BatchAccumulator::BatchAccumulator(
+        my_type_batchDataWriter *writer,
+        std::size_t max_records,
+        std::size_t max_bytes,
+        std::int64_t max_delay_ns,
+        bool monotonic_timestamps)
+    : writer_(writer),
+      max_records_(max_records > 0 ? max_records : 1),
+      max_bytes_(max_bytes < MY_TYPE_BATCH_MAX_BYTES
+              ? max_bytes : MY_TYPE_BATCH_MAX_BYTES),
+      max_delay_ns_(max_delay_ns),
+      monotonic_timestamps_(monotonic_timestamps),
+      batch_(NULL),
+      buffer_(NULL),
+      bytes_(0),
+      count_(0),
+      first_ns_(0),
+      batches_(0),
+      records_written_(0),
+      records_failed_(0),
+      flushed_full_(0),
+      flushed_size_(0),
+      flushed_delay_(0)
+{
+    if (writer_ == NULL) {
+        return;
+    }
+    // under RTI_CERT there is no my_type_batch_delete; it lives as long
+    // as the process
+    batch_ = my_type_batch_create();
+    if (batch_ == NULL) {
+        std::cout << "ERROR: failed my_type_batch_create" << std::endl;
+        return;
+    }
+    buffer_ = DDS_OctetSeq_get_contiguous_buffer(&batch_->records);
+}
+
+bool BatchAccumulator::add(const my_type &sample)
+{
+    auto length = std::strlen(sample.msg);
+    if (length > k_my_type_msg_max_length) {
+        length = k_my_type_msg_max_length;
+    }
+    auto record_bytes = k_batch_record_header + length + 1;
+    auto now_ns = monotonic_now_ns();
+    auto ok = true;
+    if (count_ > 0 && bytes_ + record_bytes > max_bytes_) {
+        ++flushed_size_;
+        ok = write_batch(now_ns);
+    }
+
+    if (count_ == 0) {
+        first_ns_ = now_ns;
+    }
+    auto record = buffer_ + bytes_;
+    write_u32(record, static_cast<std::uint32_t>(sample.id));
+    write_u32(record + 4,
+            static_cast<std::uint32_t>((now_ns - first_ns_) / 1000));
+    record[8] = static_cast<DDS_Octet>(length + 1);
+    record[9] = static_cast<DDS_Octet>((length + 1) >> 8);
+    std::memcpy(record + k_batch_record_header, sample.msg, length);
+    record[k_batch_record_header + length] = '\0';
+    bytes_ += record_bytes;
+    ++count_;
+
+    if (count_ >= max_records_) {
+        ++flushed_full_;
+        return write_batch(now_ns) && ok;
+    }
+    if (now_ns - first_ns_ >= max_delay_ns_) {
+        ++flushed_delay_;
+        return write_batch(now_ns) && ok;
+    }
+    return ok;
+}
+
+bool BatchAccumulator::poll()
+{
+    if (count_ == 0) {
+        return true;
+    }
+    auto now_ns = monotonic_now_ns();
+    if (now_ns - first_ns_ < max_delay_ns_) {
+        return true;
+    }
+    ++flushed_delay_;
+    return write_batch(now_ns);
+}
+
+bool BatchAccumulator::flush()
+{
+    return count_ == 0 || write_batch(monotonic_now_ns());
+}
+
+bool BatchAccumulator::write_batch(std::int64_t now_ns)
+{
+    batch_->count = count_;
+    batch_->span_us = static_cast<CDR_UnsignedLong>(
+            (now_ns - first_ns_) / 1000);
+    DDS_ReturnCode_t retcode;
+    if (!DDS_OctetSeq_set_length(
+                &batch_->records,
+                static_cast<DDS_Long>(bytes_))) {
+        retcode = DDS_RETCODE_ERROR;
+    } else if (monotonic_timestamps_) {
+        auto now = ns_to_dds_time(now_ns);
+        retcode = my_type_batchDataWriter_write_w_timestamp(
+                writer_,
+                batch_,
+                &DDS_HANDLE_NIL,
+                &now);
+    } else {
+        retcode = my_type_batchDataWriter_write(
+                writer_,
+                batch_,
+                &DDS_HANDLE_NIL);
+    }
+
+    auto written = retcode == DDS_RETCODE_OK;
+    if (written) {
+        ++batches_;
+        records_written_ += count_;
+    } else {
+        records_failed_ += count_;
+    }
+    bytes_ = 0;
+    count_ = 0;
+    return written;
+}
+
+void BatchAccumulator::print_stats(std::ostream &os) const
+{
+    os << "batching: batches = " << batches_
+            << ", records = " << records_written_
+            << ", records/batch = "
+            << (batches_ > 0
+                    ? static_cast<double>(records_written_) / batches_ : 0.0)
+            << ", full = " << flushed_full_
+            << ", size = " << flushed_size_
+            << ", delay = " << flushed_delay_
+            << ", failed records = " << records_failed_
+            << ", still batched = " << count_ << std::endl;
+}
@@ -0,0 +1,175 @@
+// (c) Copyright, Real-Time Innovations, 2021.  All rights reserved.
+// RTI grants Licensee a license to use, modify, compile, and create derivative
+// works of the software solely for use with RTI Connext DDS. Licensee may
+// redistribute copies of the software provided that all such copies are subject
+// to this license. The software is provided "as is", with no warranty of any
+// type, including any warranty for fitness for any purpose. RTI is under no
+// obligation to maintain or support the software. RTI shall not be liable for
+// any incidental or consequential damages arising out of the use or inability
+// to use the software.
+
+#ifndef BATCH_ACCUMULATOR_H
+#define BATCH_ACCUMULATOR_H
+
+#include <cstddef>
+#include <cstdint>
+#include <iostream>
+
+#include "rti_me_c.h"
+#include "example.h"
+#include "sample_batch.h"
+
+#include "common_config.h"
+
+// Application-level batching: many my_type samples travel as the records
+// of one my_type_batch, so a tiny sample no longer pays for its own RTPS
+// submessage, key hash and reliability bookkeeping. Each record is packed
+// into my_type_batch::records as
+//     id         4 bytes, little-endian
+//     offset_us  4 bytes, little-endian: when it was added, counted from
+//                the batch's first record
+//     length     2 bytes, little-endian: msg bytes including the NUL
+//     msg        length bytes
+// and the batch's span_us says how long after its first record the batch
+// was written, so a record waited span_us - offset_us before it was sent.
+
+// bytes a record takes in front of its msg
+static const std::size_t k_batch_record_header = 10;
+// the largest record: a full msg and its NUL
+static const std::size_t k_batch_record_max =
+        k_batch_record_header + k_my_type_msg_max_length + 1;
+
+// Publisher side: packs samples into one batch sample and writes it when
+// the next record would not fit in max_bytes, when it holds max_records,
+// or when its first record has waited max_delay. A batch is written with a
+// blocking write; a write that fails loses its records.
+//
+// The batch sample is created once, so adding and writing never allocate.
+// Not thread-safe: use it from the one thread that writes.
+class BatchAccumulator {
+public:
+    // a NULL writer leaves batching off
+    BatchAccumulator(
+            my_type_batchDataWriter *writer,
+            std::size_t max_records,
+            std::size_t max_bytes,
+            std::int64_t max_delay_ns,
+            bool monotonic_timestamps = false);
+    BatchAccumulator(const BatchAccumulator &) = delete;
+    BatchAccumulator &operator=(const BatchAccumulator &) = delete;
+
+    bool enabled() const { return writer_ != NULL && batch_ != NULL; }
+
+    // Pack a copy of the sample, writing the batch before it if the record
+    // doesn't fit and after it if the batch is now full or old enough.
+    // False if a batch write failed.
+    bool add(const my_type &sample);
+
+    // Write the batch if its first record has waited max_delay. Call it
+    // from the publishing loop so a quiet stream still goes out on time.
+    bool poll();
+
+    // write whatever is batched now
+    bool flush();
+
+    std::uint64_t batches() const { return batches_; }
+    std::uint64_t records_written() const { return records_written_; }
+    std::uint64_t records_failed() const { return records_failed_; }
+
+    void print_stats(std::ostream &os) const;
+
+private:
+    bool write_batch(std::int64_t now_ns);
+
+    my_type_batchDataWriter *writer_;
+    const std::size_t max_records_;
+    const std::size_t max_bytes_;
+    const std::int64_t max_delay_ns_;
+    const bool monotonic_timestamps_;
+    my_type_batch *batch_;
+    DDS_Octet *buffer_;
+    std::size_t bytes_;
+    std::uint32_t count_;
+    std::int64_t first_ns_;
+
+    std::uint64_t batches_;
+    std::uint64_t records_written_;
+    std::uint64_t records_failed_;
+    std::uint64_t flushed_full_;
+    std::uint64_t flushed_size_;
+    std::uint64_t flushed_delay_;
+};
+
+// Subscriber side: walks the records of a received batch in place. Each
+// record comes out as a my_type whose msg points into the batch, so it is
+// only valid until the loan is returned and must not be written to.
+//
+//     BatchRecords records(*batch);
+//     my_type record;
+//     std::int64_t waited_ns;
+//     while (records.next(&record, &waited_ns)) { ... }
+class BatchRecords {
+public:
+    explicit BatchRecords(const my_type_batch &batch)
+        : data_(DDS_OctetSeq_get_contiguous_buffer(&batch.records)),
+          size_(static_cast<std::size_t>(
+                  DDS_OctetSeq_get_length(&batch.records))),
+          pos_(0),
+          remaining_(batch.count),
+          span_us_(batch.span_us),
+          malformed_(false)
+    {
+    }
+
+    // The next record and how long it waited in the publisher's batch;
+    // false at the end, or at a record that runs past the batch or whose
+    // msg is not terminated (see malformed())
+    bool next(my_type *record, std::int64_t *waited_ns)
+    {
+        if (remaining_ == 0) {
+            return false;
+        }
+        if (data_ == NULL || size_ - pos_ < k_batch_record_header) {
+            malformed_ = true;
+            return false;
+        }
+        const DDS_Octet *header = data_ + pos_;
+        auto offset_us = read_u32(header + 4);
+        std::size_t length = header[8] | (header[9] << 8);
+        pos_ += k_batch_record_header;
+        if (length == 0 || length > size_ - pos_ ||
+                data_[pos_ + length - 1] != '\0') {
+            malformed_ = true;
+            return false;
+        }
+        record->id = static_cast<DDS_Long>(read_u32(header));
+        // CDR_String is not const, but the msg is only read
+        record->msg = reinterpret_cast<char *>(
+                const_cast<DDS_Octet *>(data_ + pos_));
+        *waited_ns = offset_us < span_us_
+                ? static_cast<std::int64_t>(span_us_ - offset_us) * 1000 : 0;
+        pos_ += length;
+        --remaining_;
+        return true;
+    }
+
+    bool malformed() const { return malformed_; }
+
+private:
+    static std::uint32_t read_u32(const DDS_Octet *p)
+    {
+        return static_cast<std::uint32_t>(p[0]) |
+                static_cast<std::uint32_t>(p[1]) << 8 |
+                static_cast<std::uint32_t>(p[2]) << 16 |
+                static_cast<std::uint32_t>(p[3]) << 24;
+    }
+
+    const DDS_Octet *data_;
+    std::size_t size_;
+    std::size_t pos_;
+    std::uint32_t remaining_;
+    std::uint32_t span_us_;
+    bool malformed_;
+};
+
+#endif
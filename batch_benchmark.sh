@@ -0,0 +1,63 @@
+#!/bin/bash
+# (c) Copyright, Real-Time Innovations, 2021.  All rights reserved.
+# RTI grants Licensee a license to use, modify, compile, and create derivative
+# works of the software solely for use with RTI Connext DDS. Licensee may
+# redistribute copies of the software provided that all such copies are subject
+# to this license. The software is provided "as is", with no warranty of any
+# type, including any warranty for fitness for any purpose. RTI is under no
+# obligation to maintain or support the software. RTI shall not be liable for
+# any incidental or consequential damages arising out of the use or inability
+# to use the software.
+
+
+# Throughput and latency of small samples as the batch size grows. For each
+# size in BATCH_SIZES, runs benchmark_runner.sh (one publisher, one
+# subscriber) with batch.max_records set to it, then prints one line per
+# size: samples written and delivered per second, loss, the latency p50/p99
+# (which includes the time a sample waited in its batch) and both
+# processes' CPU use. Size 0 runs without batching, as the reference.
+#
+#     ./batch_benchmark.sh objs/x64Linux4gcc7.3.0_cert
+#
+# Environment: BATCH_SIZES (default "0 1 4 16 64 256"), MAX_DELAY_US (the
+# batch.max_delay_us, default 1000), STREAMS (the schedule.streams value,
+# default "20000:1"), PAYLOAD (publisher.payload_bytes, default 0),
+# DURATION (seconds per size, default 10), CORES, SETTINGS and CONFIG as
+# for benchmark_runner.sh.
+
+set -u
+
+BIN_DIR=${1:-objs/${RTIME_TARGET_NAME:-x64Linux4gcc7.3.0_cert}}
+BATCH_SIZES=${BATCH_SIZES:-"0 1 4 16 64 256"}
+MAX_DELAY_US=${MAX_DELAY_US:-1000}
+LOG_DIR=$(mktemp -d /tmp/batch_benchmark.XXXXXX)
+
+source "$(dirname "$0")/benchmark_common.sh"
+require_binaries
+
+printf "%-6s %12s %12s %8s %9s %9s %8s %8s\n" batch written/s \
+        delivered/s loss% p50_us p99_us pub_cpu% sub_cpu%
+for size in $BATCH_SIZES; do
+    settings="${SETTINGS:-} subscriber.min_samples_per_take=1"
+    if [ "$size" -gt 0 ]; then
+        # max_bytes as large as the type allows, so max_records decides
+        settings+=" batch.enabled=true batch.max_records=$size"
+        settings+=" batch.max_bytes=8192 batch.max_delay_us=$MAX_DELAY_US"
+    fi
+    report=$LOG_DIR/batch_$size.txt
+    if ! run_point "batch_$size" "${STREAMS:-"20000:1"}" "${PAYLOAD:-0}" \
+            "$settings"; then
+        echo "ERROR: no report for batch size $size, see $LOG_DIR"
+        continue
+    fi
+    printf "%-6s %12s %12s %8s %9s %9s %8s %8s\n" \
+            "$([ "$size" -gt 0 ] && echo "$size" || echo off)" \
+            "$(report_value "$report" written_per_s)" \
+            "$(report_value "$report" delivered_per_s)" \
+            "$(report_value "$report" loss_pct)" \
+            "$(report_value "$report" latency_p50_us)" \
+            "$(report_value "$report" latency_p99_us)" \
+            "$(report_value "$report" publisher_cpu_pct)" \
+            "$(report_value "$report" subscriber_cpu_pct)"
+done
+echo "logs in $LOG_DIR"
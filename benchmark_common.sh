@@ -0,0 +1,57 @@
+# (c) Copyright, Real-Time Innovations, 2021.  All rights reserved.
+# RTI grants Licensee a license to use, modify, compile, and create derivative
+# works of the software solely for use with RTI Connext DDS. Licensee may
+# redistribute copies of the software provided that all such copies are subject
+# to this license. The software is provided "as is", with no warranty of any
+# type, including any warranty for fitness for any purpose. RTI is under no
+# obligation to maintain or support the software. RTI shall not be liable for
+# any incidental or consequential damages arising out of the use or inability
+# to use the software.
+
+# Helpers shared by the benchmark scripts. Source it once BIN_DIR (and, for
+# run_point, LOG_DIR) is set:
+#
+#     source "$(dirname "$0")/benchmark_common.sh"
+#     require_binaries
+
+RUNNER=$(dirname "${BASH_SOURCE[0]}")/benchmark_runner.sh
+
+# exit unless BIN_DIR holds both applications
+require_binaries() {
+    if [ ! -x "$BIN_DIR/example_publisher" ] ||
+            [ ! -x "$BIN_DIR/example_subscriber" ]; then
+        echo "ERROR: example_publisher/example_subscriber not found in" \
+                "$BIN_DIR"
+        exit 1
+    fi
+}
+
+# one value from a benchmark_runner.sh report
+report_value() {
+    awk -v key=$2 '$1 == key { print $3 }' "$1"
+}
+
+# user + system CPU ticks used so far by a process
+cpu_ticks() {
+    awk '{ print $14 + $15 }' "/proc/$1/stat" 2>/dev/null || echo 0
+}
+
+# One point of a sweep: benchmark_runner.sh with one publisher and one
+# subscriber for DURATION seconds (default 10) on CORES, with the given
+# schedule.streams, publisher.payload_bytes and settings. The report goes
+# to $LOG_DIR/NAME.txt and the output to $LOG_DIR/NAME.log; fails if there
+# is no report.
+#
+#     run_point NAME STREAMS PAYLOAD SETTINGS
+run_point() {
+    PUBLISHERS=1 SUBSCRIBERS=1 STREAMS="$2" PAYLOAD="$3" \
+            DURATION=${DURATION:-10} CORES=${CORES:-} \
+            SETTINGS="$4" REPORT="$LOG_DIR/$1.txt" \
+            "$RUNNER" "$BIN_DIR" > "$LOG_DIR/$1.log" 2>&1
+    [ -s "$LOG_DIR/$1.txt" ]
+}
+
+# the stats file the subscriber of a run_point wrote
+subscriber_stats() {
+    echo "$(sed -n 's/^logs in //p' "$LOG_DIR/$1.log")/sub_0_0.stats"
+}
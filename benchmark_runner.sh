@@ -0,0 +1,267 @@
+#!/bin/bash
+# (c) Copyright, Real-Time Innovations, 2021.  All rights reserved.
+# RTI grants Licensee a license to use, modify, compile, and create derivative
+# works of the software solely for use with RTI Connext DDS. Licensee may
+# redistribute copies of the software provided that all such copies are subject
+# to this license. The software is provided "as is", with no warranty of any
+# type, including any warranty for fitness for any purpose. RTI is under no
+# obligation to maintain or support the software. RTI shall not be liable for
+# any incidental or consequential damages arising out of the use or inability
+# to use the software.
+
+# Run PUBLISHERS example_publisher processes, each with SUBSCRIBERS
+# example_subscriber processes, on this host for DURATION seconds. Every
+# publisher and its subscribers get a domain of their own (DOMAIN_BASE + n),
+# so the groups don't match each other. Each process writes its totals to a
+# report.stats_output file; this script merges them into one report
+# (throughput, loss, latency percentiles, CPU, peak RSS), prints it, and
+# compares it with a baseline report if one is given.
+#
+#     ./benchmark_runner.sh objs/x64Linux4gcc7.3.0_cert
+#     BASELINE=baseline.txt ./benchmark_runner.sh objs/x64Linux4gcc7.3.0_cert
+#
+# Environment:
+#   PUBLISHERS   publisher processes (default 1)
+#   SUBSCRIBERS  subscriber processes per publisher (default 1)
+#   STREAMS      the publishers' schedule.streams (default "1000:1")
+#   PAYLOAD      publisher.payload_bytes (default 0)
+#   DURATION     seconds to publish for (default 10)
+#   CORES        CPUs to pin the processes to, round-robin, e.g. "2 3 4 5";
+#                empty leaves placement to the scheduler
+#   SETTINGS     extra section.key=value settings for every process, e.g.
+#                "qos.reliable=false qos.history_depth=32"
+#   CONFIG       an extra --config file for every process
+#   DOMAIN_BASE  domain of the first group (default 10)
+#   REPORT       where to write the merged report (default in the log dir)
+#   BASELINE     an earlier REPORT to compare with
+#   TOLERANCE    percent a metric may get worse before it is flagged
+#                (default 10)
+#
+# The exit status is 2 if any metric regressed against BASELINE. To make a
+# baseline, keep the REPORT of a good run.
+
+set -u
+
+BIN_DIR=${1:-objs/${RTIME_TARGET_NAME:-x64Linux4gcc7.3.0_cert}}
+PUBLISHERS=${PUBLISHERS:-1}
+SUBSCRIBERS=${SUBSCRIBERS:-1}
+STREAMS=${STREAMS:-"1000:1"}
+PAYLOAD=${PAYLOAD:-0}
+DURATION=${DURATION:-10}
+CORES=${CORES:-}
+SETTINGS=${SETTINGS:-}
+DOMAIN_BASE=${DOMAIN_BASE:-10}
+TOLERANCE=${TOLERANCE:-10}
+BASELINE=${BASELINE:-}
+LOG_DIR=$(mktemp -d /tmp/benchmark_runner.XXXXXX)
+REPORT=${REPORT:-$LOG_DIR/report.txt}
+
+source "$(dirname "$0")/benchmark_common.sh"
+require_binaries
+if [ -n "$BASELINE" ] && [ ! -r "$BASELINE" ]; then
+    echo "ERROR: can't read baseline $BASELINE"
+    exit 1
+fi
+
+common_args=(--set "fanout.subscribers=$SUBSCRIBERS"
+        --set "discovery.remote_participant_allocation=$((
+                SUBSCRIBERS > 8 ? SUBSCRIBERS : 8))")
+if [ -n "${CONFIG:-}" ]; then
+    common_args+=(--config "$CONFIG")
+fi
+for setting in $SETTINGS; do
+    common_args+=(--set "$setting")
+done
+
+cores=($CORES)
+next_core=0
+# run a process in the background, pinned to the next core in CORES
+launch() {
+    local log=$1
+    shift
+    if [ ${#cores[@]} -gt 0 ]; then
+        taskset -c "${cores[$((next_core % ${#cores[@]}))]}" "$@" \
+                > "$log" 2>&1 &
+        next_core=$((next_core + 1))
+    else
+        "$@" > "$log" 2>&1 &
+    fi
+}
+
+sub_pids=()
+pub_pids=()
+for ((p = 0; p < PUBLISHERS; ++p)); do
+    domain=$((DOMAIN_BASE + p))
+    for ((k = 0; k < SUBSCRIBERS; ++k)); do
+        launch "$LOG_DIR/sub_${p}_$k.log" "$BIN_DIR/example_subscriber" \
+                "${common_args[@]}" \
+                --set "domain.id=$domain" \
+                --set "fanout.subscriber_index=$k" \
+                --set subscriber.print_samples=false \
+                --set subscriber.report_period_ms=3600000 \
+                --set "report.stats_output=$LOG_DIR/sub_${p}_$k.stats"
+        sub_pids+=($!)
+    done
+done
+for ((p = 0; p < PUBLISHERS; ++p)); do
+    launch "$LOG_DIR/pub_$p.log" "$BIN_DIR/example_publisher" \
+            "${common_args[@]}" \
+            --set "domain.id=$((DOMAIN_BASE + p))" \
+            --set "schedule.streams=$STREAMS" \
+            --set "publisher.payload_bytes=$PAYLOAD" \
+            --set "report.stats_output=$LOG_DIR/pub_$p.stats"
+    pub_pids+=($!)
+done
+
+# publish for DURATION once every publisher has matched its subscribers
+for ((p = 0; p < PUBLISHERS; ++p)); do
+    waited=0
+    while ! grep -q "^schedule:" "$LOG_DIR/pub_$p.log" &&
+            [ $waited -lt 300 ]; do
+        sleep 0.1
+        waited=$((waited + 1))
+    done
+done
+sleep "$DURATION"
+kill -INT "${pub_pids[@]}"; wait "${pub_pids[@]}"
+kill -INT "${sub_pids[@]}"; wait "${sub_pids[@]}"
+
+# merge the per-process "key = value" files into the report
+awk -v publishers=$PUBLISHERS -v subscribers=$SUBSCRIBERS \
+        -v payload=$PAYLOAD -v streams="$STREAMS" '
+    FNR == 1 { role = "" }
+    {
+        key = $1
+        sub(/^[^=]*= */, "")
+        value[FILENAME, key] = $0
+        if (key == "role") {
+            role = $0
+            files[FILENAME] = role
+        }
+    }
+    END {
+        buckets = 16
+        for (f in files) {
+            cpu = value[f, "cpu_user_s"] + value[f, "cpu_system_s"]
+            rss = value[f, "max_rss_kb"] + 0
+            if (files[f] == "publisher") {
+                ++pub_files
+                written += value[f, "written"]
+                if (value[f, "elapsed_s"] > 0) {
+                    written_rate += value[f, "written"] / value[f, "elapsed_s"]
+                }
+                elapsed += value[f, "elapsed_s"]
+                pub_cpu += cpu
+                if (rss > pub_rss) pub_rss = rss
+            } else {
+                ++sub_files
+                received += value[f, "received"]
+                # weight each take_ns_per_sample by the samples behind it
+                take_ns += value[f, "received"] * value[f, "take_ns_per_sample"]
+                n = value[f, "latency_samples"] + 0
+                count += n
+                total_us += n * value[f, "latency_avg_us"]
+                if (value[f, "latency_max_us"] + 0 > max_us) {
+                    max_us = value[f, "latency_max_us"] + 0
+                }
+                split(value[f, "latency_histogram"], h, " ")
+                for (i = 1; i <= buckets; ++i) histogram[i] += h[i]
+                sub_cpu += cpu
+                if (rss > sub_rss) sub_rss = rss
+            }
+        }
+        # same bucket bounds as LatencyStats::Snapshot::percentile_us
+        split("0.5 0.99", fractions, " ")
+        for (j = 1; j <= 2; ++j) {
+            rank = int(fractions[j] * count)
+            seen = 0
+            p[j] = max_us
+            for (i = 1; i < buckets; ++i) {
+                seen += histogram[i]
+                if (seen > rank) {
+                    bound = 2 ^ (i - 1)
+                    p[j] = bound < max_us ? bound : max_us
+                    break
+                }
+            }
+        }
+        elapsed = pub_files ? elapsed / pub_files : 0
+        expected = written * subscribers
+        loss = expected > 0 ? 100 * (expected - received) / expected : 0
+        if (loss < 0) loss = 0
+
+        printf "publishers = %d\n", publishers
+        printf "subscribers_per_publisher = %d\n", subscribers
+        printf "streams = %s\n", streams
+        printf "payload_bytes = %d\n", payload
+        printf "stats_files = %d\n", pub_files + sub_files
+        printf "elapsed_s = %.2f\n", elapsed
+        printf "written_per_s = %.0f\n", written_rate
+        printf "delivered_per_s = %.0f\n",
+                (elapsed > 0 ? received / elapsed : 0)
+        printf "loss_pct = %.3f\n", loss
+        printf "latency_avg_us = %.1f\n", count ? total_us / count : 0
+        printf "latency_p50_us = %.1f\n", p[1]
+        printf "latency_p99_us = %.1f\n", p[2]
+        printf "latency_max_us = %.1f\n", max_us
+        printf "take_ns_per_sample = %.1f\n",
+                (received > 0 ? take_ns / received : 0)
+        printf "publisher_cpu_pct = %.1f\n",
+                (elapsed > 0 ? 100 * pub_cpu / elapsed : 0)
+        printf "subscriber_cpu_pct = %.1f\n",
+                (elapsed > 0 ? 100 * sub_cpu / elapsed : 0)
+        printf "publisher_max_rss_kb = %d\n", pub_rss
+        printf "subscriber_max_rss_kb = %d\n", sub_rss
+    }' "$LOG_DIR"/*.stats > "$REPORT"
+
+echo "logs in $LOG_DIR"
+echo "report in $REPORT"
+expected_files=$((PUBLISHERS + PUBLISHERS * SUBSCRIBERS))
+if ! grep -q "^stats_files = $expected_files$" "$REPORT"; then
+    echo "WARNING: not every process wrote its stats, see the logs"
+fi
+
+if [ -z "$BASELINE" ]; then
+    cat "$REPORT"
+    exit 0
+fi
+
+# + higher is better, - lower is better; the rest is just printed
+awk -v tolerance=$TOLERANCE '
+    BEGIN {
+        split("written_per_s:+ delivered_per_s:+ loss_pct:- " \
+                "latency_avg_us:- latency_p50_us:- latency_p99_us:- " \
+                "latency_max_us:- take_ns_per_sample:- " \
+                "publisher_cpu_pct:- subscriber_cpu_pct:- " \
+                "publisher_max_rss_kb:- subscriber_max_rss_kb:-", list, " ")
+        for (i in list) {
+            split(list[i], parts, ":")
+            direction[parts[1]] = parts[2]
+        }
+    }
+    {
+        key = $1
+        sub(/^[^=]*= */, "")
+    }
+    FNR == NR { baseline[key] = $0; next }
+    {
+        if (!(key in direction) || !(key in baseline)) {
+            printf "%-24s %14s\n", key, $0
+            next
+        }
+        old = baseline[key] + 0
+        new = $0 + 0
+        change = old != 0 ? 100 * (new - old) / old : (new != 0 ? 100 : 0)
+        worse = direction[key] == "+" ? -change : change
+        status = worse > tolerance ? "REGRESSION" : "ok"
+        if (status != "ok") ++regressions
+        printf "%-24s %14s %14s %+8.1f%%  %s\n", key, $0, baseline[key],
+                change, status
+    }
+    END {
+        if (regressions) {
+            printf "%d metric(s) regressed by more than %s%%\n",
+                    regressions, tolerance
+            exit 2
+        }
+    }' "$BASELINE" "$REPORT"
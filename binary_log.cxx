@@ -0,0 +1,223 @@
+// (c) Copyright, Real-Time Innovations, 2021.  All rights reserved.
+// RTI grants Licensee a license to use, modify, compile, and create derivative
+// works of the software solely for use with RTI Connext DDS. Licensee may
+// redistribute copies of the software provided that all such copies are subject
+// to this license. The software is provided "as is", with no warranty of any
+// type, including any warranty for fitness for any purpose. RTI is under no
+// obligation to maintain or support the software. RTI shall not be liable for
+// any incidental or consequential damages arising out of the use or inability
+// to use the software.
+
+#include "binary_log.h"
+
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace {
+
+// how often the background thread looks for new records
+const std::chrono::milliseconds k_poll_period(2);
+
+// rings the BinaryLogger allocates up front: main's, the DDS receive and
+// event threads' and a few spare
+const std::size_t k_preallocated_rings = 16;
+
+// A ring the page-touched way a log statement expects it
+binary_log::Ring *new_ring()
+{
+    auto ring = new binary_log::Ring();
+    // touch every page now rather than on the thread's first few hundred
+    // log statements
+    std::memset(ring->records, 0, sizeof(ring->records));
+    return ring;
+}
+
+// The registry and its rings are never freed: DDS receive threads are not
+// joined and may still log while static destructors run at exit, so a
+// ring must stay valid for as long as the process does.
+struct RingRegistry {
+    std::mutex mutex;
+    std::vector<binary_log::Ring *> rings;
+    // allocated but not yet handed to a thread
+    std::vector<binary_log::Ring *> free_rings;
+};
+
+RingRegistry &ring_registry()
+{
+    static auto registry = new RingRegistry();
+    return *registry;
+}
+
+const char *level_prefix(binary_log::Level level)
+{
+    switch (level) {
+    case binary_log::LEVEL_ERROR:
+        return "ERROR: ";
+    case binary_log::LEVEL_WARNING:
+        return "WARNING: ";
+    default:
+        return "";
+    }
+}
+
+// Append the next argument in the record to os; false once there is none
+bool format_arg(std::ostream &os, const unsigned char **pos,
+        const unsigned char *end)
+{
+    if (*pos >= end) {
+        return false;
+    }
+    auto type = static_cast<binary_log::ArgType>(*(*pos)++);
+    switch (type) {
+    case binary_log::ARG_INT: {
+        std::int64_t value;
+        std::memcpy(&value, *pos, sizeof(value));
+        *pos += sizeof(value);
+        os << value;
+        break;
+    }
+    case binary_log::ARG_UINT: {
+        std::uint64_t value;
+        std::memcpy(&value, *pos, sizeof(value));
+        *pos += sizeof(value);
+        os << value;
+        break;
+    }
+    case binary_log::ARG_DOUBLE: {
+        double value;
+        std::memcpy(&value, *pos, sizeof(value));
+        *pos += sizeof(value);
+        os << value;
+        break;
+    }
+    case binary_log::ARG_STRING: {
+        auto text = reinterpret_cast<const char *>(*pos);
+        os << text;
+        *pos += std::strlen(text) + 1;
+        break;
+    }
+    default:
+        *pos = end;
+        return false;
+    }
+    return true;
+}
+
+void format_record(std::ostream &os, const binary_log::Record &record)
+{
+    const unsigned char *pos = record.args;
+    const unsigned char *end = record.args + record.args_size;
+    os << level_prefix(record.format->level);
+    for (const char *c = record.format->text; *c != '\0'; ++c) {
+        if (c[0] == '{' && c[1] == '}' && format_arg(os, &pos, end)) {
+            ++c;
+        } else {
+            os << *c;
+        }
+    }
+    os << '\n';
+}
+
+// Move every committed record out of the rings, oldest first. Returns the
+// number of records dropped because a ring was full since the last call.
+std::uint64_t collect(
+        std::vector<binary_log::Record> *records,
+        std::uint64_t *dropped_total)
+{
+    auto &registry = ring_registry();
+    std::lock_guard<std::mutex> lock(registry.mutex);
+    std::uint64_t dropped = 0;
+    for (auto ring : registry.rings) {
+        auto head = ring->head.load(std::memory_order_acquire);
+        auto tail = ring->tail.load(std::memory_order_relaxed);
+        for (; tail < head; ++tail) {
+            records->push_back(
+                    ring->records[tail % binary_log::k_ring_records]);
+        }
+        ring->tail.store(tail, std::memory_order_release);
+        dropped += ring->dropped.load(std::memory_order_relaxed);
+    }
+    std::stable_sort(records->begin(), records->end(),
+            [](const binary_log::Record &a, const binary_log::Record &b) {
+                return a.timestamp_ns < b.timestamp_ns;
+            });
+    auto new_drops = dropped - *dropped_total;
+    *dropped_total = dropped;
+    return new_drops;
+}
+
+}  // namespace
+
+binary_log::Ring *binary_log::register_thread_ring()
+{
+    auto &registry = ring_registry();
+    std::lock_guard<std::mutex> lock(registry.mutex);
+    Ring *ring;
+    if (!registry.free_rings.empty()) {
+        ring = registry.free_rings.back();
+        registry.free_rings.pop_back();
+    } else {
+        ring = new_ring();
+    }
+    registry.rings.push_back(ring);
+    return ring;
+}
+
+BinaryLogger::BinaryLogger()
+    : stop_(false)
+{
+    // before any DDS thread exists, so their first log statements only
+    // take a ring from the free list
+    auto &registry = ring_registry();
+    {
+        std::lock_guard<std::mutex> lock(registry.mutex);
+        registry.rings.reserve(k_preallocated_rings * 2);
+        while (registry.free_rings.size() < k_preallocated_rings) {
+            registry.free_rings.push_back(new_ring());
+        }
+    }
+    thread_ = std::thread(&BinaryLogger::run, this);
+}
+
+BinaryLogger::~BinaryLogger()
+{
+    stop_.store(true, std::memory_order_release);
+    thread_.join();
+}
+
+void BinaryLogger::run()
+{
+    std::vector<binary_log::Record> records;
+    records.reserve(binary_log::k_ring_records);
+    std::uint64_t dropped_total = 0;
+    std::ostringstream text;
+    for (;;) {
+        // read the flag first so the last pass sees everything logged
+        // before the destructor was called
+        auto stopping = stop_.load(std::memory_order_acquire);
+        records.clear();
+        auto dropped = collect(&records, &dropped_total);
+        if (!records.empty() || dropped > 0) {
+            text.str(std::string());
+            for (const auto &record : records) {
+                format_record(text, record);
+            }
+            if (dropped > 0) {
+                text << "WARNING: " << dropped
+                        << " log messages dropped (ring full)\n";
+            }
+            auto out = text.str();
+            std::cout.write(out.data(), out.size());
+            std::cout.flush();
+        }
+        if (stopping) {
+            break;
+        }
+        std::this_thread::sleep_for(k_poll_period);
+    }
+}
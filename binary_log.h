@@ -0,0 +1,291 @@
+// (c) Copyright, Real-Time Innovations, 2021.  All rights reserved.
+// RTI grants Licensee a license to use, modify, compile, and create derivative
+// works of the software solely for use with RTI Connext DDS. Licensee may
+// redistribute copies of the software provided that all such copies are subject
+// to this license. The software is provided "as is", with no warranty of any
+// type, including any warranty for fitness for any purpose. RTI is under no
+// obligation to maintain or support the software. RTI shall not be liable for
+// any incidental or consequential damages arising out of the use or inability
+// to use the software.
+
+#ifndef BINARY_LOG_H
+#define BINARY_LOG_H
+
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <ctime>
+#include <thread>
+#include <type_traits>
+
+// Logging for the write and take paths, where a std::cout line (stream
+// lock, formatting, flush, write system call) costs more than the work
+// being logged.
+//
+//     EXAMPLE_LOG_ERROR("failed to take data, retcode = {}", retcode);
+//     EXAMPLE_LOG_INFO("Wrote sample {}", i);
+//
+// A log statement stores a binary record in its thread's ring: the address of
+// the statement's static format (its id), a CLOCK_MONOTONIC timestamp and the
+// arguments. Strings are copied, so loaned samples can be returned right after.
+// There is no lock and no system call; a full ring drops the record and counts
+// it. A thread's first statement takes a ring from those the BinaryLogger
+// allocated up front, under a lock; only a thread beyond those allocates one
+// (about 256 KB) there. Rings are never freed. A background thread, owned by a
+// BinaryLogger in main(), formats the records in timestamp order and prints
+// them to std::cout exactly as the old messages were, "ERROR: " prefix
+// included.
+//
+// The format must be a string literal; "{}" is replaced by the next
+// argument (integers, floating point, enums and C strings). Statements
+// below EXAMPLE_LOG_LEVEL (0 error, 1 warning, 2 info, 3 debug; CMake
+// option EXAMPLE_LOG_LEVEL) are compiled out.
+
+#ifndef EXAMPLE_LOG_LEVEL
+#define EXAMPLE_LOG_LEVEL 2
+#endif
+
+namespace binary_log {
+
+enum Level {
+    LEVEL_ERROR = 0,
+    LEVEL_WARNING = 1,
+    LEVEL_INFO = 2,
+    LEVEL_DEBUG = 3
+};
+
+struct Format {
+    Level level;
+    const char *text;
+};
+
+enum ArgType : unsigned char {
+    ARG_INT,
+    ARG_UINT,
+    ARG_DOUBLE,
+    ARG_STRING
+};
+
+static const unsigned int k_record_size = 256;
+// records each thread can have waiting for the background thread
+static const unsigned int k_ring_records = 1024;
+
+struct Record {
+    const Format *format;
+    std::int64_t timestamp_ns;
+    std::uint32_t args_size;
+    unsigned char args[k_record_size - 20];
+};
+
+// Single producer (the owning thread), single consumer (the background
+// thread). head and tail count records ever written and consumed. The
+// producer keeps its own copy of tail and only rereads the consumer's when
+// the ring looks full, so it rarely touches the consumer's cache line.
+struct Ring {
+    std::atomic<std::uint64_t> head{0};
+    std::uint64_t cached_tail = 0;
+    std::atomic<std::uint64_t> dropped{0};
+    char padding[64];
+    std::atomic<std::uint64_t> tail{0};
+    Record records[k_ring_records];
+};
+
+// registers the calling thread's ring on its first log statement
+Ring *register_thread_ring();
+
+inline Ring *this_thread_ring()
+{
+    static thread_local Ring *ring = NULL;
+    if (ring == NULL) {
+        ring = register_thread_ring();
+    }
+    return ring;
+}
+
+class Encoder {
+public:
+    explicit Encoder(Record *record)
+        : pos_(record->args), end_(record->args + sizeof(record->args))
+    {
+    }
+
+    void put(ArgType type, const void *value, std::size_t size)
+    {
+        if (pos_ + 1 + size > end_) {
+            return;
+        }
+        *pos_++ = type;
+        std::memcpy(pos_, value, size);
+        pos_ += size;
+    }
+
+    void put_string(const char *text)
+    {
+        if (pos_ + 2 > end_) {
+            return;
+        }
+        *pos_++ = ARG_STRING;
+        // truncate to what is left of the record, keeping the terminator
+        auto room = static_cast<std::size_t>(end_ - pos_) - 1;
+        auto length = text != NULL ? std::strlen(text) : 0;
+        if (length > room) {
+            length = room;
+        }
+        std::memcpy(pos_, text, length);
+        pos_ += length;
+        *pos_++ = '\0';
+    }
+
+    std::uint32_t size(const Record *record) const
+    {
+        return static_cast<std::uint32_t>(pos_ - record->args);
+    }
+
+private:
+    unsigned char *pos_;
+    unsigned char *end_;
+};
+
+template <typename T>
+inline typename std::enable_if<
+        std::is_integral<T>::value && std::is_signed<T>::value>::type
+encode(Encoder *encoder, T value)
+{
+    std::int64_t wide = value;
+    encoder->put(ARG_INT, &wide, sizeof(wide));
+}
+
+template <typename T>
+inline typename std::enable_if<
+        std::is_integral<T>::value && !std::is_signed<T>::value>::type
+encode(Encoder *encoder, T value)
+{
+    std::uint64_t wide = value;
+    encoder->put(ARG_UINT, &wide, sizeof(wide));
+}
+
+template <typename T>
+inline typename std::enable_if<std::is_enum<T>::value>::type
+encode(Encoder *encoder, T value)
+{
+    std::int64_t wide = static_cast<std::int64_t>(value);
+    encoder->put(ARG_INT, &wide, sizeof(wide));
+}
+
+template <typename T>
+inline typename std::enable_if<std::is_floating_point<T>::value>::type
+encode(Encoder *encoder, T value)
+{
+    double wide = value;
+    encoder->put(ARG_DOUBLE, &wide, sizeof(wide));
+}
+
+inline void encode(Encoder *encoder, const char *text)
+{
+    encoder->put_string(text);
+}
+
+inline void encode_all(Encoder *)
+{
+}
+
+template <typename T, typename... Rest>
+inline void encode_all(Encoder *encoder, const T &first, const Rest &... rest)
+{
+    encode(encoder, first);
+    encode_all(encoder, rest...);
+}
+
+// text is format->text again: EXAMPLE_LOG_ can't split the format from
+// the arguments in __VA_ARGS__, so it passes both along
+template <typename... Args>
+inline void write(const Format *format, const char *text, const Args &... args)
+{
+    (void)(text);  // to suppress -Wunused-parameter warning
+    auto ring = this_thread_ring();
+    auto head = ring->head.load(std::memory_order_relaxed);
+    if (head - ring->cached_tail >= k_ring_records) {
+        ring->cached_tail = ring->tail.load(std::memory_order_acquire);
+        if (head - ring->cached_tail >= k_ring_records) {
+            ring->dropped.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+    }
+    auto record = &ring->records[head % k_ring_records];
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    record->format = format;
+    record->timestamp_ns =
+            static_cast<std::int64_t>(now.tv_sec) * 1000000000 + now.tv_nsec;
+    Encoder encoder(record);
+    encode_all(&encoder, args...);
+    record->args_size = encoder.size(record);
+    ring->head.store(head + 1, std::memory_order_release);
+}
+
+// keeps the arguments of a compiled-out statement "used"
+template <typename... Args>
+inline void discard(const Args &...)
+{
+}
+
+}  // namespace binary_log
+
+// Owns the background thread that prints the records; create one at the top
+// of main(). Its destructor prints whatever is still buffered.
+class BinaryLogger {
+public:
+    BinaryLogger();
+    ~BinaryLogger();
+
+    BinaryLogger(const BinaryLogger &) = delete;
+    BinaryLogger &operator=(const BinaryLogger &) = delete;
+
+private:
+    void run();
+
+    std::atomic<bool> stop_;
+    std::thread thread_;
+};
+
+#define EXAMPLE_LOG_FIRST_(first, ...) first
+#define EXAMPLE_LOG_(level, ...) \
+    do { \
+        static const binary_log::Format example_log_format_ = { \
+            level, EXAMPLE_LOG_FIRST_(__VA_ARGS__, 0) \
+        }; \
+        binary_log::write(&example_log_format_, __VA_ARGS__); \
+    } while (0)
+#define EXAMPLE_LOG_DISABLED_(...) \
+    do { \
+        if (false) { \
+            binary_log::discard(__VA_ARGS__); \
+        } \
+    } while (0)
+
+#if EXAMPLE_LOG_LEVEL >= 0
+#define EXAMPLE_LOG_ERROR(...) \
+    EXAMPLE_LOG_(binary_log::LEVEL_ERROR, __VA_ARGS__)
+#else
+#define EXAMPLE_LOG_ERROR(...) EXAMPLE_LOG_DISABLED_(__VA_ARGS__)
+#endif
+#if EXAMPLE_LOG_LEVEL >= 1
+#define EXAMPLE_LOG_WARNING(...) \
+    EXAMPLE_LOG_(binary_log::LEVEL_WARNING, __VA_ARGS__)
+#else
+#define EXAMPLE_LOG_WARNING(...) EXAMPLE_LOG_DISABLED_(__VA_ARGS__)
+#endif
+#if EXAMPLE_LOG_LEVEL >= 2
+#define EXAMPLE_LOG_INFO(...) \
+    EXAMPLE_LOG_(binary_log::LEVEL_INFO, __VA_ARGS__)
+#else
+#define EXAMPLE_LOG_INFO(...) EXAMPLE_LOG_DISABLED_(__VA_ARGS__)
+#endif
+#if EXAMPLE_LOG_LEVEL >= 3
+#define EXAMPLE_LOG_DEBUG(...) \
+    EXAMPLE_LOG_(binary_log::LEVEL_DEBUG, __VA_ARGS__)
+#else
+#define EXAMPLE_LOG_DEBUG(...) EXAMPLE_LOG_DISABLED_(__VA_ARGS__)
+#endif
+
+#endif
@@ -0,0 +1,562 @@
+// (c) Copyright, Real-Time Innovations, 2021.  All rights reserved.
+// RTI grants Licensee a license to use, modify, compile, and create derivative
+// works of the software solely for use with RTI Connext DDS. Licensee may
+// redistribute copies of the software provided that all such copies are subject
+// to this license. The software is provided "as is", with no warranty of any
+// type, including any warranty for fitness for any purpose. RTI is under no
+// obligation to maintain or support the software. RTI shall not be liable for
+// any incidental or consequential damages arising out of the use or inability
+// to use the software.
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <fcntl.h>
+#include <sstream>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "examplePlugin.h"
+
+#include "cdr_recording.h"
+
+namespace {
+
+const char k_segment_magic[8] = { 'M', 'Y', 'T', 'Y', 'P', 'R', 'E', 'C' };
+const char k_index_magic[8] = { 'M', 'Y', 'T', 'Y', 'P', 'I', 'D', 'X' };
+const std::uint32_t k_recording_version = 1;
+
+static_assert(sizeof(RecordingHeader) == 64, "RecordingHeader layout");
+static_assert(sizeof(RecordHeader) == 24, "RecordHeader layout");
+static_assert(sizeof(IndexEntry) == 24, "IndexEntry layout");
+
+std::uint32_t host_is_little_endian()
+{
+    const std::uint16_t probe = 1;
+    return *reinterpret_cast<const std::uint8_t *>(&probe);
+}
+
+std::uint64_t align8(std::uint64_t n)
+{
+    return (n + 7) & ~(std::uint64_t)7;
+}
+
+std::int64_t to_ns(const DDS_Time_t &time)
+{
+    return (std::int64_t)time.sec * 1000000000 + time.nanosec;
+}
+
+std::string segment_path(
+        const std::string &prefix,
+        unsigned int segment,
+        const char *extension)
+{
+    std::ostringstream path;
+    path << prefix << "." << segment << extension;
+    return path.str();
+}
+
+void init_header(
+        RecordingHeader *header,
+        const char *magic,
+        std::uint64_t capacity)
+{
+    std::memcpy(header->magic, magic, sizeof(header->magic));
+    header->version = k_recording_version;
+    header->little_endian = host_is_little_endian();
+    header->capacity = capacity;
+    header->data_end.store(sizeof(RecordingHeader), std::memory_order_relaxed);
+    header->count.store(0, std::memory_order_release);
+}
+
+bool check_header(
+        const MappedFile &file,
+        const char *magic,
+        const std::string &path,
+        std::ostream &errors)
+{
+    auto header = reinterpret_cast<const RecordingHeader *>(file.data());
+    if (file.size() < sizeof(RecordingHeader) ||
+            std::memcmp(header->magic, magic, sizeof(header->magic)) != 0 ||
+            header->version != k_recording_version) {
+        errors << "ERROR: " << path << " is not a recording segment"
+                << std::endl;
+        return false;
+    }
+    if (header->little_endian != host_is_little_endian()) {
+        errors << "ERROR: " << path << " was recorded with a different "
+                << "byte order" << std::endl;
+        return false;
+    }
+    return true;
+}
+
+} // namespace
+
+// ---------------------------------------------------------------------------
+// MappedFile
+
+MappedFile::MappedFile(MappedFile &&other) noexcept
+    : fd_(other.fd_), data_(other.data_), size_(other.size_)
+{
+    other.fd_ = -1;
+    other.data_ = NULL;
+    other.size_ = 0;
+}
+
+MappedFile &MappedFile::operator=(MappedFile &&other) noexcept
+{
+    if (this != &other) {
+        unmap(0);
+        fd_ = other.fd_;
+        data_ = other.data_;
+        size_ = other.size_;
+        other.fd_ = -1;
+        other.data_ = NULL;
+        other.size_ = 0;
+    }
+    return *this;
+}
+
+bool MappedFile::create(const std::string &path, std::size_t size)
+{
+    fd_ = ::open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if (fd_ < 0) {
+        return false;
+    }
+    if (ftruncate(fd_, size) != 0) {
+        unmap(0);
+        return false;
+    }
+    int flags = MAP_SHARED;
+#ifdef MAP_POPULATE
+    // fault the pages in now rather than on the listener thread
+    flags |= MAP_POPULATE;
+#endif
+    auto addr = mmap(NULL, size, PROT_READ | PROT_WRITE, flags, fd_, 0);
+    if (addr == MAP_FAILED) {
+        unmap(0);
+        return false;
+    }
+    data_ = static_cast<char *>(addr);
+    size_ = size;
+    return true;
+}
+
+bool MappedFile::open_read_only(const std::string &path)
+{
+    return open_existing(path, false);
+}
+
+bool MappedFile::open_read_write(const std::string &path)
+{
+    return open_existing(path, true);
+}
+
+bool MappedFile::open_existing(const std::string &path, bool writable)
+{
+    fd_ = ::open(path.c_str(), writable ? O_RDWR : O_RDONLY);
+    if (fd_ < 0) {
+        return false;
+    }
+    struct stat file_stat;
+    if (fstat(fd_, &file_stat) != 0 || file_stat.st_size == 0) {
+        unmap(0);
+        return false;
+    }
+    auto addr = mmap(
+            NULL,
+            file_stat.st_size,
+            writable ? PROT_READ | PROT_WRITE : PROT_READ,
+            MAP_SHARED,
+            fd_,
+            0);
+    if (addr == MAP_FAILED) {
+        unmap(0);
+        return false;
+    }
+    data_ = static_cast<char *>(addr);
+    size_ = file_stat.st_size;
+    return true;
+}
+
+void MappedFile::unmap(std::size_t keep_size)
+{
+    if (data_ != NULL) {
+        msync(data_, size_, MS_SYNC);
+        munmap(data_, size_);
+        data_ = NULL;
+    }
+    if (fd_ >= 0) {
+        if (keep_size != 0 && keep_size < size_) {
+            if (ftruncate(fd_, keep_size) != 0) {
+                std::cout << "ERROR: failed to truncate recording"
+                        << std::endl;
+            }
+        }
+        ::close(fd_);
+        fd_ = -1;
+    }
+    size_ = 0;
+}
+
+// ---------------------------------------------------------------------------
+// CdrRecorder
+
+CdrRecorder::CdrRecorder()
+    : segment_size_(0),
+      max_record_size_(0),
+      index_capacity_(0),
+      segment_(0),
+      stopping_(false),
+      next_ready_(false),
+      retire_pending_(false),
+      records_(0),
+      bytes_(0),
+      failures_(0),
+      late_segment_drops_(0)
+{
+}
+
+bool CdrRecorder::open(
+        const std::string &prefix,
+        std::size_t segment_size,
+        std::ostream &errors)
+{
+    prefix_ = prefix;
+    segment_size_ = segment_size;
+    segment_.store(0, std::memory_order_relaxed);
+    max_record_size_ = sizeof(RecordHeader) +
+            my_type_get_serialized_sample_max_size(
+                    my_typeTypePlugin_get(),
+                    0,
+                    NULL);
+    if (segment_size_ < sizeof(RecordingHeader) + align8(max_record_size_)) {
+        errors << "ERROR: recording segment size is too small" << std::endl;
+        return false;
+    }
+    // Every record is at least a RecordHeader plus the 4-byte id and the
+    // 4-byte string length, so this many index entries always suffice.
+    const std::uint64_t k_min_record_size = align8(sizeof(RecordHeader) + 8);
+    index_capacity_ = segment_size_ / k_min_record_size;
+
+    if (!create_segment(0, &current_)) {
+        errors << "ERROR: failed to create recording segment "
+                << segment_path(prefix_, 0, ".rec") << std::endl;
+        return false;
+    }
+    stopping_ = false;
+    next_ready_ = false;
+    retire_pending_ = false;
+    worker_ = std::thread(&CdrRecorder::run_worker, this);
+    return true;
+}
+
+bool CdrRecorder::create_segment(unsigned int segment, Segment *files) const
+{
+    if (!files->data.create(
+                segment_path(prefix_, segment, ".rec"),
+                segment_size_) ||
+            !files->index.create(
+                    segment_path(prefix_, segment, ".idx"),
+                    sizeof(RecordingHeader) +
+                            index_capacity_ * sizeof(IndexEntry))) {
+        files->data.unmap(0);
+        files->index.unmap(0);
+        return false;
+    }
+    init_header(
+            reinterpret_cast<RecordingHeader *>(files->data.data()),
+            k_segment_magic,
+            files->data.size());
+    init_header(
+            reinterpret_cast<RecordingHeader *>(files->index.data()),
+            k_index_magic,
+            files->index.size());
+    return true;
+}
+
+void CdrRecorder::retire_segment(Segment *files)
+{
+    if (!files->data.is_open()) {
+        return;
+    }
+    auto data_header =
+            reinterpret_cast<RecordingHeader *>(files->data.data());
+    auto index_header =
+            reinterpret_cast<RecordingHeader *>(files->index.data());
+    std::size_t data_end = data_header->data_end.load(
+            std::memory_order_acquire);
+    std::size_t index_end = index_header->data_end.load(
+            std::memory_order_acquire);
+    // give back the unused, preallocated tail of both files
+    files->data.unmap(data_end);
+    files->index.unmap(index_end);
+}
+
+// On the listener thread: swap in the segment the worker prepared and give
+// it the full one. Only pointers change hands under the lock.
+bool CdrRecorder::roll_over()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (!next_ready_) {
+            return false;
+        }
+        retiring_.data = std::move(current_.data);
+        retiring_.index = std::move(current_.index);
+        current_.data = std::move(next_.data);
+        current_.index = std::move(next_.index);
+        next_ready_ = false;
+        retire_pending_ = true;
+        // under the lock: the worker names the next segment after it
+        segment_.fetch_add(1, std::memory_order_relaxed);
+    }
+    wake_.notify_one();
+    return true;
+}
+
+// Keep the next segment ready and retire full ones, off the listener
+// thread. The full segment is taken out first, so there is never more
+// than one waiting.
+void CdrRecorder::run_worker()
+{
+    std::unique_lock<std::mutex> lock(mutex_);
+    for (;;) {
+        wake_.wait(lock, [this] {
+            return stopping_ || retire_pending_ || !next_ready_;
+        });
+        Segment full;
+        if (retire_pending_) {
+            full.data = std::move(retiring_.data);
+            full.index = std::move(retiring_.index);
+            retire_pending_ = false;
+        }
+        auto prepare = !stopping_ && !next_ready_;
+        auto segment = segment_.load(std::memory_order_relaxed) + 1;
+        lock.unlock();
+
+        Segment next;
+        auto created = prepare && create_segment(segment, &next);
+        retire_segment(&full);
+
+        lock.lock();
+        if (created) {
+            next_.data = std::move(next.data);
+            next_.index = std::move(next.index);
+            next_ready_ = true;
+        }
+        if (stopping_ && !retire_pending_) {
+            return;
+        }
+        if (prepare && !created) {
+            // try again later rather than spin on a full disk
+            std::cout << "ERROR: failed to create recording segment "
+                    << segment_path(prefix_, segment, ".rec") << std::endl;
+            wake_.wait_for(lock, std::chrono::seconds(1), [this] {
+                return stopping_ || retire_pending_;
+            });
+        }
+    }
+}
+
+bool CdrRecorder::record(
+        const my_type &sample,
+        const struct DDS_SampleInfo &info)
+{
+    if (!current_.data.is_open()) {
+        return false;
+    }
+    auto header = reinterpret_cast<RecordingHeader *>(current_.data.data());
+    auto offset = header->data_end.load(std::memory_order_relaxed);
+    if (offset + max_record_size_ > current_.data.size()) {
+        if (!roll_over()) {
+            late_segment_drops_.fetch_add(1, std::memory_order_relaxed);
+            failures_.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+        header = reinterpret_cast<RecordingHeader *>(current_.data.data());
+        offset = header->data_end.load(std::memory_order_relaxed);
+    }
+
+    // serialize straight into the mapping, behind the record header
+    auto data = current_.data.data();
+    auto record = reinterpret_cast<RecordHeader *>(data + offset);
+    struct CDR_Stream_t stream;
+    if (!CDR_Stream_Initialize(
+                &stream,
+                data + offset + sizeof(RecordHeader),
+                max_record_size_ - sizeof(RecordHeader)) ||
+            !my_type_cdr_serialize(&stream, &sample, NULL)) {
+        failures_.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+    record->cdr_length = CDR_Stream_GetCurrentPositionOffset(&stream);
+    record->id = sample.id;
+    record->reception_ns = to_ns(info.reception_timestamp);
+    record->source_ns = to_ns(info.source_timestamp);
+
+    auto index_header =
+            reinterpret_cast<RecordingHeader *>(current_.index.data());
+    auto count = header->count.load(std::memory_order_relaxed);
+    auto entry = reinterpret_cast<IndexEntry *>(
+            current_.index.data() + sizeof(RecordingHeader)) + count;
+    entry->id = sample.id;
+    entry->reserved = 0;
+    entry->reception_ns = record->reception_ns;
+    entry->offset = offset;
+
+    // publish the record: data first, then the end markers
+    auto end = align8(offset + sizeof(RecordHeader) + record->cdr_length);
+    index_header->data_end.store(
+            sizeof(RecordingHeader) + (count + 1) * sizeof(IndexEntry),
+            std::memory_order_release);
+    index_header->count.store(count + 1, std::memory_order_release);
+    header->data_end.store(end, std::memory_order_release);
+    header->count.store(count + 1, std::memory_order_release);
+
+    records_.fetch_add(1, std::memory_order_relaxed);
+    bytes_.fetch_add(end - offset, std::memory_order_relaxed);
+    return true;
+}
+
+void CdrRecorder::close()
+{
+    if (worker_.joinable()) {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            stopping_ = true;
+        }
+        wake_.notify_one();
+        worker_.join();
+    }
+    retire_segment(&current_);
+    // a prepared segment that was never written would read as an empty one
+    if (next_.data.is_open()) {
+        auto segment = segment_.load(std::memory_order_relaxed) + 1;
+        next_.data.unmap(0);
+        next_.index.unmap(0);
+        unlink(segment_path(prefix_, segment, ".rec").c_str());
+        unlink(segment_path(prefix_, segment, ".idx").c_str());
+        next_ready_ = false;
+    }
+}
+
+void CdrRecorder::print_stats(std::ostream &os) const
+{
+    os << "recorder: records = " << records_.load(std::memory_order_relaxed)
+            << ", bytes = " << bytes_.load(std::memory_order_relaxed)
+            << ", segment = " << segment_.load(std::memory_order_relaxed)
+            << ", failures = " << failures_.load(std::memory_order_relaxed)
+            << " (" << late_segment_drops_.load(std::memory_order_relaxed)
+            << " waiting for the next segment)" << std::endl;
+}
+
+// ---------------------------------------------------------------------------
+// CdrReplayer
+
+bool CdrReplayer::open(const std::string &prefix, std::ostream &errors)
+{
+    for (unsigned int n = 0; ; ++n) {
+        Segment segment;
+        auto data_path = segment_path(prefix, n, ".rec");
+        auto index_path = segment_path(prefix, n, ".idx");
+        if (!segment.data.open_read_only(data_path)) {
+            break;
+        }
+        if (!segment.index.open_read_only(index_path)) {
+            errors << "ERROR: missing index " << index_path << std::endl;
+            return false;
+        }
+        if (!check_header(segment.data, k_segment_magic, data_path, errors) ||
+                !check_header(
+                        segment.index,
+                        k_index_magic,
+                        index_path,
+                        errors)) {
+            return false;
+        }
+        segments_.push_back(std::move(segment));
+    }
+    if (segments_.empty()) {
+        errors << "ERROR: no recording found at " << prefix << ".0.rec"
+                << std::endl;
+        return false;
+    }
+    return true;
+}
+
+std::vector<CdrReplayer::Position> CdrReplayer::select(
+        std::int64_t start_ms,
+        bool filter_by_id,
+        DDS_Long id) const
+{
+    std::vector<Position> positions;
+    std::int64_t start_ns = 0;
+    auto first = true;
+
+    for (std::size_t s = 0; s < segments_.size(); ++s) {
+        auto header = reinterpret_cast<const RecordingHeader *>(
+                segments_[s].index.data());
+        auto entries = reinterpret_cast<const IndexEntry *>(
+                segments_[s].index.data() + sizeof(RecordingHeader));
+        // a damaged header must not send the search past the mapping
+        auto count = std::min<std::uint64_t>(
+                header->count.load(std::memory_order_acquire),
+                (segments_[s].index.size() - sizeof(RecordingHeader))
+                        / sizeof(IndexEntry));
+        if (count == 0) {
+            continue;
+        }
+        if (first) {
+            start_ns = entries[0].reception_ns + start_ms * 1000000;
+            first = false;
+        }
+
+        // entries are in reception order, so seek to the start time with a
+        // binary search
+        auto begin = std::lower_bound(
+                entries,
+                entries + count,
+                start_ns,
+                [](const IndexEntry &entry, std::int64_t ns) {
+                    return entry.reception_ns < ns;
+                });
+        for (auto entry = begin; entry != entries + count; ++entry) {
+            if (!filter_by_id || entry->id == id) {
+                Position pos = { s, entry->offset, entry->reception_ns };
+                positions.push_back(pos);
+            }
+        }
+    }
+    return positions;
+}
+
+bool CdrReplayer::read(const Position &pos, my_type *sample) const
+{
+    const auto &data = segments_[pos.segment].data;
+    auto header = reinterpret_cast<const RecordingHeader *>(data.data());
+    auto data_end = std::min<std::uint64_t>(
+            header->data_end.load(std::memory_order_acquire),
+            data.size());
+    if (pos.offset + sizeof(RecordHeader) > data_end) {
+        return false;
+    }
+    auto record = reinterpret_cast<const RecordHeader *>(
+            data.data() + pos.offset);
+    if (pos.offset + sizeof(RecordHeader) + record->cdr_length > data_end) {
+        return false;
+    }
+
+    // the stream reads the mapped bytes in place; nothing is copied out
+    // before deserialization
+    struct CDR_Stream_t stream;
+    if (!CDR_Stream_Initialize(
+                &stream,
+                data.data() + pos.offset + sizeof(RecordHeader),
+                record->cdr_length)) {
+        return false;
+    }
+    return my_type_cdr_deserialize(&stream, sample, NULL);
+}
@@ -0,0 +1,199 @@
+// (c) Copyright, Real-Time Innovations, 2021.  All rights reserved.
+// RTI grants Licensee a license to use, modify, compile, and create derivative
+// works of the software solely for use with RTI Connext DDS. Licensee may
+// redistribute copies of the software provided that all such copies are subject
+// to this license. The software is provided "as is", with no warranty of any
+// type, including any warranty for fitness for any purpose. RTI is under no
+// obligation to maintain or support the software. RTI shall not be liable for
+// any incidental or consequential damages arising out of the use or inability
+// to use the software.
+
+#ifndef CDR_RECORDING_H
+#define CDR_RECORDING_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <iostream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "rti_me_c.h"
+#include "example.h"
+
+// A recording is a series of segment files, <prefix>.<n>.rec, each with a
+// side index <prefix>.<n>.idx. Both are preallocated to a fixed size and
+// written through a shared memory mapping, so recording a sample is a
+// serialize into mapped memory plus a few stores: no system call, no copy
+// through a user buffer. The header's data_end is advanced only after a
+// record is complete, so a reader (or a crash) never sees a partial record.
+//
+// Segment layout:
+//     RecordingHeader
+//     { RecordHeader, raw CDR of my_type (my_type_cdr_serialize), padding }*
+// Index layout:
+//     RecordingHeader
+//     IndexEntry*                  one per record, in reception order
+
+struct RecordingHeader {
+    char magic[8];
+    std::uint32_t version;
+    std::uint32_t little_endian;        // byte order of the CDR data
+    std::uint64_t capacity;             // size of the file in bytes
+    std::atomic<std::uint64_t> data_end;  // end of the last complete record
+    std::atomic<std::uint64_t> count;     // number of complete records
+    std::uint8_t reserved[24];
+};
+
+struct RecordHeader {
+    std::uint32_t cdr_length;
+    std::int32_t id;
+    std::int64_t reception_ns;          // DDS_SampleInfo::reception_timestamp
+    std::int64_t source_ns;             // DDS_SampleInfo::source_timestamp
+};
+
+struct IndexEntry {
+    std::int32_t id;
+    std::uint32_t reserved;
+    std::int64_t reception_ns;
+    std::uint64_t offset;               // of the RecordHeader in the segment
+};
+
+// A file mapped into memory in full
+class MappedFile {
+public:
+    MappedFile() : fd_(-1), data_(NULL), size_(0) {}
+    ~MappedFile() { unmap(0); }
+
+    MappedFile(MappedFile &&other) noexcept;
+    // unmaps this file first; cheap when it is not open
+    MappedFile &operator=(MappedFile &&other) noexcept;
+    MappedFile(const MappedFile &) = delete;
+    MappedFile &operator=(const MappedFile &) = delete;
+
+    // create (or replace) a file of the given size, mapped read/write
+    bool create(const std::string &path, std::size_t size);
+    // map an existing file read-only
+    bool open_read_only(const std::string &path);
+    // map an existing file read/write, to update it in place
+    bool open_read_write(const std::string &path);
+    // flush and unmap; if keep_size is non-zero the file is cut to it
+    void unmap(std::size_t keep_size);
+
+    char *data() const { return data_; }
+    std::size_t size() const { return size_; }
+    bool is_open() const { return data_ != NULL; }
+
+private:
+    bool open_existing(const std::string &path, bool writable);
+
+    int fd_;
+    char *data_;
+    std::size_t size_;
+};
+
+// Appends received samples to a recording. Only one listener thread at a
+// time calls record(); open() and close() belong to the main thread.
+//
+// The listener never makes a system call for the recorder. A worker thread
+// creates and populates the next segment ahead of time; rolling over swaps
+// it in under a short lock and hands the full segment back to the worker,
+// which flushes it to disk and trims its unused tail. If the worker has
+// not got the next segment ready in time, records are dropped and counted
+// rather than waited for.
+class CdrRecorder {
+public:
+    CdrRecorder();
+    ~CdrRecorder() { close(); }
+    CdrRecorder(const CdrRecorder &) = delete;
+    CdrRecorder &operator=(const CdrRecorder &) = delete;
+
+    bool open(
+            const std::string &prefix,
+            std::size_t segment_size,
+            std::ostream &errors);
+    bool record(const my_type &sample, const struct DDS_SampleInfo &info);
+    void close();
+
+    bool is_open() const { return current_.data.is_open(); }
+    void print_stats(std::ostream &os) const;
+
+private:
+    // a segment's data and index files
+    struct Segment {
+        MappedFile data;
+        MappedFile index;
+    };
+
+    bool create_segment(unsigned int segment, Segment *files) const;
+    // flush, trim to the complete records and unmap
+    static void retire_segment(Segment *files);
+    bool roll_over();
+    void run_worker();
+
+    std::string prefix_;
+    std::size_t segment_size_;
+    std::uint32_t max_record_size_;
+    std::uint64_t index_capacity_;
+    // the segment being written, by the listener
+    Segment current_;
+    std::atomic<unsigned int> segment_;
+
+    // shared with the worker
+    std::mutex mutex_;
+    std::condition_variable wake_;
+    bool stopping_;
+    // the segment after the current one, once the worker has created it
+    Segment next_;
+    bool next_ready_;
+    // a full segment for the worker to retire
+    Segment retiring_;
+    bool retire_pending_;
+    std::thread worker_;
+
+    std::atomic<std::uint64_t> records_;
+    std::atomic<std::uint64_t> bytes_;
+    std::atomic<std::uint64_t> failures_;
+    // records dropped because the next segment was not ready
+    std::atomic<std::uint64_t> late_segment_drops_;
+};
+
+// Reads a recording back. Segments are mapped read-only and samples are
+// deserialized straight out of the mapping.
+class CdrReplayer {
+public:
+    // a record's location in the recording
+    struct Position {
+        std::size_t segment;
+        std::uint64_t offset;
+        std::int64_t reception_ns;
+    };
+
+    bool open(const std::string &prefix, std::ostream &errors);
+
+    // Use the side indexes to list the records to replay: those received
+    // at least start_ms after the first record, optionally only for one id.
+    // Only index entries are touched, never the sample data.
+    std::vector<Position> select(
+            std::int64_t start_ms,
+            bool filter_by_id,
+            DDS_Long id) const;
+
+    // deserialize the record at pos into sample
+    bool read(const Position &pos, my_type *sample) const;
+
+    std::size_t segment_count() const { return segments_.size(); }
+
+private:
+    struct Segment {
+        MappedFile data;
+        MappedFile index;
+    };
+
+    std::vector<Segment> segments_;
+};
+
+#endif
@@ -0,0 +1,55 @@
+#!/bin/bash
+# (c) Copyright, Real-Time Innovations, 2021.  All rights reserved.
+# RTI grants Licensee a license to use, modify, compile, and create derivative
+# works of the software solely for use with RTI Connext DDS. Licensee may
+# redistribute copies of the software provided that all such copies are subject
+# to this license. The software is provided "as is", with no warranty of any
+# type, including any warranty for fitness for any purpose. RTI is under no
+# obligation to maintain or support the software. RTI shall not be liable for
+# any incidental or consequential damages arising out of the use or inability
+# to use the software.
+
+
+# Subscriber-side cost of the sample analytics (per-id counts and receive
+# rate) fed one sample at a time versus through columns. For each mode in
+# MODES, runs benchmark_runner.sh (one publisher, one subscriber) with
+# columnar.mode set to it, then prints one line per mode: samples delivered
+# per second, loss, latency p99, the subscriber's CPU use and its take
+# callback time per sample. "off" runs without analytics, as the reference.
+#
+#     ./columnar_benchmark.sh objs/x64Linux4gcc7.3.0_cert
+#
+# Environment: MODES (default "off per_sample columnar"), ROWS (the
+# columnar.rows, default 1024), STREAMS (the schedule.streams value,
+# default "20000:1"), PAYLOAD (publisher.payload_bytes, default 64),
+# DURATION (seconds per mode, default 10), CORES, SETTINGS and CONFIG as
+# for benchmark_runner.sh.
+
+set -u
+
+BIN_DIR=${1:-objs/${RTIME_TARGET_NAME:-x64Linux4gcc7.3.0_cert}}
+MODES=${MODES:-"off per_sample columnar"}
+ROWS=${ROWS:-1024}
+LOG_DIR=$(mktemp -d /tmp/columnar_benchmark.XXXXXX)
+
+source "$(dirname "$0")/benchmark_common.sh"
+require_binaries
+
+printf "%-11s %12s %8s %9s %8s %13s\n" mode delivered/s loss% p99_us \
+        sub_cpu% take_ns/sample
+for mode in $MODES; do
+    settings="${SETTINGS:-} columnar.mode=$mode columnar.rows=$ROWS"
+    report=$LOG_DIR/columnar_$mode.txt
+    if ! run_point "columnar_$mode" "${STREAMS:-"20000:1"}" \
+            "${PAYLOAD:-64}" "$settings"; then
+        echo "ERROR: no report for mode $mode, see $LOG_DIR"
+        continue
+    fi
+    printf "%-11s %12s %8s %9s %8s %13s\n" "$mode" \
+            "$(report_value "$report" delivered_per_s)" \
+            "$(report_value "$report" loss_pct)" \
+            "$(report_value "$report" latency_p99_us)" \
+            "$(report_value "$report" subscriber_cpu_pct)" \
+            "$(report_value "$report" take_ns_per_sample)"
+done
+echo "logs in $LOG_DIR"
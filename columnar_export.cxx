@@ -0,0 +1,326 @@
+// (c) Copyright, Real-Time Innovations, 2021.  All rights reserved.
+// RTI grants Licensee a license to use, modify, compile, and create derivative
+// works of the software solely for use with RTI Connext DDS. Licensee may
+// redistribute copies of the software provided that all such copies are subject
+// to this license. The software is provided "as is", with no warranty of any
+// type, including any warranty for fitness for any purpose. RTI is under no
+// obligation to maintain or support the software. RTI shall not be liable for
+// any incidental or consequential damages arising out of the use or inability
+// to use the software.
+
+#include "columnar_export.h"
+
+#include <algorithm>
+#include <cstring>
+#include <limits>
+
+#include "cyclic_scheduler.h"
+#include "latency_stats.h"
+
+namespace {
+
+// the only writer adds to an atomic counter: a load and a store, no
+// locked read-modify-write
+template <typename T>
+void add_relaxed(std::atomic<T> &counter, T value)
+{
+    counter.store(
+            counter.load(std::memory_order_relaxed) + value,
+            std::memory_order_relaxed);
+}
+
+}  // namespace
+
+SampleColumns::SampleColumns(std::size_t capacity)
+    : id(capacity),
+      msg_offset(capacity),
+      msg_length(capacity),
+      msg(capacity * (k_my_type_msg_max_length + 1)),
+      source_ns(capacity),
+      reception_ns(capacity),
+      rows(0),
+      msg_bytes(0)
+{
+}
+
+void SampleColumns::append(
+        const my_type &sample,
+        const struct DDS_SampleInfo &info)
+{
+    auto row = rows++;
+    auto length = strnlen(sample.msg, k_my_type_msg_max_length);
+    id[row] = sample.id;
+    msg_offset[row] = static_cast<std::uint32_t>(msg_bytes);
+    msg_length[row] = static_cast<std::uint32_t>(length);
+    std::memcpy(&msg[msg_bytes], sample.msg, length);
+    msg[msg_bytes + length] = '\0';
+    msg_bytes += length + 1;
+    source_ns[row] = dds_time_to_ns(info.source_timestamp);
+    reception_ns[row] = dds_time_to_ns(info.reception_timestamp);
+}
+
+SampleAnalytics::SampleAnalytics(std::size_t dense_ids)
+    : dense_ids_(dense_ids),
+      id_counts_(new std::atomic<std::uint64_t>[dense_ids]),
+      other_ids_(0),
+      rows_(0),
+      msg_bytes_(0),
+      first_reception_ns_(std::numeric_limits<std::int64_t>::max()),
+      last_reception_ns_(std::numeric_limits<std::int64_t>::min())
+{
+    for (std::size_t i = 0; i < dense_ids_; ++i) {
+        id_counts_[i].store(0, std::memory_order_relaxed);
+    }
+}
+
+void SampleAnalytics::add_rows(
+        const DDS_Long *id,
+        const std::uint32_t *msg_length,
+        const std::int64_t *reception_ns,
+        std::size_t rows)
+{
+    std::uint64_t bytes = 0;
+    for (std::size_t i = 0; i < rows; ++i) {
+        bytes += msg_length[i];
+    }
+    auto first = first_reception_ns_.load(std::memory_order_relaxed);
+    auto last = last_reception_ns_.load(std::memory_order_relaxed);
+    for (std::size_t i = 0; i < rows; ++i) {
+        first = std::min(first, reception_ns[i]);
+        last = std::max(last, reception_ns[i]);
+    }
+    // a negative id converts to a huge index and lands in "other"
+    auto dense = dense_ids_;
+    auto counts = id_counts_.get();
+    std::uint64_t other = 0;
+    for (std::size_t i = 0; i < rows; ++i) {
+        auto index = static_cast<std::size_t>(id[i]);
+        if (index < dense) {
+            add_relaxed<std::uint64_t>(counts[index], 1);
+        } else {
+            ++other;
+        }
+    }
+    add_relaxed<std::uint64_t>(other_ids_, other);
+    add_relaxed<std::uint64_t>(rows_, rows);
+    add_relaxed<std::uint64_t>(msg_bytes_, bytes);
+    first_reception_ns_.store(first, std::memory_order_relaxed);
+    last_reception_ns_.store(last, std::memory_order_relaxed);
+}
+
+void SampleAnalytics::print(std::ostream &os) const
+{
+    std::size_t ids = 0;
+    std::size_t busiest = 0;
+    std::uint64_t busiest_count = 0;
+    for (std::size_t i = 0; i < dense_ids_; ++i) {
+        auto count = id_counts_[i].load(std::memory_order_relaxed);
+        if (count > 0) {
+            ++ids;
+        }
+        if (count > busiest_count) {
+            busiest = i;
+            busiest_count = count;
+        }
+    }
+    auto rows = rows_.load(std::memory_order_relaxed);
+    auto msg_bytes = msg_bytes_.load(std::memory_order_relaxed);
+    auto span_s = rows > 1
+            ? (last_reception_ns_.load(std::memory_order_relaxed) -
+                    first_reception_ns_.load(std::memory_order_relaxed)) /
+                    1e9
+            : 0.0;
+    os << "sample analytics: rows = " << rows << ", ids = " << ids
+            << ", other ids = " << other_ids_.load(std::memory_order_relaxed)
+            << ", rows/s = " << (span_s > 0 ? (rows - 1) / span_s : 0.0)
+            << ", mean msg = "
+            << (rows > 0 ? static_cast<double>(msg_bytes) / rows : 0.0)
+            << " bytes";
+    if (ids > 0) {
+        os << ", busiest id = " << busiest << " (" << busiest_count << ")";
+    }
+    os << std::endl;
+}
+
+bool parse_columnar_mode(const std::string &text, ColumnarMode *mode)
+{
+    if (text == "off") {
+        *mode = COLUMNAR_OFF;
+    } else if (text == "per_sample") {
+        *mode = COLUMNAR_PER_SAMPLE;
+    } else if (text == "columnar") {
+        *mode = COLUMNAR_COLUMNS;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+ColumnarExporter::ColumnarExporter(
+        ColumnarMode mode,
+        std::size_t rows_per_buffer,
+        std::size_t dense_ids)
+    : mode_(mode),
+      // only the columnar mode fills the buffers
+      buffers_{
+          SampleColumns(mode == COLUMNAR_COLUMNS ? rows_per_buffer : 0),
+          SampleColumns(mode == COLUMNAR_COLUMNS ? rows_per_buffer : 0)},
+      filling_(0),
+      ready_(false),
+      consuming_(false),
+      stopping_(false),
+      blocks_(0),
+      dropped_rows_(0),
+      consume_ns_(0),
+      analytics_(mode == COLUMNAR_OFF ? 0 : dense_ids)
+{
+    if (mode_ == COLUMNAR_COLUMNS) {
+        consumer_ = std::thread(&ColumnarExporter::consume, this);
+    }
+}
+
+ColumnarExporter::~ColumnarExporter()
+{
+    stop();
+}
+
+void ColumnarExporter::append(
+        const my_type &sample,
+        const struct DDS_SampleInfo &info)
+{
+    switch (mode_) {
+    case COLUMNAR_OFF:
+        return;
+
+    case COLUMNAR_PER_SAMPLE: {
+        DDS_Long id = sample.id;
+        auto length = static_cast<std::uint32_t>(
+                strnlen(sample.msg, k_my_type_msg_max_length));
+        auto reception_ns = dds_time_to_ns(info.reception_timestamp);
+        analytics_.add_rows(&id, &length, &reception_ns, 1);
+        return;
+    }
+
+    case COLUMNAR_COLUMNS:
+        // only this thread changes filling_, so it can read it unlocked
+        if (buffers_[filling_].full()) {
+            std::lock_guard<std::mutex> lock(mutex_);
+            hand_off_locked();
+            if (buffers_[filling_].full()) {
+                ++dropped_rows_;
+                return;
+            }
+        }
+        buffers_[filling_].append(sample, info);
+        return;
+    }
+}
+
+void ColumnarExporter::end_take()
+{
+    if (mode_ == COLUMNAR_COLUMNS) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        hand_off_locked();
+    }
+}
+
+// Give the filled buffer to the consumer and take back the other one,
+// unless the consumer still has it
+void ColumnarExporter::hand_off_locked()
+{
+    if (ready_ || consuming_ || buffers_[filling_].rows == 0) {
+        return;
+    }
+    ready_ = true;
+    filling_ = 1 - filling_;
+    buffers_[filling_].clear();
+    ready_cv_.notify_one();
+}
+
+void ColumnarExporter::consume()
+{
+    std::unique_lock<std::mutex> lock(mutex_);
+    for (;;) {
+        ready_cv_.wait(lock, [this] { return ready_ || stopping_; });
+        if (!ready_) {
+            // stopping, so nothing appends any more: the rows in the
+            // buffer being filled are the last block
+            hand_off_locked();
+            if (!ready_) {
+                return;
+            }
+        }
+        ready_ = false;
+        consuming_ = true;
+        const auto &columns = buffers_[1 - filling_];
+        lock.unlock();
+
+        auto start = monotonic_now_ns();
+        analytics_.add(columns);
+        auto elapsed = monotonic_now_ns() - start;
+
+        lock.lock();
+        consuming_ = false;
+        ++blocks_;
+        consume_ns_ += elapsed;
+    }
+}
+
+void ColumnarExporter::stop()
+{
+    if (!consumer_.joinable()) {
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopping_ = true;
+        ready_cv_.notify_one();
+    }
+    // the block already handed off and then the one being filled are
+    // consumed before the thread ends
+    consumer_.join();
+}
+
+std::uint64_t ColumnarExporter::dropped_rows() const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    return dropped_rows_;
+}
+
+double ColumnarExporter::ns_per_row() const
+{
+    std::int64_t consume_ns;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        consume_ns = consume_ns_;
+    }
+    auto rows = analytics_.rows();
+    return rows > 0 ? static_cast<double>(consume_ns) / rows : 0.0;
+}
+
+void ColumnarExporter::print(std::ostream &os) const
+{
+    if (mode_ == COLUMNAR_OFF) {
+        return;
+    }
+    if (mode_ == COLUMNAR_COLUMNS) {
+        // copied, so the consumer never waits for the output
+        std::uint64_t blocks;
+        std::uint64_t dropped_rows;
+        std::int64_t consume_ns;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            blocks = blocks_;
+            dropped_rows = dropped_rows_;
+            consume_ns = consume_ns_;
+        }
+        auto rows = analytics_.rows();
+        os << "columnar export: blocks = " << blocks
+                << ", rows/block = "
+                << (blocks > 0 ? static_cast<double>(rows) / blocks : 0.0)
+                << ", consumer ns/row = "
+                << (rows > 0 ? static_cast<double>(consume_ns) / rows : 0.0)
+                << ", dropped rows = " << dropped_rows << std::endl;
+    }
+    analytics_.print(os);
+}
@@ -0,0 +1,177 @@
+// (c) Copyright, Real-Time Innovations, 2021.  All rights reserved.
+// RTI grants Licensee a license to use, modify, compile, and create derivative
+// works of the software solely for use with RTI Connext DDS. Licensee may
+// redistribute copies of the software provided that all such copies are subject
+// to this license. The software is provided "as is", with no warranty of any
+// type, including any warranty for fitness for any purpose. RTI is under no
+// obligation to maintain or support the software. RTI shall not be liable for
+// any incidental or consequential damages arising out of the use or inability
+// to use the software.
+
+#ifndef COLUMNAR_EXPORT_H
+#define COLUMNAR_EXPORT_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "rti_me_c.h"
+#include "example.h"
+
+#include "common_config.h"
+
+// Received samples as columns (structure of arrays) rather than one
+// my_type at a time, for analytics that scan many samples at once. Every
+// array is sized at construction; rows are written by index.
+struct SampleColumns {
+    std::vector<DDS_Long> id;
+    // where each msg starts in msg, and its length without the NUL
+    std::vector<std::uint32_t> msg_offset;
+    std::vector<std::uint32_t> msg_length;
+    // the msgs back to back, each NUL-terminated
+    std::vector<char> msg;
+    // DDS_SampleInfo timestamps, in ns
+    std::vector<std::int64_t> source_ns;
+    std::vector<std::int64_t> reception_ns;
+    std::size_t rows;
+    std::size_t msg_bytes;
+
+    explicit SampleColumns(std::size_t capacity);
+
+    std::size_t capacity() const { return id.size(); }
+    bool full() const { return rows == capacity(); }
+    void clear() { rows = 0; msg_bytes = 0; }
+
+    // copy one sample into the next row; the caller checks full() first
+    void append(const my_type &sample, const struct DDS_SampleInfo &info);
+};
+
+// Per-id counts, mean msg length and the receive rate over everything
+// added. The loops over a block of rows run down contiguous arrays, so the
+// compiler can vectorize all but the per-id count. Ids from 0 to
+// dense_ids - 1 are counted in a table; any other id only as "other".
+//
+// One thread at a time adds and any thread may print, without a lock: the
+// counters are atomics the adding thread updates with plain loads and
+// stores. A print while rows are being added may show some of their counts
+// but not others.
+class SampleAnalytics {
+public:
+    explicit SampleAnalytics(std::size_t dense_ids);
+
+    void add_rows(
+            const DDS_Long *id,
+            const std::uint32_t *msg_length,
+            const std::int64_t *reception_ns,
+            std::size_t rows);
+
+    void add(const SampleColumns &columns)
+    {
+        add_rows(
+                columns.id.data(),
+                columns.msg_length.data(),
+                columns.reception_ns.data(),
+                columns.rows);
+    }
+
+    std::uint64_t rows() const
+    {
+        return rows_.load(std::memory_order_relaxed);
+    }
+
+    void print(std::ostream &os) const;
+
+private:
+    const std::size_t dense_ids_;
+    std::unique_ptr<std::atomic<std::uint64_t>[]> id_counts_;
+    std::atomic<std::uint64_t> other_ids_;
+    std::atomic<std::uint64_t> rows_;
+    std::atomic<std::uint64_t> msg_bytes_;
+    std::atomic<std::int64_t> first_reception_ns_;
+    std::atomic<std::int64_t> last_reception_ns_;
+};
+
+// How the subscriber feeds SampleAnalytics
+enum ColumnarMode {
+    // not at all
+    COLUMNAR_OFF,
+    // one sample at a time, on the thread that takes
+    COLUMNAR_PER_SAMPLE,
+    // transposed into double-buffered columns for a consumer thread
+    COLUMNAR_COLUMNS
+};
+
+// "off", "per_sample" or "columnar"
+bool parse_columnar_mode(const std::string &text, ColumnarMode *mode);
+
+// The reader-side stage. The thread that takes calls append() for each
+// valid sample and end_take() after the take's loop. Neither takes a lock
+// that main() holds while it prints.
+//
+// With COLUMNAR_COLUMNS, append() fills one of two SampleColumns and
+// end_take() hands it to the consumer thread, which aggregates it while
+// the next take fills the other one. Neither call waits for the consumer:
+// while it is busy the rows keep going into the same buffer, and rows
+// that find it full are dropped and counted.
+//
+// With COLUMNAR_PER_SAMPLE, append() aggregates the sample then and
+// there, the baseline the columns are compared with.
+class ColumnarExporter {
+public:
+    ColumnarExporter(
+            ColumnarMode mode,
+            std::size_t rows_per_buffer,
+            std::size_t dense_ids);
+    ~ColumnarExporter();
+    ColumnarExporter(const ColumnarExporter &) = delete;
+    ColumnarExporter &operator=(const ColumnarExporter &) = delete;
+
+    ColumnarMode mode() const { return mode_; }
+
+    void append(const my_type &sample, const struct DDS_SampleInfo &info);
+    void end_take();
+
+    // Stop the consumer thread once it has aggregated every row appended.
+    // Call it only after the taking thread is done, i.e. once the reader's
+    // listener is detached, since the last rows are taken from the buffer
+    // it fills.
+    void stop();
+
+    std::uint64_t dropped_rows() const;
+    // consumer time per row, columnar mode only
+    double ns_per_row() const;
+
+    void print(std::ostream &os) const;
+
+private:
+    void hand_off_locked();
+    void consume();
+
+    const ColumnarMode mode_;
+    SampleColumns buffers_[2];
+    // the buffer the taking thread fills; the other one is the consumer's
+    int filling_;
+
+    // guards the hand-off state and the counters below
+    mutable std::mutex mutex_;
+    std::condition_variable ready_cv_;
+    bool ready_;
+    bool consuming_;
+    bool stopping_;
+    std::uint64_t blocks_;
+    std::uint64_t dropped_rows_;
+    std::int64_t consume_ns_;
+
+    // updated by the consumer (or the taking thread, per sample)
+    SampleAnalytics analytics_;
+    std::thread consumer_;
+};
+
+#endif
@@ -13,8 +13,15 @@
 
 #include <iostream>
 
+// longest my_type::msg string, see string<128> in example.idl
+static const unsigned int k_my_type_msg_max_length = 128;
+
+// The values below are the defaults for the runtime configuration in
+// app_config.h; a deployment overrides them with a config file instead of
+// rebuilding.
+
 // DDS Domain
-auto domain_id = 100;
+static const int k_domain_id = 100;
 
 // network interface information
 const std::string    k_loopback_name("loopback");
@@ -25,14 +32,32 @@ const std::string    k_real_nic_name("real_nic");
 const unsigned int   k_real_nic_ip(0xc0a80174);
 const unsigned int   k_real_nic_mask(0xffffff00);
 
+// Bring-up tuning. With k_fast_bringup set, the UDP transport properties are
+// kept in static storage instead of being allocated, and each participant
+// sends a quick burst of initial DPSE announcements after enable so that a
+// peer that (re)starts at about the same time is matched within a fraction
+// of a second rather than at the next periodic announcement.
+static const bool k_fast_bringup = true;
+static const int k_fast_initial_participant_announcements = 10;
+static const int k_fast_initial_participant_announcement_period_ms = 100;
+
 // discovery-related constants for example_publisher
 static const std::string k_publisher_initial_peer   = "127.0.0.1";
 static const std::string k_PARTICIPANT01_NAME       = "publisher";
 static const int k_OBJ_ID_PARTICIPANT01_DW01        = 100;
+// the urgent lane's writer, see lane_router.h
+static const int k_OBJ_ID_PARTICIPANT01_DW02        = 101;
 
 // discovery-related constants for example_subscriber 
 static const std::string k_subscriber_initial_peer  = "127.0.0.1";
 static const std::string k_PARTICIPANT02_NAME       = "subscriber";
 static const int k_OBJ_ID_PARTICIPANT02_DR01        = 200;
+static const int k_OBJ_ID_PARTICIPANT02_DR02        = 201;
+
+// RTPS well-known port mapping; user data sent to a multicast group goes to
+// k_rtps_port_base + k_rtps_domain_id_gain * domain + k_rtps_user_multicast
+static const int k_rtps_port_base           = 7400;
+static const int k_rtps_domain_id_gain      = 250;
+static const int k_rtps_user_multicast      = 1;
 
 #endif
@@ -0,0 +1,213 @@
+// (c) Copyright, Real-Time Innovations, 2021.  All rights reserved.
+// RTI grants Licensee a license to use, modify, compile, and create derivative
+// works of the software solely for use with RTI Connext DDS. Licensee may
+// redistribute copies of the software provided that all such copies are subject
+// to this license. The software is provided "as is", with no warranty of any
+// type, including any warranty for fitness for any purpose. RTI is under no
+// obligation to maintain or support the software. RTI shall not be liable for
+// any incidental or consequential damages arising out of the use or inability
+// to use the software.
+
+#include "crc32c.h"
+
+#include <cstring>
+#include <vector>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#include <nmmintrin.h>
+#define CRC32C_HAVE_SSE42 1
+#endif
+
+#include "cyclic_scheduler.h"
+
+namespace {
+
+// the reflected Castagnoli polynomial
+const std::uint32_t k_polynomial = 0x82f63b78;
+
+// table[0] is the classic byte-at-a-time table; table[k] advances a byte
+// through k more zero bytes, so eight lookups consume 8 bytes at once
+struct SliceTables {
+    std::uint32_t table[8][256];
+
+    SliceTables()
+    {
+        for (std::uint32_t i = 0; i < 256; ++i) {
+            auto crc = i;
+            for (auto bit = 0; bit < 8; ++bit) {
+                crc = (crc >> 1) ^ (crc & 1 ? k_polynomial : 0);
+            }
+            table[0][i] = crc;
+        }
+        for (std::uint32_t i = 0; i < 256; ++i) {
+            for (auto k = 1; k < 8; ++k) {
+                table[k][i] = (table[k - 1][i] >> 8) ^
+                        table[0][table[k - 1][i] & 0xff];
+            }
+        }
+    }
+};
+
+const SliceTables k_slices;
+
+std::uint32_t update_slicing_by_8(
+        std::uint32_t crc,
+        const unsigned char *p,
+        std::size_t length)
+{
+    const auto &t = k_slices.table;
+    while (length >= 8) {
+        crc ^= static_cast<std::uint32_t>(p[0]) |
+                static_cast<std::uint32_t>(p[1]) << 8 |
+                static_cast<std::uint32_t>(p[2]) << 16 |
+                static_cast<std::uint32_t>(p[3]) << 24;
+        crc = t[7][crc & 0xff] ^ t[6][(crc >> 8) & 0xff] ^
+                t[5][(crc >> 16) & 0xff] ^ t[4][crc >> 24] ^
+                t[3][p[4]] ^ t[2][p[5]] ^ t[1][p[6]] ^ t[0][p[7]];
+        p += 8;
+        length -= 8;
+    }
+    while (length-- > 0) {
+        crc = t[0][(crc ^ *p++) & 0xff] ^ (crc >> 8);
+    }
+    return crc;
+}
+
+#ifdef CRC32C_HAVE_SSE42
+__attribute__((target("sse4.2")))
+std::uint32_t update_sse42(
+        std::uint32_t crc,
+        const unsigned char *p,
+        std::size_t length)
+{
+#ifdef __x86_64__
+    std::uint64_t crc64 = crc;
+    while (length >= 8) {
+        std::uint64_t word;
+        std::memcpy(&word, p, sizeof(word));
+        crc64 = _mm_crc32_u64(crc64, word);
+        p += 8;
+        length -= 8;
+    }
+    crc = static_cast<std::uint32_t>(crc64);
+#endif
+    while (length >= 4) {
+        std::uint32_t word;
+        std::memcpy(&word, p, sizeof(word));
+        crc = _mm_crc32_u32(crc, word);
+        p += 4;
+        length -= 4;
+    }
+    while (length-- > 0) {
+        crc = _mm_crc32_u8(crc, *p++);
+    }
+    return crc;
+}
+#endif
+
+typedef std::uint32_t (*UpdateFunction)(
+        std::uint32_t,
+        const unsigned char *,
+        std::size_t);
+
+UpdateFunction select_update()
+{
+#ifdef CRC32C_HAVE_SSE42
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("sse4.2")) {
+        return update_sse42;
+    }
+#endif
+    return update_slicing_by_8;
+}
+
+const UpdateFunction k_update = select_update();
+
+// where the benchmark leaves its CRCs, so the loops aren't optimized away
+volatile std::uint32_t g_benchmark_sink;
+
+// ns per call of one implementation over a buffer of the given length
+double time_update(
+        UpdateFunction update,
+        const std::vector<unsigned char> &buffer,
+        std::size_t length)
+{
+    const int k_rounds = 20000;
+    std::uint32_t crc = 0xffffffff;
+    auto start = monotonic_now_ns();
+    for (auto i = 0; i < k_rounds; ++i) {
+        crc = update(crc, buffer.data(), length);
+    }
+    auto elapsed = monotonic_now_ns() - start;
+    g_benchmark_sink = crc;
+    return static_cast<double>(elapsed) / k_rounds;
+}
+
+}  // namespace
+
+std::uint32_t crc32c_update(
+        std::uint32_t crc,
+        const void *data,
+        std::size_t length)
+{
+    return k_update(crc, static_cast<const unsigned char *>(data), length);
+}
+
+std::uint32_t crc32c_update_portable(
+        std::uint32_t crc,
+        const void *data,
+        std::size_t length)
+{
+    return update_slicing_by_8(
+            crc,
+            static_cast<const unsigned char *>(data),
+            length);
+}
+
+const char *crc32c_implementation()
+{
+    return k_update == update_slicing_by_8 ? "slicing-by-8" : "sse4.2";
+}
+
+void crc32c_print_benchmark(std::ostream &os, std::size_t max_length)
+{
+    std::vector<unsigned char> buffer(max_length + 1);
+    for (std::size_t i = 0; i < buffer.size(); ++i) {
+        buffer[i] = static_cast<unsigned char>(i * 31 + 7);
+    }
+    // warm up the caches and the CPU clock before the first size
+    time_update(k_update, buffer, max_length);
+    time_update(update_slicing_by_8, buffer, max_length);
+
+    // least-squares fit of ns per call against length, for ns per byte
+    double n = 0;
+    double sum_x = 0;
+    double sum_xx = 0;
+    double sum_fast = 0;
+    double sum_x_fast = 0;
+    double sum_portable = 0;
+    double sum_x_portable = 0;
+    for (std::size_t length = 0; length <= max_length; ++length) {
+        auto fast = time_update(k_update, buffer, length);
+        auto portable = time_update(update_slicing_by_8, buffer, length);
+        os << "crc32c " << length << " B: " << crc32c_implementation()
+                << " " << fast << " ns, slicing-by-8 " << portable << " ns"
+                << std::endl;
+        double x = length;
+        n += 1;
+        sum_x += x;
+        sum_xx += x * x;
+        sum_fast += fast;
+        sum_x_fast += x * fast;
+        sum_portable += portable;
+        sum_x_portable += x * portable;
+    }
+    auto denominator = n * sum_xx - sum_x * sum_x;
+    if (denominator > 0) {
+        os << "crc32c per byte: " << crc32c_implementation() << " "
+                << (n * sum_x_fast - sum_x * sum_fast) / denominator
+                << " ns, slicing-by-8 "
+                << (n * sum_x_portable - sum_x * sum_portable) / denominator
+                << " ns" << std::endl;
+    }
+}
@@ -0,0 +1,49 @@
+// (c) Copyright, Real-Time Innovations, 2021.  All rights reserved.
+// RTI grants Licensee a license to use, modify, compile, and create derivative
+// works of the software solely for use with RTI Connext DDS. Licensee may
+// redistribute copies of the software provided that all such copies are subject
+// to this license. The software is provided "as is", with no warranty of any
+// type, including any warranty for fitness for any purpose. RTI is under no
+// obligation to maintain or support the software. RTI shall not be liable for
+// any incidental or consequential damages arising out of the use or inability
+// to use the software.
+
+#ifndef CRC32C_H
+#define CRC32C_H
+
+#include <cstddef>
+#include <cstdint>
+#include <iostream>
+
+// CRC32C (Castagnoli, the iSCSI/ext4 polynomial). On x86 CPUs with SSE4.2
+// it runs on the crc32 instruction, 8 bytes at a time; elsewhere on a
+// portable slicing-by-8 table. The implementation is picked once, when the
+// process starts, so don't call these from other static initializers.
+
+// Continue a CRC over more bytes; the register is neither inverted on the
+// way in nor on the way out
+std::uint32_t crc32c_update(
+        std::uint32_t crc,
+        const void *data,
+        std::size_t length);
+
+// the same with the portable tables, whatever the CPU
+std::uint32_t crc32c_update_portable(
+        std::uint32_t crc,
+        const void *data,
+        std::size_t length);
+
+// the CRC32C of a buffer: crc32c("123456789", 9) == 0xe3069283
+inline std::uint32_t crc32c(const void *data, std::size_t length)
+{
+    return ~crc32c_update(0xffffffff, data, length);
+}
+
+// "sse4.2" or "slicing-by-8"
+const char *crc32c_implementation();
+
+// Time both implementations at every size from 0 to max_length bytes and
+// print ns per call, one line per size, then ns per byte
+void crc32c_print_benchmark(std::ostream &os, std::size_t max_length);
+
+#endif
@@ -0,0 +1,226 @@
+// (c) Copyright, Real-Time Innovations, 2021.  All rights reserved.
+// RTI grants Licensee a license to use, modify, compile, and create derivative
+// works of the software solely for use with RTI Connext DDS. Licensee may
+// redistribute copies of the software provided that all such copies are subject
+// to this license. The software is provided "as is", with no warranty of any
+// type, including any warranty for fitness for any purpose. RTI is under no
+// obligation to maintain or support the software. RTI shall not be liable for
+// any incidental or consequential damages arising out of the use or inability
+// to use the software.
+
+#include "cyclic_scheduler.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstdlib>
+#include <limits>
+#include <sstream>
+#include <thread>
+
+namespace {
+
+// keep the frame table (one entry per minor frame) small
+const std::int64_t k_max_frames = 100000;
+const int k_max_streams = 4096;
+
+std::int64_t gcd(std::int64_t a, std::int64_t b)
+{
+    while (b != 0) {
+        auto r = a % b;
+        a = b;
+        b = r;
+    }
+    return a;
+}
+
+bool parse_positive_int(const std::string &text, int *value)
+{
+    if (text.empty()) {
+        return false;
+    }
+    char *end = NULL;
+    errno = 0;
+    auto parsed = std::strtol(text.c_str(), &end, 10);
+    if (*end != '\0' || errno != 0 || parsed < 1 ||
+            parsed > std::numeric_limits<int>::max()) {
+        return false;
+    }
+    *value = static_cast<int>(parsed);
+    return true;
+}
+
+}  // namespace
+
+bool parse_stream_rates(
+        const std::string &text,
+        std::vector<StreamRate> *rates,
+        std::ostream &errors)
+{
+    rates->clear();
+    std::istringstream input(text);
+    std::string item;
+    long streams = 0;
+    while (std::getline(input, item, ',')) {
+        item.erase(0, item.find_first_not_of(" \t"));
+        item.erase(item.find_last_not_of(" \t") + 1);
+        auto colon = item.find(':');
+        StreamRate rate;
+        if (colon == std::string::npos ||
+                !parse_positive_int(item.substr(0, colon), &rate.rate_hz) ||
+                !parse_positive_int(item.substr(colon + 1), &rate.count)) {
+            errors << "ERROR: expected rate_hz:count, got \"" << item << "\""
+                    << std::endl;
+            return false;
+        }
+        if (1000000 % rate.rate_hz != 0) {
+            errors << "ERROR: " << rate.rate_hz
+                    << " Hz is not a whole number of microseconds" << std::endl;
+            return false;
+        }
+        streams += rate.count;
+        if (streams > k_max_streams) {
+            errors << "ERROR: more than " << k_max_streams << " streams"
+                    << std::endl;
+            return false;
+        }
+        rates->push_back(rate);
+    }
+    return true;
+}
+
+bool CyclicScheduler::build(
+        const std::vector<StreamRate> &rates,
+        std::ostream &errors)
+{
+    stream_period_ns_.clear();
+    for (const auto &rate : rates) {
+        auto period_ns = 1000000000LL / rate.rate_hz;
+        stream_period_ns_.insert(
+                stream_period_ns_.end(), rate.count, period_ns);
+    }
+    if (stream_period_ns_.empty()) {
+        errors << "ERROR: no streams to schedule" << std::endl;
+        return false;
+    }
+
+    std::int64_t minor = 0;
+    std::int64_t major = 1;
+    for (auto period : stream_period_ns_) {
+        minor = gcd(minor, period);
+        major = major / gcd(major, period) * period;
+        if (major / minor > k_max_frames) {
+            errors << "ERROR: the stream rates need more than "
+                    << k_max_frames << " minor frames per major frame"
+                    << std::endl;
+            return false;
+        }
+    }
+    minor_frame_ns_ = minor;
+    auto frame_count = static_cast<std::size_t>(major / minor);
+
+    // within a frame, release the fastest streams first
+    std::vector<std::uint32_t> order(stream_period_ns_.size());
+    for (std::size_t i = 0; i < order.size(); ++i) {
+        order[i] = static_cast<std::uint32_t>(i);
+    }
+    std::stable_sort(order.begin(), order.end(),
+            [this](std::uint32_t a, std::uint32_t b) {
+                return stream_period_ns_[a] < stream_period_ns_[b];
+            });
+
+    frame_begin_.assign(1, 0);
+    slots_.clear();
+    for (std::size_t frame = 0; frame < frame_count; ++frame) {
+        auto start = static_cast<std::int64_t>(frame) * minor;
+        for (auto stream : order) {
+            if (start % stream_period_ns_[stream] == 0) {
+                slots_.push_back(stream);
+            }
+        }
+        frame_begin_.push_back(slots_.size());
+    }
+
+    StreamStats empty = {0, std::numeric_limits<std::int64_t>::max(), 0, 0};
+    stats_.assign(stream_period_ns_.size(), empty);
+    frames_ = 0;
+    overruns_ = 0;
+    skipped_frames_ = 0;
+    max_frame_ns_ = 0;
+    return true;
+}
+
+void CyclicScheduler::sleep_until_ns(std::int64_t deadline_ns)
+{
+#ifdef __linux__
+    // an absolute deadline, so time spent in the frame doesn't accumulate
+    struct timespec deadline;
+    deadline.tv_sec = deadline_ns / 1000000000;
+    deadline.tv_nsec = deadline_ns % 1000000000;
+    while (clock_nanosleep(
+                CLOCK_MONOTONIC, TIMER_ABSTIME, &deadline, NULL) == EINTR) {
+    }
+#else
+    auto remaining = deadline_ns - monotonic_now_ns();
+    if (remaining > 0) {
+        std::this_thread::sleep_for(std::chrono::nanoseconds(remaining));
+    }
+#endif
+}
+
+void CyclicScheduler::print_table(std::ostream &os) const
+{
+    auto frame_count = frame_begin_.size() - 1;
+    os << "schedule: " << stream_count() << " streams, minor frame = "
+            << minor_frame_ns_ / 1000 << " us, major frame = "
+            << frame_count << " minor frames, " << slots_.size()
+            << " releases per major frame" << std::endl;
+    std::size_t busiest = 0;
+    for (std::size_t frame = 0; frame < frame_count; ++frame) {
+        busiest = std::max(
+                busiest, frame_begin_[frame + 1] - frame_begin_[frame]);
+    }
+    os << "\tbusiest minor frame releases " << busiest << " streams"
+            << std::endl;
+}
+
+void CyclicScheduler::print_stats(std::ostream &os) const
+{
+    os << "schedule: frames = " << frames_
+            << ", overruns = " << overruns_
+            << ", skipped frames = " << skipped_frames_
+            << ", max frame = " << max_frame_ns_ / 1000.0 << " us"
+            << std::endl;
+
+    // one line per rate group is enough: streams of a rate share a period
+    for (std::size_t first = 0; first < stats_.size();) {
+        auto last = first;
+        StreamStats group = {
+            0, std::numeric_limits<std::int64_t>::max(), 0, 0
+        };
+        while (last < stats_.size() &&
+                stream_period_ns_[last] == stream_period_ns_[first]) {
+            const auto &stats = stats_[last];
+            group.releases += stats.releases;
+            group.total_latency_ns += stats.total_latency_ns;
+            group.min_latency_ns =
+                    std::min(group.min_latency_ns, stats.min_latency_ns);
+            group.max_latency_ns =
+                    std::max(group.max_latency_ns, stats.max_latency_ns);
+            ++last;
+        }
+        os << "\tstreams " << first << "-" << last - 1 << " @ "
+                << 1000000000 / stream_period_ns_[first] << " Hz: releases = "
+                << group.releases;
+        if (group.releases > 0) {
+            os << ", release latency min/avg/max = "
+                    << group.min_latency_ns / 1000.0 << "/"
+                    << group.total_latency_ns / 1000.0 / group.releases << "/"
+                    << group.max_latency_ns / 1000.0 << " us, jitter = "
+                    << (group.max_latency_ns - group.min_latency_ns) / 1000.0
+                    << " us";
+        }
+        os << std::endl;
+        first = last;
+    }
+}
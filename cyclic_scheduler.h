@@ -0,0 +1,135 @@
+// (c) Copyright, Real-Time Innovations, 2021.  All rights reserved.
+// RTI grants Licensee a license to use, modify, compile, and create derivative
+// works of the software solely for use with RTI Connext DDS. Licensee may
+// redistribute copies of the software provided that all such copies are subject
+// to this license. The software is provided "as is", with no warranty of any
+// type, including any warranty for fitness for any purpose. RTI is under no
+// obligation to maintain or support the software. RTI shall not be liable for
+// any incidental or consequential damages arising out of the use or inability
+// to use the software.
+
+#ifndef CYCLIC_SCHEDULER_H
+#define CYCLIC_SCHEDULER_H
+
+#include <cstdint>
+#include <ctime>
+#include <iostream>
+#include <string>
+#include <vector>
+
+// A group of streams published at the same rate
+struct StreamRate {
+    int rate_hz;
+    int count;
+};
+
+// Parse "rate_hz:count,..." (e.g. "1000:2,100:8,10:16"). Every rate must
+// divide one second into whole microseconds.
+bool parse_stream_rates(
+        const std::string &text,
+        std::vector<StreamRate> *rates,
+        std::ostream &errors);
+
+inline std::int64_t monotonic_now_ns()
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return static_cast<std::int64_t>(now.tv_sec) * 1000000000 + now.tv_nsec;
+}
+
+// Time-triggered cyclic executive for periodic streams. build() lays the
+// streams out in a frame table: the minor frame is the GCD of the stream
+// periods and the major frame their LCM, and each minor frame lists the
+// streams released in it, fastest first. run() then wakes at the absolute
+// start of every minor frame and releases that frame's streams, all on the
+// calling thread and without allocating.
+//
+// A stream's release latency is the time from its frame's deadline to the
+// call that releases it; its jitter is the spread of that latency. A frame
+// that is still running when the next one is due is an overrun; frames
+// that are missed entirely are skipped rather than run late in a burst.
+class CyclicScheduler {
+public:
+    struct StreamStats {
+        std::uint64_t releases;
+        std::int64_t min_latency_ns;
+        std::int64_t max_latency_ns;
+        std::int64_t total_latency_ns;
+    };
+
+    bool build(const std::vector<StreamRate> &rates, std::ostream &errors);
+
+    std::size_t stream_count() const { return stream_period_ns_.size(); }
+
+    // release(stream) is called once per period of each stream, where
+    // stream is 0 .. stream_count() - 1 in the order the rates were given;
+    // run() returns once stop() is true at the start of a minor frame
+    template <typename Release, typename Stop>
+    void run(Release release, Stop stop);
+
+    void print_table(std::ostream &os) const;
+    void print_stats(std::ostream &os) const;
+
+private:
+    static void sleep_until_ns(std::int64_t deadline_ns);
+
+    std::int64_t minor_frame_ns_;
+    std::vector<std::int64_t> stream_period_ns_;
+    // frame_begin_[f] .. frame_begin_[f + 1] indexes slots_ for frame f
+    std::vector<std::size_t> frame_begin_;
+    std::vector<std::uint32_t> slots_;
+
+    std::vector<StreamStats> stats_;
+    std::uint64_t frames_;
+    std::uint64_t overruns_;
+    std::uint64_t skipped_frames_;
+    std::int64_t max_frame_ns_;
+};
+
+template <typename Release, typename Stop>
+void CyclicScheduler::run(Release release, Stop stop)
+{
+    const std::size_t frame_count = frame_begin_.size() - 1;
+    std::size_t frame = 0;
+    // start on a whole minor frame boundary, one frame from now
+    auto deadline = (monotonic_now_ns() / minor_frame_ns_ + 1) *
+            minor_frame_ns_;
+
+    while (!stop()) {
+        sleep_until_ns(deadline);
+
+        for (auto i = frame_begin_[frame]; i < frame_begin_[frame + 1]; ++i) {
+            auto stream = slots_[i];
+            auto latency = monotonic_now_ns() - deadline;
+            auto &stats = stats_[stream];
+            ++stats.releases;
+            stats.total_latency_ns += latency;
+            if (latency < stats.min_latency_ns) {
+                stats.min_latency_ns = latency;
+            }
+            if (latency > stats.max_latency_ns) {
+                stats.max_latency_ns = latency;
+            }
+            release(stream);
+        }
+        ++frames_;
+
+        auto end = monotonic_now_ns();
+        if (end - deadline > max_frame_ns_) {
+            max_frame_ns_ = end - deadline;
+        }
+        deadline += minor_frame_ns_;
+        frame = (frame + 1) % frame_count;
+        if (end > deadline) {
+            ++overruns_;
+            // drop the frames whose time has already passed entirely
+            while (end > deadline + minor_frame_ns_) {
+                deadline += minor_frame_ns_;
+                frame = (frame + 1) % frame_count;
+                ++skipped_frames_;
+            }
+        }
+    }
+}
+
+#endif
@@ -0,0 +1,598 @@
+// (c) Copyright, Real-Time Innovations, 2021.  All rights reserved.
+// RTI grants Licensee a license to use, modify, compile, and create derivative
+// works of the software solely for use with RTI Connext DDS. Licensee may
+// redistribute copies of the software provided that all such copies are subject
+// to this license. The software is provided "as is", with no warranty of any
+// type, including any warranty for fitness for any purpose. RTI is under no
+// obligation to maintain or support the software. RTI shall not be liable for
+// any incidental or consequential damages arising out of the use or inability
+// to use the software.
+
+#include "dds_setup.h"
+
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <thread>
+
+// headers from Connext DDS Micro/Cert installation
+#include "disc_dpse/disc_dpse_dpsediscovery.h"
+#include "wh_sm/wh_sm_history.h"
+#include "rh_sm/rh_sm_history.h"
+#include "netio/netio_udp.h"
+
+// rtiddsgen generated headers
+#include "example.h"
+#include "examplePlugin.h"
+#include "my_type_plugin.h"
+#include "sample_batch_plugin.h"
+
+#include "common_config.h"
+
+namespace {
+
+bool set_string_seq(DDS_StringSeq *seq, const char *value)
+{
+    if (!DDS_StringSeq_set_maximum(seq, 1) ||
+            !DDS_StringSeq_set_length(seq, 1)) {
+        return false;
+    }
+    *DDS_StringSeq_get_reference(seq, 0) = DDS_String_dup(value);
+    return true;
+}
+
+// batches travel on a topic of their own, so a batching application never
+// matches one that is not; the urgent lane is never batched
+const char *topic_name(const AppConfig &config, Lane lane)
+{
+    if (lane == LANE_URGENT) {
+        return k_urgent_topic_name;
+    }
+    return config.batch_enabled ? my_topic_batch_name : my_topic_name;
+}
+
+const char *type_name(const AppConfig &config, Lane lane)
+{
+    return config.batch_enabled && lane == LANE_BULK
+            ? k_batch_type_name : k_type_name;
+}
+
+// my_type_batch has no key, so its topic is a single instance holding
+// every id's samples, each batch up to batch.max_records of them. Size that
+// instance for as many samples as the per-id limits would have kept
+// altogether, assuming full batches, and never below the per-id limits.
+void scale_for_batches(
+        const AppConfig &config,
+        struct DDS_ResourceLimitsQosPolicy *limits,
+        struct DDS_HistoryQosPolicy *history)
+{
+    auto batches = [&config](int per_instance) {
+        auto samples = static_cast<long>(per_instance) * config.max_instances;
+        auto needed = static_cast<int>(
+                (samples + config.batch_max_records - 1) /
+                config.batch_max_records);
+        return needed > per_instance ? needed : per_instance;
+    };
+    history->depth = batches(config.history_depth);
+    limits->max_samples_per_instance =
+            batches(config.max_samples_per_instance);
+    limits->max_instances = 1;
+    limits->max_samples = limits->max_samples_per_instance;
+}
+
+}  // namespace
+
+bool dds_setup_register_components(
+        const AppConfig &config,
+        StartupProfiler *profiler)
+{
+    // create the DomainParticipantFactory and registry so that we can make
+    // some changes to the default values
+    auto dpf = DDS_DomainParticipantFactory_get_instance();
+    auto registry = DDS_DomainParticipantFactory_get_registry(dpf);
+
+    // register writer history
+    if (!RT_Registry_register(
+            registry,
+            DDSHST_WRITER_DEFAULT_HISTORY_NAME,
+            WHSM_HistoryFactory_get_interface(),
+            NULL,
+            NULL))
+    {
+        std::cout << "ERROR: failed to register wh" << std::endl;
+    }
+    // register reader history
+    if (!RT_Registry_register(
+            registry,
+            DDSHST_READER_DEFAULT_HISTORY_NAME,
+            RHSM_HistoryFactory_get_interface(),
+            NULL,
+            NULL))
+    {
+        std::cout << "ERROR: failed to register rh" << std::endl;
+    }
+    profiler->mark("register histories");
+
+    // Set up the UDP transport's allowed interfaces. To do this we:
+    // (1) unregister the UDP transport
+    // (2) name the allowed interfaces
+    // (3) re-register the transport
+    // Connext Micro only reads the UDP properties when the transport is
+    // registered, so the unregister/re-register can't be skipped; the fast
+    // bring-up path just avoids the heap allocation for the properties.
+    if (!RT_Registry_unregister(
+            registry,
+            NETIO_DEFAULT_UDP_NAME,
+            NULL,
+            NULL))
+    {
+        std::cout << "ERROR: failed to unregister udp" << std::endl;
+    }
+
+    static struct UDP_InterfaceFactoryProperty static_udp_property;
+    auto udp_property = config.fast_bringup ? &static_udp_property :
+            (struct UDP_InterfaceFactoryProperty *)malloc(
+                    sizeof(struct UDP_InterfaceFactoryProperty));
+    if (udp_property == NULL) {
+        std::cout << "ERROR: failed to allocate udp properties" << std::endl;
+        return false;
+    }
+    *udp_property = UDP_INTERFACE_FACTORY_PROPERTY_DEFAULT;
+    udp_property->disable_auto_interface_config = RTI_TRUE;
+
+    if (!DDS_StringSeq_set_maximum(&udp_property->allow_interface,2)) {
+        printf("failed to set allow_interface maximum\n");
+        return false;
+    }
+    if (!DDS_StringSeq_set_length(&udp_property->allow_interface,2)) {
+        printf("failed to set allow_interface length\n");
+        return false;
+    }
+
+    if (!UDP_InterfaceTableEntrySeq_set_maximum(&udp_property->if_table,2)) {
+        printf("failed to set if_table maximum\n");
+        return false;
+    }
+
+    *DDS_StringSeq_get_reference(&udp_property->allow_interface,0) =
+            DDS_String_dup(config.loopback_name.c_str());
+    if (!UDP_InterfaceTable_add_entry(
+            &udp_property->if_table,
+            config.loopback_ip,
+            config.loopback_mask,
+            config.loopback_name.c_str(),
+            UDP_INTERFACE_INTERFACE_UP_FLAG))
+    {
+        std::cout << "ERROR: failed to add " << config.loopback_name.c_str() <<
+                "interface" << std::endl;
+        return false;
+    }
+
+    *DDS_StringSeq_get_reference(&udp_property->allow_interface,1) =
+            DDS_String_dup(config.real_nic_name.c_str());
+    if (!UDP_InterfaceTable_add_entry(
+            &udp_property->if_table,
+            config.real_nic_ip,
+            config.real_nic_mask,
+            config.real_nic_name.c_str(),
+            UDP_INTERFACE_INTERFACE_UP_FLAG))
+    {
+        std::cout << "ERROR: failed to add " << config.loopback_name.c_str() <<
+                "interface" << std::endl;
+        return false;
+    }
+
+    //explicitly set the "real NIC" as the multicast interface
+    udp_property->multicast_interface =
+            DDS_String_dup(config.real_nic_name.c_str());
+
+    if(!RT_Registry_register(
+            registry,
+            NETIO_DEFAULT_UDP_NAME,
+            UDP_InterfaceFactory_get_interface(),
+            (struct RT_ComponentFactoryProperty*)udp_property, NULL))
+    {
+        std::cout << "ERROR: failed to re-register udp" << std::endl;
+    }
+    profiler->mark("re-register udp");
+
+    // register the dpse (discovery) component
+    static struct DPSE_DiscoveryPluginProperty discovery_plugin_properties =
+            DPSE_DiscoveryPluginProperty_INITIALIZER;
+    if (!RT_Registry_register(
+            registry,
+            "dpse",
+            DPSE_DiscoveryFactory_get_interface(),
+            &discovery_plugin_properties._parent,
+            NULL))
+    {
+        std::cout << "ERROR: failed to register dpse" << std::endl;
+    }
+    profiler->mark("register dpse");
+
+    // Now that we've finished the changes to the registry, we will start
+    // creating DDS entities. By setting autoenable_created_entities to false
+    // until all of the DDS entities are created, we limit all dynamic memory
+    // allocation to happen *before* the point where we enable everything.
+    struct DDS_DomainParticipantFactoryQos dpf_qos =
+            DDS_DomainParticipantFactoryQos_INITIALIZER;
+    DDS_DomainParticipantFactory_get_qos(dpf, &dpf_qos);
+    dpf_qos.entity_factory.autoenable_created_entities = DDS_BOOLEAN_FALSE;
+    DDS_DomainParticipantFactory_set_qos(dpf, &dpf_qos);
+    return true;
+}
+
+DDS_DomainParticipant *dds_setup_create_participant(
+        const AppConfig &config,
+        const ParticipantSetup &setup,
+        StartupProfiler *profiler)
+{
+    auto dpf = DDS_DomainParticipantFactory_get_instance();
+
+    // configure discovery prior to creating our DomainParticipant
+    struct DDS_DomainParticipantQos dp_qos =
+            DDS_DomainParticipantQos_INITIALIZER;
+    if(!RT_ComponentFactoryId_set_name(
+            &dp_qos.discovery.discovery.name,
+            "dpse"))
+    {
+        std::cout << "ERROR: failed to set discovery plugin name" << std::endl;
+    }
+    if (!set_string_seq(
+                &dp_qos.discovery.initial_peers,
+                setup.initial_peer.c_str())) {
+        std::cout << "ERROR: failed to set initial peers" << std::endl;
+    }
+
+    // User data between participants of one process can skip the network
+    // stack: Micro's intra-process transport hands the sample over directly.
+    // Discovery (participant announcements) stays on UDP.
+    if (setup.intra_user_traffic) {
+        if (!DDS_StringSeq_set_maximum(&dp_qos.transports.enabled_transports,
+                    2) ||
+                !DDS_StringSeq_set_length(
+                    &dp_qos.transports.enabled_transports, 2)) {
+            std::cout << "ERROR: failed to set enabled transports"
+                    << std::endl;
+        } else {
+            *DDS_StringSeq_get_reference(
+                    &dp_qos.transports.enabled_transports, 0) =
+                    DDS_String_dup(NETIO_DEFAULT_UDP_NAME);
+            *DDS_StringSeq_get_reference(
+                    &dp_qos.transports.enabled_transports, 1) =
+                    DDS_String_dup(NETIO_DEFAULT_INTRA_NAME);
+        }
+        if (!set_string_seq(
+                    &dp_qos.discovery.enabled_transports,
+                    "_udp://") ||
+                !set_string_seq(
+                    &dp_qos.user_traffic.enabled_transports,
+                    "_intra://")) {
+            std::cout << "ERROR: failed to select the intra transport"
+                    << std::endl;
+        }
+    }
+
+    // announce ourselves more often right after enable so that matching
+    // doesn't wait for the next periodic participant announcement
+    if (config.fast_bringup) {
+        dp_qos.discovery.initial_participant_announcements =
+                config.initial_participant_announcements;
+        // split, as the setting goes up to a minute
+        dp_qos.discovery.initial_participant_announcement_period.sec =
+                config.initial_participant_announcement_period_ms / 1000;
+        dp_qos.discovery.initial_participant_announcement_period.nanosec =
+                config.initial_participant_announcement_period_ms % 1000 *
+                1000000;
+    }
+
+    // configure the DomainParticipant's resource limits... these are just
+    // examples, if there are more remote or local endpoints these values would
+    // need to be increased
+    dp_qos.resource_limits.max_destination_ports = setup.max_destination_ports;
+    dp_qos.resource_limits.max_receive_ports = 32;
+    auto lanes = dds_setup_lane_count(config);
+    dp_qos.resource_limits.local_topic_allocation = lanes;
+    dp_qos.resource_limits.local_type_allocation = lanes;
+    dp_qos.resource_limits.local_reader_allocation = lanes;
+    dp_qos.resource_limits.local_writer_allocation = lanes;
+    dp_qos.resource_limits.remote_participant_allocation =
+            config.remote_participant_allocation;
+    dp_qos.resource_limits.remote_reader_allocation =
+            setup.remote_reader_allocation;
+    dp_qos.resource_limits.remote_writer_allocation =
+            setup.remote_writer_allocation;
+
+    //  set the name of the local DomainParticipant
+    // (this is required for DPSE discovery)
+    strcpy(dp_qos.participant_name.name, setup.name.c_str());
+
+    // now the DomainParticipant can be created
+    auto dp = DDS_DomainParticipantFactory_create_participant(
+            dpf,
+            config.domain_id,
+            &dp_qos,
+            NULL,
+            DDS_STATUS_MASK_NONE);
+    if(dp == NULL) {
+        std::cout << "ERROR: failed to create participant" << std::endl;
+    }
+    profiler->mark("create participant");
+    return dp;
+}
+
+int dds_setup_lane_count(const AppConfig &config)
+{
+    return config.lanes_urgent_ids.empty() ? 1 : 2;
+}
+
+DDS_Topic *dds_setup_create_topic(
+        DDS_DomainParticipant *dp,
+        const AppConfig &config,
+        StartupProfiler *profiler,
+        Lane lane)
+{
+    // register the type (my_type, from the idl) with the middleware; the
+    // urgent lane reuses my_type unless the bulk lane batches
+    if (lane == LANE_BULK || config.batch_enabled) {
+        auto type_plugin = config.batch_enabled && lane == LANE_BULK
+                ? MyTypeBatchPlugin::get()
+                : config.template_type_plugin
+                        ? MyTypeTemplatePlugin::get()
+                        : my_typeTypePlugin_get();
+        auto retcode = DDS_DomainParticipant_register_type(
+                dp,
+                type_name(config, lane),
+                type_plugin);
+        if(retcode != DDS_RETCODE_OK) {
+            std::cout << "ERROR: failed to register type" << std::endl;
+        }
+        profiler->mark("register type");
+    }
+
+    // Create the Topic. Note that the name of the Topic is stored in
+    // my-topic-name, which was defined in the IDL
+    auto topic = DDS_DomainParticipant_create_topic(
+            dp,
+            topic_name(config, lane),
+            type_name(config, lane),
+            &DDS_TOPIC_QOS_DEFAULT,
+            NULL,
+            DDS_STATUS_MASK_NONE);
+    if(topic == NULL) {
+        std::cout << "ERROR: topic == NULL" << std::endl;
+    }
+    profiler->mark(lane == LANE_BULK ? "create topic" : "create urgent topic");
+    return topic;
+}
+
+NDDS_TypePluginKeyKind dds_setup_key_kind(const AppConfig &config, Lane lane)
+{
+    return config.batch_enabled && lane == LANE_BULK
+            ? NDDS_TYPEPLUGIN_NO_KEY
+            : my_type_get_key_kind(my_typeTypePlugin_get(), NULL);
+}
+
+void dds_setup_writer_qos(
+        const AppConfig &config,
+        DDS_DataWriterQos *qos,
+        Lane lane)
+{
+    auto urgent = lane == LANE_URGENT;
+    qos->protocol.rtps_object_id = urgent
+            ? config.lanes_urgent_writer_object_id
+            : config.publisher_writer_object_id;
+    qos->reliability.kind = config.reliable ?
+            DDS_RELIABLE_RELIABILITY_QOS : DDS_BEST_EFFORT_RELIABILITY_QOS;
+    qos->resource_limits.max_samples_per_instance =
+            config.max_samples_per_instance;
+    qos->resource_limits.max_instances = config.max_instances;
+    qos->resource_limits.max_samples = qos->resource_limits.max_instances *
+            qos->resource_limits.max_samples_per_instance;
+    qos->history.depth = urgent
+            ? config.lanes_urgent_history_depth : config.history_depth;
+    if (config.batch_enabled && !urgent) {
+        scale_for_batches(config, &qos->resource_limits, &qos->history);
+    }
+    // with a non-blocking policy a full writer fails the write at once and
+    // BackpressureWriter decides what to do with the sample
+    if ((urgent ? config.lanes_urgent_backpressure_policy
+                : config.backpressure_policy) != "block") {
+        qos->reliability.max_blocking_time.sec = 0;
+        qos->reliability.max_blocking_time.nanosec = 0;
+    }
+    // the writer history keeps history.depth samples per instance for
+    // readers that match later
+    if (config.durability_transient_local) {
+        qos->durability.kind = DDS_TRANSIENT_LOCAL_DURABILITY_QOS;
+    }
+    qos->writer_resource_limits.max_remote_readers =
+            config.fanout_subscribers;
+    // the urgent lane repairs losses sooner
+    auto heartbeat_period_ms = urgent
+            ? config.lanes_urgent_heartbeat_period_ms
+            : config.heartbeat_period_ms;
+    qos->protocol.rtps_reliable_writer.heartbeat_period.sec =
+            heartbeat_period_ms / 1000;
+    qos->protocol.rtps_reliable_writer.heartbeat_period.nanosec =
+            (heartbeat_period_ms % 1000) * 1000000;
+}
+
+void dds_setup_reader_qos(
+        const AppConfig &config,
+        DDS_DataReaderQos *qos,
+        Lane lane)
+{
+    auto urgent = lane == LANE_URGENT;
+    qos->protocol.rtps_object_id = urgent
+            ? config.lanes_urgent_reader_object_id
+            : config.subscriber_reader_object_id;
+    qos->reliability.kind = config.reliable ?
+            DDS_RELIABLE_RELIABILITY_QOS : DDS_BEST_EFFORT_RELIABILITY_QOS;
+    qos->resource_limits.max_instances = config.max_instances;
+    qos->resource_limits.max_samples_per_instance =
+            config.max_samples_per_instance;
+    qos->resource_limits.max_samples = qos->resource_limits.max_instances *
+            qos->resource_limits.max_samples_per_instance;
+    qos->reader_resource_limits.max_remote_writers =
+            config.max_remote_writers;
+    qos->reader_resource_limits.max_remote_writers_per_instance =
+            config.max_remote_writers;
+    qos->history.depth = urgent
+            ? config.lanes_urgent_history_depth : config.history_depth;
+    if (config.batch_enabled && !urgent) {
+        scale_for_batches(config, &qos->resource_limits, &qos->history);
+    }
+    // ask matched writers for the history they kept
+    if (config.durability_transient_local) {
+        qos->durability.kind = DDS_TRANSIENT_LOCAL_DURABILITY_QOS;
+    }
+    // there is no TIME_BASED_FILTER policy in Connext Micro: the subscriber
+    // applies downsample.min_separation_ms itself (see downsample_filter.h)
+
+    // In multicast fan-out the reader receives on the group; the publisher
+    // asserts the same locator for it, so one send reaches every reader
+    if (!config.fanout_multicast_address.empty()) {
+        if (!DDS_TransportMulticastSettingsSeq_set_maximum(
+                    &qos->multicast.value, 1) ||
+                !DDS_TransportMulticastSettingsSeq_set_length(
+                    &qos->multicast.value, 1)) {
+            std::cout << "ERROR: failed to set multicast settings length"
+                    << std::endl;
+            return;
+        }
+        auto multicast = DDS_TransportMulticastSettingsSeq_get_reference(
+                &qos->multicast.value, 0);
+        multicast->receive_address =
+                DDS_String_dup(config.fanout_multicast_address.c_str());
+        multicast->receive_port = k_rtps_port_base +
+                k_rtps_domain_id_gain * config.domain_id +
+                k_rtps_user_multicast;
+    }
+}
+
+void dds_setup_remote_subscription_data(
+        const AppConfig &config,
+        DDS_SubscriptionBuiltinTopicData *data,
+        Lane lane)
+{
+    data->key.value[DDS_BUILTIN_TOPIC_KEY_OBJECT_ID] = lane == LANE_URGENT
+            ? config.lanes_urgent_reader_object_id
+            : config.subscriber_reader_object_id;
+    data->topic_name = DDS_String_dup(topic_name(config, lane));
+    data->type_name = DDS_String_dup(type_name(config, lane));
+    data->reliability.kind = config.reliable ?
+            DDS_RELIABLE_RELIABILITY_QOS : DDS_BEST_EFFORT_RELIABILITY_QOS;
+    data->durability.kind = config.durability_transient_local ?
+            DDS_TRANSIENT_LOCAL_DURABILITY_QOS : DDS_VOLATILE_DURABILITY_QOS;
+
+    // In multicast fan-out every reader receives on the group, so the
+    // writer sends each sample to that one locator instead of to each
+    // reader's unicast locator in turn
+    if (config.fanout_multicast_address.empty()) {
+        return;
+    }
+    unsigned int group = 0;
+    app_config_parse_ip(config.fanout_multicast_address, &group);
+    if (!DDS_LocatorSeq_set_maximum(&data->multicast_locator, 1) ||
+            !DDS_LocatorSeq_set_length(&data->multicast_locator, 1)) {
+        std::cout << "ERROR: failed to set multicast locator length"
+                << std::endl;
+        return;
+    }
+    auto locator = DDS_LocatorSeq_get_reference(&data->multicast_locator, 0);
+    locator->kind = DDS_LOCATOR_KIND_UDPv4;
+    locator->port = k_rtps_port_base +
+            k_rtps_domain_id_gain * config.domain_id +
+            k_rtps_user_multicast;
+    // an IPv4 address goes in the last 4 of the 16 address bytes
+    for (int b = 0; b < 16; ++b) {
+        locator->address[b] = 0;
+    }
+    locator->address[12] = (DDS_Octet)(group >> 24);
+    locator->address[13] = (DDS_Octet)(group >> 16);
+    locator->address[14] = (DDS_Octet)(group >> 8);
+    locator->address[15] = (DDS_Octet)group;
+}
+
+void dds_setup_remote_publication_data(
+        const AppConfig &config,
+        DDS_PublicationBuiltinTopicData *data,
+        Lane lane)
+{
+    data->key.value[DDS_BUILTIN_TOPIC_KEY_OBJECT_ID] = lane == LANE_URGENT
+            ? config.lanes_urgent_writer_object_id
+            : config.publisher_writer_object_id;
+    data->topic_name = DDS_String_dup(topic_name(config, lane));
+    data->type_name = DDS_String_dup(type_name(config, lane));
+    data->reliability.kind = config.reliable ?
+            DDS_RELIABLE_RELIABILITY_QOS : DDS_BEST_EFFORT_RELIABILITY_QOS;
+    data->durability.kind = config.durability_transient_local ?
+            DDS_TRANSIENT_LOCAL_DURABILITY_QOS : DDS_VOLATILE_DURABILITY_QOS;
+}
+
+void ParticipantTeardown::add_reader(DDS_DataReader *reader)
+{
+    if (reader != NULL) {
+        readers_.push_back(reader);
+    }
+}
+
+void ParticipantTeardown::add_writer(DDS_DataWriter *writer)
+{
+    if (writer != NULL) {
+        writers_.push_back(writer);
+    }
+}
+
+void CallbackGate::close()
+{
+    closed_.store(true);
+    while (active_.load(std::memory_order_acquire) != 0) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+}
+
+void ParticipantTeardown::shutdown()
+{
+    if (dp_ == NULL) {
+        return;
+    }
+    struct DDS_DataReaderListener no_reader_listener =
+            DDS_DataReaderListener_INITIALIZER;
+    for (auto reader : readers_) {
+        if (DDS_DataReader_set_listener(
+                    reader,
+                    &no_reader_listener,
+                    DDS_STATUS_MASK_NONE) != DDS_RETCODE_OK) {
+            std::cout << "ERROR: failed to detach reader listener"
+                    << std::endl;
+        }
+    }
+    struct DDS_DataWriterListener no_writer_listener =
+            DDS_DataWriterListener_INITIALIZER;
+    for (auto writer : writers_) {
+        if (DDS_DataWriter_set_listener(
+                    writer,
+                    &no_writer_listener,
+                    DDS_STATUS_MASK_NONE) != DDS_RETCODE_OK) {
+            std::cout << "ERROR: failed to detach writer listener"
+                    << std::endl;
+        }
+    }
+    // a callback the middleware started before the detach may still run
+    if (gate_ != NULL) {
+        gate_->close();
+    }
+#ifndef RTI_CERT
+    if (DDS_DomainParticipant_delete_contained_entities(dp_) !=
+                    DDS_RETCODE_OK ||
+            DDS_DomainParticipantFactory_delete_participant(
+                    DDS_DomainParticipantFactory_get_instance(),
+                    dp_) != DDS_RETCODE_OK) {
+        std::cout << "ERROR: failed to delete participant" << std::endl;
+    }
+#endif
+    dp_ = NULL;
+}
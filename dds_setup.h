@@ -0,0 +1,186 @@
+// (c) Copyright, Real-Time Innovations, 2021.  All rights reserved.
+// RTI grants Licensee a license to use, modify, compile, and create derivative
+// works of the software solely for use with RTI Connext DDS. Licensee may
+// redistribute copies of the software provided that all such copies are subject
+// to this license. The software is provided "as is", with no warranty of any
+// type, including any warranty for fitness for any purpose. RTI is under no
+// obligation to maintain or support the software. RTI shall not be liable for
+// any incidental or consequential damages arising out of the use or inability
+// to use the software.
+
+#ifndef DDS_SETUP_H
+#define DDS_SETUP_H
+
+#include <atomic>
+#include <string>
+#include <vector>
+
+#include "rti_me_c.h"
+
+#include "app_config.h"
+#include "lane_router.h"
+#include "startup_profiler.h"
+
+// The DDS bring-up shared by example_publisher, example_subscriber and
+// example_inprocess. Each step prints what went wrong on std::cout (as the
+// applications always have) and marks its phase in the StartupProfiler; a
+// false/NULL result means the application can't continue.
+
+// name my_type is registered under
+static const char *const k_type_name = "my_type";
+// and my_type_batch, with batch.enabled
+static const char *const k_batch_type_name = "my_type_batch";
+// the urgent lane's topic (of my_type), with lanes.urgent_ids
+static const char *const k_urgent_topic_name = "my_topic_urgent";
+
+// 2 with an urgent lane, else 1: the writers or readers each side creates
+int dds_setup_lane_count(const AppConfig &config);
+
+// Register the writer/reader histories, the UDP transport restricted to the
+// configured loopback and "real NIC" interfaces, and DPSE discovery, then
+// turn off autoenable so nothing allocates after DDS_Entity_enable. Call
+// once per process, before the first participant is created.
+bool dds_setup_register_components(
+        const AppConfig &config,
+        StartupProfiler *profiler);
+
+// What differs between the participants the applications create
+struct ParticipantSetup {
+    std::string name;
+    std::string initial_peer;
+    DDS_Long max_destination_ports = 32;
+    DDS_Long remote_reader_allocation = 8;
+    DDS_Long remote_writer_allocation = 8;
+    // send user data over the intra-process transport ("_intra") instead
+    // of UDP; discovery stays on UDP
+    bool intra_user_traffic = false;
+};
+
+DDS_DomainParticipant *dds_setup_create_participant(
+        const AppConfig &config,
+        const ParticipantSetup &setup,
+        StartupProfiler *profiler);
+
+// Lets main() wait out listener callbacks. Every callback is bracketed by
+// enter() and leave() (or a Scope) and does nothing if enter() fails;
+// close() makes later enter() calls fail and returns once no callback is
+// inside. Detaching a listener does not wait for a callback the middleware
+// already started, and Cert cannot delete the entities that would.
+class CallbackGate {
+public:
+    CallbackGate() : active_(0), closed_(false) {}
+    CallbackGate(const CallbackGate &) = delete;
+    CallbackGate &operator=(const CallbackGate &) = delete;
+
+    // false once closed; true must be followed by leave()
+    bool enter()
+    {
+        // seq_cst on both sides: either close() sees this callback
+        // active, or this callback sees the gate closed
+        active_.fetch_add(1);
+        if (closed_.load()) {
+            leave();
+            return false;
+        }
+        return true;
+    }
+
+    void leave() { active_.fetch_sub(1, std::memory_order_release); }
+
+    void close();
+
+    class Scope {
+    public:
+        explicit Scope(CallbackGate *gate)
+            : gate_(gate), entered_(gate->enter())
+        {
+        }
+        ~Scope()
+        {
+            if (entered_) {
+                gate_->leave();
+            }
+        }
+        Scope(const Scope &) = delete;
+        Scope &operator=(const Scope &) = delete;
+
+        bool entered() const { return entered_; }
+
+    private:
+        CallbackGate *gate_;
+        const bool entered_;
+    };
+
+private:
+    std::atomic<int> active_;
+    std::atomic<bool> closed_;
+};
+
+// Stops the middleware calling into the application before the state its
+// listeners use goes away. shutdown() detaches the listeners of the added
+// readers and writers and closes the gate the listeners enter, so it
+// returns only once no callback is running; outside Cert it then deletes
+// the participant's entities and the participant. It runs at the latest
+// when the object is destroyed, so declare it after whatever the
+// listeners use: it is then destroyed first, on every return path.
+class ParticipantTeardown {
+public:
+    ParticipantTeardown(DDS_DomainParticipant *dp, CallbackGate *gate)
+        : dp_(dp), gate_(gate)
+    {
+    }
+    ParticipantTeardown(const ParticipantTeardown &) = delete;
+    ParticipantTeardown &operator=(const ParticipantTeardown &) = delete;
+    ~ParticipantTeardown() { shutdown(); }
+
+    // NULL is ignored
+    void add_reader(DDS_DataReader *reader);
+    void add_writer(DDS_DataWriter *writer);
+
+    // once; later calls do nothing
+    void shutdown();
+
+private:
+    DDS_DomainParticipant *dp_;
+    CallbackGate *gate_;
+    std::vector<DDS_DataReader *> readers_;
+    std::vector<DDS_DataWriter *> writers_;
+};
+
+// register my_type (the generated or the template plugin) and create the
+// topic named in the IDL; with batch.enabled, my_type_batch and its topic
+// instead. The urgent lane's topic is always of my_type; create it after
+// the bulk lane's.
+DDS_Topic *dds_setup_create_topic(
+        DDS_DomainParticipant *dp,
+        const AppConfig &config,
+        StartupProfiler *profiler,
+        Lane lane = LANE_BULK);
+
+// the key kind DPSE asserts the remote endpoints with
+NDDS_TypePluginKeyKind dds_setup_key_kind(
+        const AppConfig &config,
+        Lane lane = LANE_BULK);
+
+// Each lane has its own object ids, and the urgent lane its own history
+// depth, heartbeat period and backpressure policy
+void dds_setup_writer_qos(
+        const AppConfig &config,
+        DDS_DataWriterQos *qos,
+        Lane lane = LANE_BULK);
+void dds_setup_reader_qos(
+        const AppConfig &config,
+        DDS_DataReaderQos *qos,
+        Lane lane = LANE_BULK);
+
+// What DPSE is told to expect of the remote endpoints
+void dds_setup_remote_subscription_data(
+        const AppConfig &config,
+        DDS_SubscriptionBuiltinTopicData *data,
+        Lane lane = LANE_BULK);
+void dds_setup_remote_publication_data(
+        const AppConfig &config,
+        DDS_PublicationBuiltinTopicData *data,
+        Lane lane = LANE_BULK);
+
+#endif
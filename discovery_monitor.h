@@ -0,0 +1,136 @@
+// (c) Copyright, Real-Time Innovations, 2021.  All rights reserved.
+// RTI grants Licensee a license to use, modify, compile, and create derivative
+// works of the software solely for use with RTI Connext DDS. Licensee may
+// redistribute copies of the software provided that all such copies are subject
+// to this license. The software is provided "as is", with no warranty of any
+// type, including any warranty for fitness for any purpose. RTI is under no
+// obligation to maintain or support the software. RTI shall not be liable for
+// any incidental or consequential damages arising out of the use or inability
+// to use the software.
+
+#ifndef DISCOVERY_MONITOR_H
+#define DISCOVERY_MONITOR_H
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <iostream>
+#include <mutex>
+
+#include "rti_me_c.h"
+
+#include "binary_log.h"
+#include "startup_profiler.h"
+
+// Tracks how far DPSE discovery has progressed. With DPSE the remote
+// participant and endpoints are asserted statically, but nothing matches
+// until participant announcements have been exchanged with the initial
+// peers. The status listeners feed matched/liveliness changes in here, and
+// main() polls for discovered participants, so every step is timestamped
+// through the StartupProfiler and the publisher can wait for a match before
+// it starts writing.
+class DiscoveryMonitor {
+public:
+    explicit DiscoveryMonitor(StartupProfiler *profiler)
+        : profiler_(profiler),
+          matched_(0),
+          participants_(DDS_SEQUENCE_INITIALIZER)
+    {
+    }
+
+    // Reserve room for the discovered participant handles. Call before the
+    // DomainParticipant is enabled so polling never allocates.
+    bool reserve(DDS_Long max_participants)
+    {
+        return DDS_InstanceHandleSeq_set_maximum(
+                &participants_,
+                max_participants);
+    }
+
+    // --- listener threads ------------------------------------------------
+
+    void on_matched(DDS_Long current_count)
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            matched_.store(current_count, std::memory_order_relaxed);
+        }
+        if (current_count > 0) {
+            record(StartupProfiler::EVENT_FIRST_MATCH);
+            cond_.notify_all();
+        }
+        EXAMPLE_LOG_INFO("matched endpoints = {}", current_count);
+    }
+
+    void on_liveliness_changed(DDS_Long alive_count)
+    {
+        if (alive_count > 0) {
+            record(StartupProfiler::EVENT_WRITER_ALIVE);
+        }
+        EXAMPLE_LOG_INFO("alive remote writers = {}", alive_count);
+    }
+
+    void on_sample()
+    {
+        record(StartupProfiler::EVENT_FIRST_SAMPLE);
+    }
+
+    // --- main thread -----------------------------------------------------
+
+    // record the first time the participant has discovered a remote one
+    void poll_participants(DDS_DomainParticipant *dp)
+    {
+        if (profiler_->has(StartupProfiler::EVENT_PARTICIPANT_DISCOVERED)) {
+            return;
+        }
+        if (DDS_DomainParticipant_get_discovered_participants(
+                    dp,
+                    &participants_) == DDS_RETCODE_OK &&
+                DDS_InstanceHandleSeq_get_length(&participants_) > 0) {
+            record(StartupProfiler::EVENT_PARTICIPANT_DISCOVERED);
+        }
+    }
+
+    // Block until at least min_matched remote endpoints are matched,
+    // polling for participant discovery meanwhile. Returns false on timeout.
+    bool wait_for_match(
+            DDS_DomainParticipant *dp,
+            std::chrono::milliseconds timeout,
+            DDS_Long min_matched = 1)
+    {
+        const std::chrono::milliseconds poll_period(10);
+        auto deadline = std::chrono::steady_clock::now() + timeout;
+        std::unique_lock<std::mutex> lock(mutex_);
+        while (matched_.load(std::memory_order_relaxed) < min_matched) {
+            lock.unlock();
+            poll_participants(dp);
+            lock.lock();
+            if (std::chrono::steady_clock::now() >= deadline) {
+                return false;
+            }
+            cond_.wait_for(lock, poll_period);
+        }
+        return true;
+    }
+
+    DDS_Long matched() const
+    {
+        return matched_.load(std::memory_order_relaxed);
+    }
+
+private:
+    void record(StartupProfiler::Event event)
+    {
+        if (profiler_->record_once(event)) {
+            profiler_->print_event(std::cout, event);
+        }
+    }
+
+    StartupProfiler *profiler_;
+    std::atomic<DDS_Long> matched_;
+    struct DDS_InstanceHandleSeq participants_;
+    std::mutex mutex_;
+    std::condition_variable cond_;
+};
+
+#endif
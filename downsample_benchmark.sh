@@ -0,0 +1,60 @@
+#!/bin/bash
+# (c) Copyright, Real-Time Innovations, 2021.  All rights reserved.
+# RTI grants Licensee a license to use, modify, compile, and create derivative
+# works of the software solely for use with RTI Connext DDS. Licensee may
+# redistribute copies of the software provided that all such copies are subject
+# to this license. The software is provided "as is", with no warranty of any
+# type, including any warranty for fitness for any purpose. RTI is under no
+# obligation to maintain or support the software. RTI shall not be liable for
+# any incidental or consequential damages arising out of the use or inability
+# to use the software.
+
+
+# Subscriber CPU with and without downsampling. For each separation in
+# SEPARATIONS_MS, runs benchmark_runner.sh (one publisher, one subscriber)
+# with downsample.min_separation_ms set to it, then prints one line per
+# separation: samples taken per second, the subscriber's CPU use and its
+# take callback time per sample, and the share of samples the filter
+# discarded. Separation 0 runs without the filter, as the reference.
+#
+#     ./downsample_benchmark.sh objs/x64Linux4gcc7.3.0_cert
+#
+# Environment: SEPARATIONS_MS (default "0 1 10 100"), STREAMS (the
+# schedule.streams value, default "1000:16"), PAYLOAD
+# (publisher.payload_bytes, default 64), DURATION (seconds per separation,
+# default 10), CORES, SETTINGS and CONFIG as for benchmark_runner.sh.
+
+set -u
+
+BIN_DIR=${1:-objs/${RTIME_TARGET_NAME:-x64Linux4gcc7.3.0_cert}}
+SEPARATIONS_MS=${SEPARATIONS_MS:-"0 1 10 100"}
+LOG_DIR=$(mktemp -d /tmp/downsample_benchmark.XXXXXX)
+
+source "$(dirname "$0")/benchmark_common.sh"
+require_binaries
+
+printf "%-6s %12s %8s %13s %11s\n" sep_ms taken/s sub_cpu% \
+        take_ns/sample discarded%
+for separation in $SEPARATIONS_MS; do
+    report=$LOG_DIR/downsample_$separation.txt
+    if ! run_point "downsample_$separation" "${STREAMS:-"1000:16"}" \
+            "${PAYLOAD:-64}" \
+            "${SETTINGS:-} downsample.min_separation_ms=$separation"; then
+        echo "ERROR: no report for separation $separation, see $LOG_DIR"
+        continue
+    fi
+    # the discarded share comes from the subscriber's own stats file
+    discarded=$(awk '
+        $1 == "downsample_delivered" { delivered = $3 }
+        $1 == "downsample_discarded" { discarded = $3 }
+        END {
+            total = delivered + discarded
+            printf "%.1f", (total > 0 ? 100 * discarded / total : 0)
+        }' "$(subscriber_stats "downsample_$separation")")
+    printf "%-6s %12s %8s %13s %11s\n" "$separation" \
+            "$(report_value "$report" delivered_per_s)" \
+            "$(report_value "$report" subscriber_cpu_pct)" \
+            "$(report_value "$report" take_ns_per_sample)" \
+            "$discarded"
+done
+echo "logs in $LOG_DIR"
@@ -0,0 +1,156 @@
+// (c) Copyright, Real-Time Innovations, 2021.  All rights reserved.
+// RTI grants Licensee a license to use, modify, compile, and create derivative
+// works of the software solely for use with RTI Connext DDS. Licensee may
+// redistribute copies of the software provided that all such copies are subject
+// to this license. The software is provided "as is", with no warranty of any
+// type, including any warranty for fitness for any purpose. RTI is under no
+// obligation to maintain or support the software. RTI shall not be liable for
+// any incidental or consequential damages arising out of the use or inability
+// to use the software.
+
+#ifndef DOWNSAMPLE_FILTER_H
+#define DOWNSAMPLE_FILTER_H
+
+#include <atomic>
+#include <cstdint>
+#include <iostream>
+#include <memory>
+
+#include "rti_me_c.h"
+
+// Per-key minimum separation between delivered samples, for consumers that
+// need far fewer updates than the writer sends (e.g. a 10 Hz display on a
+// 1 kHz topic). This is what the TIME_BASED_FILTER QoS does on the reader,
+// which Connext Micro does not implement, so the listener applies it: a
+// sample of an id is delivered only if min_separation has passed since the
+// last delivered sample of that id, by source timestamp. Anything else is
+// discarded before the application looks at it.
+//
+// The per-id times live in a flat, open-addressed table sized once at
+// construction, like LatestValueCache. An id that finds the table full is
+// always delivered and counted as an overflow.
+//
+// due() and mark_delivered() are called from one taking thread at a time;
+// the counters can be read from any thread. A sample only uses up its id's
+// window once it is marked delivered, so one that fails a later check
+// (e.g. integrity) does not hold back the next valid sample of the id.
+class DownsampleFilter {
+public:
+    // min_separation_ns == 0 disables the filter; capacity is rounded up
+    // to a power of two
+    DownsampleFilter(std::int64_t min_separation_ns, std::size_t capacity)
+        : min_separation_ns_(min_separation_ns),
+          mask_(min_separation_ns > 0 ? round_up_pow2(capacity) - 1 : 0),
+          slots_(min_separation_ns > 0 ? new Slot[mask_ + 1] : NULL)
+    {
+    }
+
+    bool enabled() const { return min_separation_ns_ > 0; }
+
+    // false (and counted as discarded) if the sample of id stamped at
+    // source_ns falls within min_separation of the last delivered one
+    bool due(DDS_Long id, std::int64_t source_ns)
+    {
+        if (!enabled()) {
+            return true;
+        }
+        auto slot = find_or_insert(id);
+        // the first sample of the id, far enough apart, or the source
+        // clock stepped back
+        if (slot != NULL && slot->used && source_ns >= slot->last_ns &&
+                source_ns - slot->last_ns < min_separation_ns_) {
+            discarded_.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+        return true;
+    }
+
+    // start the id's next window at source_ns: the sample due() let
+    // through has been delivered
+    void mark_delivered(DDS_Long id, std::int64_t source_ns)
+    {
+        if (!enabled()) {
+            return;
+        }
+        auto slot = find_or_insert(id);
+        if (slot == NULL) {
+            overflows_.fetch_add(1, std::memory_order_relaxed);
+        } else {
+            slot->used = true;
+            slot->last_ns = source_ns;
+        }
+        delivered_.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    std::uint64_t delivered() const
+    {
+        return delivered_.load(std::memory_order_relaxed);
+    }
+    std::uint64_t discarded() const
+    {
+        return discarded_.load(std::memory_order_relaxed);
+    }
+
+    void print_stats(std::ostream &os) const
+    {
+        if (!enabled()) {
+            return;
+        }
+        auto delivered = this->delivered();
+        auto discarded = this->discarded();
+        auto total = delivered + discarded;
+        os << "downsample: min separation = " << min_separation_ns_ / 1e6
+                << " ms, delivered = " << delivered << ", discarded = "
+                << discarded << " ("
+                << (total > 0 ? 100.0 * discarded / total : 0.0)
+                << "%), overflows = "
+                << overflows_.load(std::memory_order_relaxed) << std::endl;
+    }
+
+private:
+    struct Slot {
+        bool used;
+        DDS_Long id;
+        std::int64_t last_ns;
+
+        Slot() : used(false), id(0), last_ns(0) {}
+    };
+
+    static std::size_t round_up_pow2(std::size_t n)
+    {
+        std::size_t pow2 = 1;
+        while (pow2 < n) {
+            pow2 <<= 1;
+        }
+        return pow2;
+    }
+
+    // a free slot is returned with used still false
+    Slot *find_or_insert(DDS_Long id)
+    {
+        // Fibonacci hashing spreads sequential ids across the table
+        auto i = ((std::uint32_t)id * 2654435769u) & mask_;
+        for (std::size_t probe = 0; probe <= mask_;
+                ++probe, i = (i + 1) & mask_) {
+            auto &slot = slots_[i];
+            if (!slot.used) {
+                slot.id = id;
+                return &slot;
+            }
+            if (slot.id == id) {
+                return &slot;
+            }
+        }
+        return NULL;
+    }
+
+    const std::int64_t min_separation_ns_;
+    const std::size_t mask_;
+    std::unique_ptr<Slot[]> slots_;
+
+    std::atomic<std::uint64_t> delivered_{0};
+    std::atomic<std::uint64_t> discarded_{0};
+    std::atomic<std::uint64_t> overflows_{0};
+};
+
+#endif
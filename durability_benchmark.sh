@@ -0,0 +1,93 @@
+#!/bin/bash
+# (c) Copyright, Real-Time Innovations, 2021.  All rights reserved.
+# RTI grants Licensee a license to use, modify, compile, and create derivative
+# works of the software solely for use with RTI Connext DDS. Licensee may
+# redistribute copies of the software provided that all such copies are subject
+# to this license. The software is provided "as is", with no warranty of any
+# type, including any warranty for fitness for any purpose. RTI is under no
+# obligation to maintain or support the software. RTI shall not be liable for
+# any incidental or consequential damages arising out of the use or inability
+# to use the software.
+
+
+# Late-joiner catch-up and publisher recovery with transient-local
+# durability and the publisher's snapshot file, on this host:
+#
+#   1. start a publisher, let it run for WARMUP seconds, then start a
+#      subscriber: how long the late joiner takes to receive the history
+#   2. kill the publisher with SIGKILL, as a crash would, and start it
+#      again on the same snapshot: how long until its last state is back
+#      on the wire
+#   3. start a second subscriber late: catch-up from the restarted
+#      publisher
+#
+#     ./durability_benchmark.sh objs/x64Linux4gcc7.3.0_cert
+#
+# Environment: STREAMS (the schedule.streams value, default "100:64"),
+# WARMUP (seconds before a subscriber joins, default 5), SETTLE (seconds a
+# subscriber runs, default 3), SETTINGS (extra section.key=value settings
+# for every process) and CONFIG (an extra --config file).
+
+set -u
+
+BIN_DIR=${1:-objs/${RTIME_TARGET_NAME:-x64Linux4gcc7.3.0_cert}}
+STREAMS=${STREAMS:-"100:64"}
+WARMUP=${WARMUP:-5}
+SETTLE=${SETTLE:-3}
+LOG_DIR=$(mktemp -d /tmp/durability_benchmark.XXXXXX)
+
+source "$(dirname "$0")/benchmark_common.sh"
+require_binaries
+
+common_args=(--set qos.reliable=true --set durability.transient_local=true)
+if [ -n "${CONFIG:-}" ]; then
+    common_args+=(--config "$CONFIG")
+fi
+for setting in ${SETTINGS:-}; do
+    common_args+=(--set "$setting")
+done
+
+start_publisher() {
+    "$BIN_DIR/example_publisher" "${common_args[@]}" \
+            --set publisher.wait_for_match=false \
+            --set "schedule.streams=$STREAMS" \
+            --set "durability.snapshot_path=$LOG_DIR/snapshot" \
+            > "$LOG_DIR/$1.log" 2>&1 &
+    pub_pid=$!
+}
+
+# run a subscriber for SETTLE seconds and print its catch-up line
+late_subscriber() {
+    "$BIN_DIR/example_subscriber" "${common_args[@]}" \
+            --set subscriber.print_samples=false \
+            > "$LOG_DIR/$1.log" 2>&1 &
+    local pid=$!
+    sleep "$SETTLE"
+    kill -INT $pid; wait $pid
+    grep "^late joiner:" "$LOG_DIR/$1.log" ||
+            echo "ERROR: no catch-up reported, see $LOG_DIR/$1.log"
+}
+
+echo "== late joiner, publisher running for $WARMUP s"
+start_publisher pub_first
+sleep "$WARMUP"
+late_subscriber sub_first
+
+echo "== publisher killed and restarted on its snapshot"
+kill -KILL $pub_pid; wait $pub_pid 2>/dev/null
+start_publisher pub_restarted
+waited=0
+while ! grep -q "^recovery:" "$LOG_DIR/pub_restarted.log" &&
+        [ $waited -lt 300 ]; do
+    sleep 0.1
+    waited=$((waited + 1))
+done
+grep "^recovery:" "$LOG_DIR/pub_restarted.log" ||
+        echo "ERROR: no recovery reported, see $LOG_DIR/pub_restarted.log"
+
+echo "== late joiner, restarted publisher"
+sleep "$WARMUP"
+late_subscriber sub_restarted
+
+kill -INT $pub_pid; wait $pub_pid
+echo "logs in $LOG_DIR"
@@ -0,0 +1,96 @@
+#!/bin/bash
+# (c) Copyright, Real-Time Innovations, 2021.  All rights reserved.
+# RTI grants Licensee a license to use, modify, compile, and create derivative
+# works of the software solely for use with RTI Connext DDS. Licensee may
+# redistribute copies of the software provided that all such copies are subject
+# to this license. The software is provided "as is", with no warranty of any
+# type, including any warranty for fitness for any purpose. RTI is under no
+# obligation to maintain or support the software. RTI shall not be liable for
+# any incidental or consequential damages arising out of the use or inability
+# to use the software.
+
+# Compare processing samples in the DataReader listener with processing them
+# on the subscriber's epoll loop (subscriber.event_loop). For each mode and
+# each STREAMS load, runs one example_subscriber and one example_publisher on
+# the cyclic scheduler for DURATION seconds, then reports the subscriber's
+# CPU use, samples delivered per second, listener notifications per event
+# loop wakeup, and the average and worst wakeup latency.
+#
+#     ./event_loop_benchmark.sh objs/x64Linux4gcc7.3.0_cert
+#
+# Environment: STREAMS (space-separated schedule.streams values, default
+# "100:1 1000:4 10000:4"), DURATION (seconds, default 10), CONFIG.
+
+set -u
+
+BIN_DIR=${1:-objs/${RTIME_TARGET_NAME:-x64Linux4gcc7.3.0_cert}}
+STREAMS=${STREAMS:-"100:1 1000:4 10000:4"}
+DURATION=${DURATION:-10}
+LOG_DIR=$(mktemp -d /tmp/event_loop_benchmark.XXXXXX)
+CLK_TCK=$(getconf CLK_TCK)
+
+source "$(dirname "$0")/benchmark_common.sh"
+require_binaries
+
+common_args=(--set qos.max_instances=64)
+if [ -n "${CONFIG:-}" ]; then
+    common_args+=(--config "$CONFIG")
+fi
+
+run_one() {
+    local streams=$1 event_loop=$2
+    local name="${streams//[:,]/_}_$event_loop"
+    local sub_log="$LOG_DIR/sub_$name.log"
+    local pub_log="$LOG_DIR/pub_$name.log"
+
+    "$BIN_DIR/example_subscriber" "${common_args[@]}" \
+            --set subscriber.print_samples=false \
+            --set "subscriber.event_loop=$event_loop" > "$sub_log" 2>&1 &
+    local sub_pid=$!
+    "$BIN_DIR/example_publisher" "${common_args[@]}" \
+            --set "schedule.streams=$streams" > "$pub_log" 2>&1 &
+    local pub_pid=$!
+
+    local waited=0
+    while ! grep -q "^schedule:" "$pub_log" && [ $waited -lt 300 ]; do
+        sleep 0.1
+        waited=$((waited + 1))
+    done
+    local start_ticks=$(cpu_ticks $sub_pid)
+    sleep "$DURATION"
+    local end_ticks=$(cpu_ticks $sub_pid)
+
+    kill -INT $pub_pid; wait $pub_pid
+    kill -INT $sub_pid; wait $sub_pid
+
+    local cpu=$(awk -v t=$((end_ticks - start_ticks)) -v hz=$CLK_TCK \
+            -v d=$DURATION 'BEGIN { printf "%.1f", 100 * t / hz / d }')
+    local samples=$(grep "^take stats:" "$sub_log" | tail -1 |
+            sed -n 's/.* samples = \([0-9]*\),.*/\1/p')
+    local line=$(grep "^event loop:" "$sub_log" | tail -1)
+    local notifications=$(echo "$line" |
+            sed -n 's/.*notifications = \([0-9]*\),.*/\1/p')
+    local wakeups=$(echo "$line" | sed -n 's/.*wakeups = \([0-9]*\),.*/\1/p')
+    local avg=$(echo "$line" |
+            sed -n 's/.*avg wakeup latency = \([0-9.e+-]*\) us.*/\1/p')
+    local max=$(echo "$line" |
+            sed -n 's/.*max wakeup latency = \([0-9.e+-]*\) us.*/\1/p')
+    local per_wakeup=$(awk -v n=${notifications:-0} -v w=${wakeups:-0} \
+            'BEGIN { if (w) printf "%.1f", n / w; else print "-" }')
+
+    printf "%-16s  %-8s  %8s  %12s  %10s  %10s  %10s\n" "$streams" \
+            "$([ "$event_loop" = true ] && echo epoll || echo listener)" \
+            "$cpu" \
+            "$(awk -v n=${samples:-0} -v d=$DURATION \
+                    'BEGIN { printf "%.0f", n / d }')" \
+            "$per_wakeup" "${avg:--}" "${max:--}"
+}
+
+echo "logs in $LOG_DIR"
+printf "%-16s  %-8s  %8s  %12s  %10s  %10s  %10s\n" "streams" "mode" \
+        "sub CPU%" "delivered/s" "notif/wake" "avg us" "max us"
+for streams in $STREAMS; do
+    for event_loop in false true; do
+        run_one "$streams" "$event_loop"
+    done
+done
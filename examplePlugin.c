@@ -222,7 +222,7 @@ struct NDDS_Type_Plugin my_typeTypePlugin =
     #endif
     my_typePlugin_copy_sample,
     PluginHelper_get_key_kind,
-    PluginHelper_instance_to_keyhash,
+    my_type_instance_to_keyhash,
     NULL, NULL, NULL, NULL  /* endpoint wrappers not used in C */
 };
 
@@ -252,3 +252,39 @@ my_type_get_key_kind(
     return NDDS_TYPEPLUGIN_USER_KEY;
 }
 
+/* The key is a single CDR_Long, so its maximum serialized size is below the
+ * 16 bytes of a key hash: the hash is the key in big-endian CDR, zero-padded.
+ * Build it directly instead of serializing the key into a stream, as
+ * PluginHelper_instance_to_keyhash does, on every write and every receive.
+ */
+RTI_BOOL
+my_type_instance_to_keyhash(
+    struct NDDS_Type_Plugin *plugin,
+    struct CDR_Stream_t *stream, DDS_KeyHash_t *keyHash, const void *instance,
+    void *param)
+{
+    const my_type *sample = (const my_type *)instance;
+    RTI_UINT32 id;
+    RTI_UINT32 i;
+
+    UNUSED_ARG(plugin);
+    UNUSED_ARG(stream);
+    UNUSED_ARG(param);
+    if ((keyHash == NULL) || (instance == NULL))
+    {
+        return RTI_FALSE;
+    }
+
+    id = (RTI_UINT32)sample->id;
+    keyHash->value[0] = (DDS_Octet)(id >> 24);
+    keyHash->value[1] = (DDS_Octet)(id >> 16);
+    keyHash->value[2] = (DDS_Octet)(id >> 8);
+    keyHash->value[3] = (DDS_Octet)id;
+    for (i = 4; i < sizeof(keyHash->value); ++i)
+    {
+        keyHash->value[i] = 0;
+    }
+
+    return RTI_TRUE;
+}
+
@@ -0,0 +1,390 @@
+// (c) Copyright, Real-Time Innovations, 2021.  All rights reserved.
+// RTI grants Licensee a license to use, modify, compile, and create derivative
+// works of the software solely for use with RTI Connext DDS. Licensee may
+// redistribute copies of the software provided that all such copies are subject
+// to this license. The software is provided "as is", with no warranty of any
+// type, including any warranty for fitness for any purpose. RTI is under no
+// obligation to maintain or support the software. RTI shall not be liable for
+// any incidental or consequential damages arising out of the use or inability
+// to use the software.
+
+// The publisher's and the subscriber's DomainParticipants in one process:
+// writes inprocess.samples samples and reports what a write call costs and
+// how long a sample takes to reach the reader's listener when no process
+// boundary is crossed, over the intra-process transport or UDP loopback.
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <iostream>
+#include <thread>
+
+// headers from Connext DDS Micro/Cert installation
+#include "rti_me_c.h"
+#include "disc_dpse/disc_dpse_dpsediscovery.h"
+
+// rtiddsgen generated headers
+#include "example.h"
+#include "examplePlugin.h"
+#include "exampleSupport.h"
+
+#include "common_config.h"
+#include "app_config.h"
+#include "startup_profiler.h"
+#include "dds_setup.h"
+#include "discovery_monitor.h"
+#include "shutdown_signal.h"
+#include "cyclic_scheduler.h"
+#include "backpressure_writer.h"
+#include "latency_stats.h"
+#include "binary_log.h"
+
+// state shared between main() and the DataReader listener
+struct InprocessContext {
+    // write_w_timestamp stamps with CLOCK_MONOTONIC, so source, reception
+    // and processing times are all on one clock
+    OneWayLatency latency{true};
+    // source timestamp to the listener having the sample
+    LatencyStats delivery;
+    std::atomic<std::uint64_t> received{0};
+    DiscoveryMonitor writer_discovery;
+    DiscoveryMonitor reader_discovery;
+    // every listener callback runs inside it; closed by the teardowns
+    CallbackGate listener_gate;
+
+    explicit InprocessContext(StartupProfiler *profiler)
+        : writer_discovery(profiler),
+          reader_discovery(profiler)
+    {
+    }
+};
+
+extern "C" void my_typeInprocess_on_data_available(
+        void *listener_data,
+        DDS_DataReader *reader)
+{
+    auto context = static_cast<InprocessContext *>(listener_data);
+    CallbackGate::Scope scope(&context->listener_gate);
+    if (!scope.entered()) {
+        return;
+    }
+    auto hw_reader = my_typeDataReader_narrow(reader);
+    struct DDS_SampleInfoSeq info_seq = DDS_SEQUENCE_INITIALIZER;
+    struct my_typeSeq sample_seq = DDS_SEQUENCE_INITIALIZER;
+    auto realtime_offset_ns = OneWayLatency::realtime_offset_ns();
+
+    for (;;) {
+        auto retcode = my_typeDataReader_take(
+                hw_reader,
+                &sample_seq,
+                &info_seq,
+                DDS_LENGTH_UNLIMITED,
+                DDS_ANY_SAMPLE_STATE,
+                DDS_ANY_VIEW_STATE,
+                DDS_ANY_INSTANCE_STATE);
+        if (retcode == DDS_RETCODE_NO_DATA) {
+            break;
+        } else if (retcode != DDS_RETCODE_OK) {
+            EXAMPLE_LOG_ERROR("failed to take data, retcode = {}", retcode);
+            break;
+        }
+        auto processed_ns = monotonic_now_ns();
+        auto taken = my_typeSeq_get_length(&sample_seq);
+        for (DDS_Long i = 0; i < taken; ++i) {
+            auto sample_info = DDS_SampleInfoSeq_get_reference(&info_seq, i);
+            if (!sample_info->valid_data) {
+                continue;
+            }
+            context->latency.record(
+                    *sample_info,
+                    processed_ns,
+                    realtime_offset_ns);
+            context->delivery.record(
+                    processed_ns -
+                    dds_time_to_ns(sample_info->source_timestamp));
+            context->received.fetch_add(1, std::memory_order_relaxed);
+        }
+        my_typeDataReader_return_loan(hw_reader, &sample_seq, &info_seq);
+    }
+}
+
+extern "C" void my_typeInprocess_on_subscription_matched(
+        void *listener_data,
+        DDS_DataReader *reader,
+        const struct DDS_SubscriptionMatchedStatus *status)
+{
+    (void)(reader);  // to suppress -Wunused-parameter warning
+
+    auto context = static_cast<InprocessContext *>(listener_data);
+    CallbackGate::Scope scope(&context->listener_gate);
+    if (scope.entered()) {
+        context->reader_discovery.on_matched(status->current_count);
+    }
+}
+
+extern "C" void my_typeInprocess_on_publication_matched(
+        void *listener_data,
+        DDS_DataWriter *writer,
+        const struct DDS_PublicationMatchedStatus *status)
+{
+    (void)(writer);  // to suppress -Wunused-parameter warning
+
+    auto context = static_cast<InprocessContext *>(listener_data);
+    CallbackGate::Scope scope(&context->listener_gate);
+    if (scope.entered()) {
+        context->writer_discovery.on_matched(status->current_count);
+    }
+}
+
+// "name: samples = N, avg = A us, p50/p99/max = x/y/z us"
+static void print_latency(
+        std::ostream &os,
+        const char *name,
+        LatencyStats *stats)
+{
+    auto snapshot = stats->take_interval();
+    os << name << ": samples = " << snapshot.count << ", avg = "
+            << (snapshot.count ? snapshot.total_ns / 1000.0 / snapshot.count
+                    : 0.0)
+            << " us, p50/p99/max = " << snapshot.percentile_us(0.5) << "/"
+            << snapshot.percentile_us(0.99) << "/"
+            << snapshot.max_ns / 1000.0 << " us" << std::endl;
+}
+
+int main(int argc, char *argv[])
+{
+    DDS_ReturnCode_t retcode;
+    StartupProfiler profiler;
+    install_shutdown_handler();
+    BinaryLogger logger;
+
+    // load the deployment's settings before anything else
+    AppConfig config;
+    if (!app_config_from_command_line(&config, &argc, argv, std::cout)) {
+        std::cout << "usage: " << argv[0]
+                << " [--config FILE] [--set section.key=value]..."
+                << std::endl;
+        return -1;
+    }
+    // the endpoints here write and take my_type itself
+    if (config.batch_enabled) {
+        std::cout << "ERROR: example_inprocess does not batch, "
+                << "set batch.enabled = false" << std::endl;
+        return -1;
+    }
+    if (!config.lanes_urgent_ids.empty()) {
+        std::cout << "ERROR: example_inprocess has a single lane, "
+                << "set lanes.urgent_ids empty" << std::endl;
+        return -1;
+    }
+    if (config.print_config) {
+        app_config_print(config, std::cout);
+    }
+    profiler.mark("load config");
+    InprocessContext context(&profiler);
+
+    if (!dds_setup_register_components(config, &profiler)) {
+        return -1;
+    }
+
+    // The two participants are the same ones the two applications create,
+    // so DPSE matches them exactly as it does across processes
+    ParticipantSetup pub_setup;
+    pub_setup.name = config.publisher_name;
+    pub_setup.initial_peer = config.publisher_initial_peer;
+    pub_setup.intra_user_traffic = config.inprocess_intra_transport;
+    ParticipantSetup sub_setup;
+    sub_setup.name = app_config_subscriber_name(config, 0);
+    sub_setup.initial_peer = config.subscriber_initial_peer;
+    sub_setup.intra_user_traffic = config.inprocess_intra_transport;
+
+    auto pub_dp = dds_setup_create_participant(config, pub_setup, &profiler);
+    auto sub_dp = dds_setup_create_participant(config, sub_setup, &profiler);
+    // after context, which both listeners use; the reader's side goes first
+    ParticipantTeardown pub_teardown(pub_dp, &context.listener_gate);
+    ParticipantTeardown sub_teardown(sub_dp, &context.listener_gate);
+    if (pub_dp == NULL || sub_dp == NULL) {
+        return -1;
+    }
+    auto pub_topic = dds_setup_create_topic(pub_dp, config, &profiler);
+    auto sub_topic = dds_setup_create_topic(sub_dp, config, &profiler);
+
+    // each participant expects the other one
+    retcode = DPSE_RemoteParticipant_assert(pub_dp, sub_setup.name.c_str());
+    if (retcode == DDS_RETCODE_OK) {
+        retcode = DPSE_RemoteParticipant_assert(
+                sub_dp,
+                pub_setup.name.c_str());
+    }
+    if (retcode != DDS_RETCODE_OK) {
+        std::cout << "ERROR: failed to assert remote participant" << std::endl;
+    }
+    profiler.mark("assert remote participant");
+
+    auto publisher = DDS_DomainParticipant_create_publisher(
+            pub_dp,
+            &DDS_PUBLISHER_QOS_DEFAULT,
+            NULL,
+            DDS_STATUS_MASK_NONE);
+    if (publisher == NULL) {
+        std::cout << "ERROR: Publisher == NULL" << std::endl;
+    }
+    struct DDS_DataWriterQos dw_qos = DDS_DataWriterQos_INITIALIZER;
+    dds_setup_writer_qos(config, &dw_qos);
+    dw_qos.writer_resource_limits.max_remote_readers = 1;
+    struct DDS_DataWriterListener dw_listener =
+            DDS_DataWriterListener_INITIALIZER;
+    dw_listener.on_publication_matched =
+            my_typeInprocess_on_publication_matched;
+    dw_listener.as_listener.listener_data = &context;
+    auto datawriter = DDS_Publisher_create_datawriter(
+            publisher,
+            pub_topic,
+            &dw_qos,
+            &dw_listener,
+            DDS_PUBLICATION_MATCHED_STATUS);
+    if (datawriter == NULL) {
+        std::cout << "ERROR: datawriter == NULL" << std::endl;
+    }
+    pub_teardown.add_writer(datawriter);
+    profiler.mark("create datawriter");
+
+    auto subscriber = DDS_DomainParticipant_create_subscriber(
+            sub_dp,
+            &DDS_SUBSCRIBER_QOS_DEFAULT,
+            NULL,
+            DDS_STATUS_MASK_NONE);
+    if (subscriber == NULL) {
+        std::cout << "ERROR: subscriber == NULL" << std::endl;
+    }
+    struct DDS_DataReaderQos dr_qos = DDS_DataReaderQos_INITIALIZER;
+    dds_setup_reader_qos(config, &dr_qos);
+    struct DDS_DataReaderListener dr_listener =
+            DDS_DataReaderListener_INITIALIZER;
+    dr_listener.on_data_available = my_typeInprocess_on_data_available;
+    dr_listener.on_subscription_matched =
+            my_typeInprocess_on_subscription_matched;
+    dr_listener.as_listener.listener_data = &context;
+    auto datareader = DDS_Subscriber_create_datareader(
+            subscriber,
+            DDS_Topic_as_topicdescription(sub_topic),
+            &dr_qos,
+            &dr_listener,
+            DDS_DATA_AVAILABLE_STATUS | DDS_SUBSCRIPTION_MATCHED_STATUS);
+    if (datareader == NULL) {
+        std::cout << "ERROR: datareader == NULL" << std::endl;
+    }
+    sub_teardown.add_reader(datareader);
+    profiler.mark("create datareader");
+
+    struct DDS_SubscriptionBuiltinTopicData rem_subscription_data =
+            DDS_SubscriptionBuiltinTopicData_INITIALIZER;
+    dds_setup_remote_subscription_data(config, &rem_subscription_data);
+    retcode = DPSE_RemoteSubscription_assert(
+            pub_dp,
+            sub_setup.name.c_str(),
+            &rem_subscription_data,
+            dds_setup_key_kind(config));
+    if (retcode != DDS_RETCODE_OK) {
+        std::cout << "ERROR: failed to assert remote subscription"
+                << std::endl;
+    }
+    struct DDS_PublicationBuiltinTopicData rem_publication_data =
+            DDS_PublicationBuiltinTopicData_INITIALIZER;
+    dds_setup_remote_publication_data(config, &rem_publication_data);
+    retcode = DPSE_RemotePublication_assert(
+            sub_dp,
+            pub_setup.name.c_str(),
+            &rem_publication_data,
+            dds_setup_key_kind(config));
+    if (retcode != DDS_RETCODE_OK) {
+        std::cout << "ERROR: failed to assert remote publication" << std::endl;
+    }
+    profiler.mark("assert remote endpoints");
+
+    auto sample = my_type_create();
+    if (sample == NULL) {
+        std::cout << "ERROR: failed my_type_create" << std::endl;
+        return -1;
+    }
+    if (!context.writer_discovery.reserve(
+                config.remote_participant_allocation) ||
+            !context.reader_discovery.reserve(
+                config.remote_participant_allocation)) {
+        std::cout << "ERROR: failed to reserve discovered participants"
+                << std::endl;
+    }
+
+    // the reader's side first, so it is listening when the writer announces
+    if (DDS_Entity_enable(DDS_DomainParticipant_as_entity(sub_dp)) !=
+                DDS_RETCODE_OK ||
+            DDS_Entity_enable(DDS_DomainParticipant_as_entity(pub_dp)) !=
+                DDS_RETCODE_OK) {
+        std::cout << "ERROR: failed to enable entity" << std::endl;
+    }
+    profiler.mark_enabled();
+    profiler.print_phases(std::cout);
+
+    if (!context.writer_discovery.wait_for_match(
+                pub_dp,
+                std::chrono::milliseconds(config.match_timeout_ms))) {
+        std::cout << "ERROR: the reader was not matched after "
+                << config.match_timeout_ms << " ms" << std::endl;
+        return -1;
+    }
+
+    // a blocking writer: every sample is delivered, so the two sides of the
+    // measurement count the same samples
+    BackpressureWriter writer(
+            my_typeDataWriter_narrow(datawriter),
+            BACKPRESSURE_BLOCK,
+            config.backpressure_staging_capacity,
+            true);
+    LatencyStats write_cost;
+    std::uint64_t written = 0;
+    std::uint64_t failed = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (auto i = 0; i < config.inprocess_samples && !shutdown_requested();
+            ++i) {
+        sample->id = i % config.max_instances;
+        snprintf(sample->msg, k_my_type_msg_max_length + 1, "sample #%d", i);
+        auto before_ns = monotonic_now_ns();
+        auto result = writer.write(*sample);
+        write_cost.record(monotonic_now_ns() - before_ns);
+        if (result == BackpressureWriter::RESULT_FAILED) {
+            ++failed;
+        } else {
+            ++written;
+        }
+        if (config.inprocess_write_period_us > 0) {
+            std::this_thread::sleep_for(std::chrono::microseconds(
+                    config.inprocess_write_period_us));
+        }
+    }
+    auto elapsed = std::chrono::duration<double>(
+            std::chrono::steady_clock::now() - start).count();
+
+    // give the last samples a moment to arrive
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(1);
+    while (context.received.load(std::memory_order_relaxed) < written &&
+            std::chrono::steady_clock::now() < deadline) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    sub_teardown.shutdown();
+    pub_teardown.shutdown();
+
+    std::cout << "inprocess: transport = "
+            << (config.inprocess_intra_transport ? "intra" : "udp")
+            << ", written = " << written << ", failed = " << failed
+            << ", received = "
+            << context.received.load(std::memory_order_relaxed)
+            << ", rate = " << (elapsed > 0 ? written / elapsed : 0.0)
+            << " samples/s" << std::endl;
+    print_latency(std::cout, "write call", &write_cost);
+    print_latency(std::cout, "delivery", &context.delivery);
+    context.latency.print_interval(
+            std::cout,
+            static_cast<std::int64_t>(elapsed));
+    return 0;
+}
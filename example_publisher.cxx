@@ -8,224 +8,390 @@
 // any incidental or consequential damages arising out of the use or inability
 // to use the software.
 
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
 #include <iostream>
-#include <sstream>
+#include <thread>
+#include <vector>
 #include <unistd.h>
 
 // headers from Connext DDS Micro/Cert installation
 #include "rti_me_c.h"
 #include "disc_dpse/disc_dpse_dpsediscovery.h"
-#include "wh_sm/wh_sm_history.h"
-#include "rh_sm/rh_sm_history.h"
-#include "netio/netio_udp.h"
 
 // rtiddsgen generated headers
 #include "example.h"
 #include "examplePlugin.h"
 #include "exampleSupport.h"
+#include "sample_batch.h"
 
 #include "common_config.h"
+#include "app_config.h"
+#include "startup_profiler.h"
+#include "dds_setup.h"
+#include "discovery_monitor.h"
+#include "cdr_recording.h"
+#include "shutdown_signal.h"
+#include "cyclic_scheduler.h"
+#include "token_bucket.h"
+#include "backpressure_writer.h"
+#include "lane_router.h"
+#include "batch_accumulator.h"
+#include "crc32c.h"
+#include "plugin_check.h"
+#include "payload_integrity.h"
+#include "sample_snapshot.h"
+#include "trace.h"
+#include "binary_log.h"
+#include "stats_report.h"
+#include "soak_monitor.h"
+
+// what the DataWriter listener uses
+struct PublisherListenerContext {
+    DiscoveryMonitor *discovery;
+    // the callback runs inside it; closed by the teardown
+    CallbackGate gate;
+};
+
+extern "C" void my_typePublisher_on_publication_matched(
+        void *listener_data,
+        DDS_DataWriter *writer,
+        const struct DDS_PublicationMatchedStatus *status)
+{
+    (void)(writer);  // to suppress -Wunused-parameter warning
 
+    auto context = static_cast<PublisherListenerContext *>(listener_data);
+    CallbackGate::Scope scope(&context->gate);
+    if (scope.entered()) {
+        context->discovery->on_matched(status->current_count);
+    }
+}
 
-int main(void)
+// bytes a sample takes on the wire: encapsulation header, id, string
+static std::uint32_t sample_wire_size(const my_type &sample)
 {
-    DDS_ReturnCode_t retcode;
+    return 4 + 4 + 4 + static_cast<std::uint32_t>(std::strlen(sample.msg)) + 1;
+}
 
-    auto dpf = DDS_DomainParticipantFactory_get_instance();
-    auto registry = DDS_DomainParticipantFactory_get_registry(dpf);
-
-    // register writer history
-    if (!RT_Registry_register(
-            registry, 
-            DDSHST_WRITER_DEFAULT_HISTORY_NAME,
-            WHSM_HistoryFactory_get_interface(), 
-            NULL, 
-            NULL))
-    {
-        std::cout << "ERROR: failed to register wh" << std::endl;
-    }
-    // register reader history
-    if (!RT_Registry_register(
-            registry, 
-            DDSHST_READER_DEFAULT_HISTORY_NAME,
-            RHSM_HistoryFactory_get_interface(), 
-            NULL, 
-            NULL))
-    {
-        std::cout << "ERROR: failed to register rh" << std::endl;
-    }
-
-    // Set up the UDP transport's allowed interfaces. To do this we:
-    // (1) unregister the UDP transport
-    // (2) name the allowed interfaces
-    // (3) re-register the transport
-    if(!RT_Registry_unregister(
-            registry, 
-            NETIO_DEFAULT_UDP_NAME, 
-            NULL, 
-            NULL)) 
-    {
-        std::cout << "ERROR: failed to unregister udp" << std::endl;
-    }
-
-    auto udp_property = (struct UDP_InterfaceFactoryProperty *)malloc(
-            sizeof(struct UDP_InterfaceFactoryProperty));
-    if (udp_property == NULL) {
-        std::cout << "ERROR: failed to allocate udp properties" << std::endl;
-    }
-
-    *udp_property = UDP_INTERFACE_FACTORY_PROPERTY_DEFAULT;
-    udp_property->disable_auto_interface_config = RTI_TRUE;
-
-    if (!DDS_StringSeq_set_maximum(&udp_property->allow_interface,2)) {
-        printf("failed to set allow_interface maximum\n");
-        return -1;
+// pad msg with filler up to publisher.payload_bytes characters
+static void pad_payload(my_type *sample, int payload_bytes)
+{
+    auto length = static_cast<int>(std::strlen(sample->msg));
+    if (length < payload_bytes) {
+        std::memset(sample->msg + length, '.', payload_bytes - length);
+        sample->msg[payload_bytes] = '\0';
     }
-    if (!DDS_StringSeq_set_length(&udp_property->allow_interface,2)) {
-        printf("failed to set allow_interface length\n");
-        return -1;
+}
+
+// Everything a sample can pass through on its way out
+struct WritePath {
+    TokenBucket *flow;
+    BackpressureWriter *writer;
+    BatchAccumulator *batcher;
+    SampleSnapshot *snapshot;
+    // the ids in lanes.urgent_ids go to urgent_writer instead
+    const LaneRouter *router;
+    BackpressureWriter *urgent_writer;
+};
+
+// Every write goes through here, so the flow controller sees all bulk
+// traffic and the backpressure policy applies to all of it. The integrity
+// trailer is added last, over the payload as written. With batching the
+// sample goes into the open batch instead, and counts as written once it
+// is packed. A sample on the urgent lane goes straight to its own writer,
+// past the flow controller and the batch. A sample that goes out (or is
+// staged to) becomes its id's entry in the snapshot.
+static BackpressureWriter::Result write_sample(
+        const AppConfig &config,
+        const WritePath &path,
+        my_type *sample)
+{
+    if (config.integrity_enabled && !integrity_seal(sample)) {
+        EXAMPLE_LOG_ERROR(
+                "msg of id {} is too long for the integrity trailer",
+                sample->id);
+        return BackpressureWriter::RESULT_FAILED;
+    }
+    BackpressureWriter::Result result;
+    if (path.router->route(*sample) == LANE_URGENT) {
+        EXAMPLE_TRACE_SCOPE("write urgent", sample->id);
+        result = path.urgent_writer->write(*sample);
+    } else {
+        if (path.flow->enabled()) {
+            EXAMPLE_TRACE_SCOPE("flow control", sample->id);
+            path.flow->acquire(sample_wire_size(*sample));
+        }
+        EXAMPLE_TRACE_SCOPE("write", sample->id);
+        if (path.batcher->enabled()) {
+            result = path.batcher->add(*sample)
+                    ? BackpressureWriter::RESULT_WRITTEN
+                    : BackpressureWriter::RESULT_FAILED;
+        } else {
+            result = path.writer->write(*sample);
+        }
     }
+    if (path.snapshot->is_open() &&
+            (result == BackpressureWriter::RESULT_WRITTEN ||
+                    result == BackpressureWriter::RESULT_STAGED)) {
+        path.snapshot->update(*sample);
+    }
+    return result;
+}
 
-    if (!UDP_InterfaceTableEntrySeq_set_maximum(&udp_property->if_table,2)) {
-        printf("failed to set if_table maximum\n");
-        return -1;
+// write whatever is still staged or batched, on every lane
+static void flush_writes(const WritePath &path)
+{
+    path.urgent_writer->flush();
+    path.writer->flush();
+    path.batcher->flush();
+}
+
+// Poll the urgent writer until it has matched min_matched readers. The
+// bulk writer's listener drives DiscoveryMonitor; the urgent lane's
+// readers live in the same participants, so by then they are matching too.
+static bool wait_for_urgent_match(
+        DDS_DataWriter *writer,
+        std::chrono::milliseconds timeout,
+        DDS_Long min_matched)
+{
+    auto deadline = std::chrono::steady_clock::now() + timeout;
+    auto status = DDS_PublicationMatchedStatus();
+    while (DDS_DataWriter_get_publication_matched_status(writer, &status) ==
+                    DDS_RETCODE_OK &&
+            status.current_count < min_matched) {
+        if (std::chrono::steady_clock::now() >= deadline) {
+            return false;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
     }
+    return status.current_count >= min_matched;
+}
 
-    *DDS_StringSeq_get_reference(&udp_property->allow_interface,0) = 
-            DDS_String_dup(k_loopback_name.c_str());
-    if (!UDP_InterfaceTable_add_entry(
-            &udp_property->if_table,
-            k_loopback_ip,
-            k_loopback_mask,
-            k_loopback_name.c_str(),
-            UDP_INTERFACE_INTERFACE_UP_FLAG)) 
-    {
-        std::cout << "ERROR: failed to add " << k_loopback_name.c_str() <<
-                "interface" << std::endl;
-        return -1;
+// Put the state a previous run left in the snapshot back on the wire
+// before anything new is written: the recovery after a restart
+static void republish_snapshot(
+        const AppConfig &config,
+        const WritePath &path,
+        StartupProfiler *profiler,
+        my_type *sample)
+{
+    auto start = std::chrono::steady_clock::now();
+    std::uint64_t written = 0;
+    std::uint64_t failed = 0;
+    path.snapshot->for_each([&](const my_type &saved) {
+        sample->id = saved.id;
+        std::strcpy(sample->msg, saved.msg);
+        // saved as sealed, if the previous run sealed
+        if (config.integrity_enabled) {
+            integrity_unseal(sample);
+        }
+        if (write_sample(config, path, sample) ==
+                BackpressureWriter::RESULT_FAILED) {
+            ++failed;
+        } else {
+            ++written;
+        }
+    });
+    flush_writes(path);
+    profiler->record_once(StartupProfiler::EVENT_SNAPSHOT_REPUBLISHED);
+    std::cout << "recovery: republished " << written << " samples ("
+            << failed << " failed) in "
+            << std::chrono::duration<double, std::milli>(
+                    std::chrono::steady_clock::now() - start).count()
+            << " ms, "
+            << profiler->ms_after_start(
+                    StartupProfiler::EVENT_SNAPSHOT_REPUBLISHED)
+            << " ms after start" << std::endl;
+}
+
+// Republish a recording made by example_subscriber, either at the cadence it
+// was received with or as fast as the writer accepts samples
+static void replay_recording(
+        const AppConfig &config,
+        const CdrReplayer &replayer,
+        const WritePath &path,
+        my_type *sample)
+{
+    auto positions = replayer.select(
+            config.replay_start_ms,
+            config.replay_filter_by_id,
+            config.replay_id);
+    std::cout << "Replaying " << positions.size() << " samples from " 
+            << replayer.segment_count() << " segment(s)" << std::endl;
+    if (positions.empty()) {
+        return;
     }
 
-    *DDS_StringSeq_get_reference(&udp_property->allow_interface,1) = 
-            DDS_String_dup(k_real_nic_name.c_str());
-    if (!UDP_InterfaceTable_add_entry(
-            &udp_property->if_table,
-            k_real_nic_ip,
-            k_real_nic_mask,
-            k_real_nic_name.c_str(),
-            UDP_INTERFACE_INTERFACE_UP_FLAG)) 
-    {
-        std::cout << "ERROR: failed to add " << k_loopback_name.c_str() <<
-                "interface" << std::endl;
-        return -1;
+    auto start = std::chrono::steady_clock::now();
+    auto first_ns = positions.front().reception_ns;
+    std::uint64_t written = 0;
+    std::uint64_t failed = 0;
+    for (const auto &pos : positions) {
+        if (shutdown_requested()) {
+            break;
+        }
+        if (!replayer.read(pos, sample)) {
+            EXAMPLE_LOG_ERROR("failed to read recorded sample");
+            ++failed;
+            continue;
+        }
+        if (!config.replay_as_fast_as_possible) {
+            auto offset = std::chrono::nanoseconds(pos.reception_ns - first_ns);
+            std::this_thread::sleep_until(start + offset);
+            path.batcher->poll();
+        }
+        // recorded as received, sealed if the publisher sealed
+        if (config.integrity_enabled) {
+            integrity_unseal(sample);
+        }
+        if (write_sample(config, path, sample) ==
+                BackpressureWriter::RESULT_FAILED) {
+            ++failed;
+        } else {
+            ++written;
+        }
     }
 
-    //explicitly set the "real NIC" as the multicast interface
-    udp_property->multicast_interface = DDS_String_dup(k_real_nic_name.c_str());
-
-    if(!RT_Registry_register(
-            registry, 
-            NETIO_DEFAULT_UDP_NAME,
-            UDP_InterfaceFactory_get_interface(),
-            (struct RT_ComponentFactoryProperty*)udp_property, NULL))
-    {
-        std::cout << "ERROR: failed to re-register udp" << std::endl;
-    } 
-
-    // register the dpse (discovery) component
-    struct DPSE_DiscoveryPluginProperty discovery_plugin_properties =
-            DPSE_DiscoveryPluginProperty_INITIALIZER;
-    if (!RT_Registry_register(
-            registry,
-            "dpse",
-            DPSE_DiscoveryFactory_get_interface(),
-            &discovery_plugin_properties._parent, 
-            NULL))
-    {
-        std::cout << "ERROR: failed to register dpse" << std::endl;
-    }
-
-    // Now that we've finished the changes to the registry, we will start 
-    // creating DDS entities. By setting autoenable_created_entities to false 
-    // until all of the DDS entities are created, we limit all dynamic memory 
-    // allocation to happen *before* the point where we enable everything.
-    struct DDS_DomainParticipantFactoryQos dpf_qos =
-            DDS_DomainParticipantFactoryQos_INITIALIZER;
-    DDS_DomainParticipantFactory_get_qos(dpf, &dpf_qos);
-    dpf_qos.entity_factory.autoenable_created_entities = DDS_BOOLEAN_FALSE;
-    DDS_DomainParticipantFactory_set_qos(dpf, &dpf_qos);
-
-    // configure discovery prior to creating our DomainParticipant
-    struct DDS_DomainParticipantQos dp_qos = 
-            DDS_DomainParticipantQos_INITIALIZER;
-    if(!RT_ComponentFactoryId_set_name(&dp_qos.discovery.discovery.name, "dpse")) {
-        std::cout << "ERROR: failed to set discovery plugin name" << std::endl;
-    }
-    if(!DDS_StringSeq_set_maximum(&dp_qos.discovery.initial_peers, 1)) {
-        std::cout << "ERROR: failed to set initial peers maximum" << std::endl;
-    }
-    if (!DDS_StringSeq_set_length(&dp_qos.discovery.initial_peers, 1)) {
-        std::cout << "ERROR: failed to set initial peers length" << std::endl;
-    }
-    *DDS_StringSeq_get_reference(&dp_qos.discovery.initial_peers, 0) = 
-            DDS_String_dup(k_publisher_initial_peer.c_str());
-
-    // configure the DomainParticipant's resource limits... these are just 
-    // examples, if there are more remote or local endpoints these values would
-    // need to be increased
-    dp_qos.resource_limits.max_destination_ports = 32;
-    dp_qos.resource_limits.max_receive_ports = 32;
-    dp_qos.resource_limits.local_topic_allocation = 1;
-    dp_qos.resource_limits.local_type_allocation = 1;
-    dp_qos.resource_limits.local_reader_allocation = 1;
-    dp_qos.resource_limits.local_writer_allocation = 1;
-    dp_qos.resource_limits.remote_participant_allocation = 8;
-    dp_qos.resource_limits.remote_reader_allocation = 8;
-    dp_qos.resource_limits.remote_writer_allocation = 8;
-
-    //  set the name of the local DomainParticipant
-    // (this is required for DPSE discovery)
-    strcpy(dp_qos.participant_name.name, k_PARTICIPANT01_NAME.c_str());
-
-    // now the DomainParticipant can be created
-    auto dp = DDS_DomainParticipantFactory_create_participant(
-            dpf, 
-            domain_id,
-            &dp_qos, 
-            NULL,
-            DDS_STATUS_MASK_NONE);
-    if(dp == NULL) {
-        std::cout << "ERROR: failed to create participant" << std::endl;
+    auto elapsed = std::chrono::duration<double>(
+            std::chrono::steady_clock::now() - start).count();
+    std::cout << "Replay done: written = " << written 
+            << ", failed = " << failed 
+            << ", elapsed = " << elapsed << " s"
+            << ", rate = " << (elapsed > 0 ? written / elapsed : 0.0) 
+            << " samples/s" << std::endl;
+}
+
+// Publish schedule.streams from the cyclic scheduler: stream n writes id n,
+// once per period, until shutdown
+static void publish_on_schedule(
+        const AppConfig &config,
+        const WritePath &path,
+        SoakMonitor *soak,
+        my_type *sample)
+{
+    std::vector<StreamRate> rates;
+    CyclicScheduler scheduler;
+    if (!parse_stream_rates(config.schedule_streams, &rates, std::cout) ||
+            !scheduler.build(rates, std::cout)) {
+        return;
     }
+    scheduler.print_table(std::cout);
+
+    // everything the release path touches is allocated up front
+    std::vector<std::uint64_t> sequence(scheduler.stream_count(), 0);
+    std::uint64_t failed = 0;
+    scheduler.run(
+            [&](std::uint32_t stream) {
+                sample->id = static_cast<DDS_Long>(stream);
+                snprintf(
+                        sample->msg,
+                        k_my_type_msg_max_length + 1,
+                        "stream %u sample #%llu",
+                        stream,
+                        static_cast<unsigned long long>(sequence[stream]++));
+                pad_payload(sample, config.payload_bytes);
+                if (write_sample(config, path, sample) ==
+                        BackpressureWriter::RESULT_FAILED) {
+                    ++failed;
+                }
+            },
+            [&path, soak] {
+                // a batch that is not filling up goes out on its deadline
+                path.batcher->poll();
+                if (soak->poll()) {
+                    request_shutdown();
+                }
+                return shutdown_requested();
+            });
+
+    scheduler.print_stats(std::cout);
+    std::cout << "schedule: failed writes = " << failed << std::endl;
+}
 
-    // register the type (my_type, from the idl) with the middleware
-    std::string type_name = "my_type";
-    retcode = DDS_DomainParticipant_register_type(
-            dp,
-            type_name.c_str(),
-            my_typeTypePlugin_get());
-    if(retcode != DDS_RETCODE_OK) {
-        std::cout << "ERROR: failed to register type" << std::endl;
+int main(int argc, char *argv[])
+{
+    DDS_ReturnCode_t retcode;
+    StartupProfiler profiler;
+    install_shutdown_handler();
+    BinaryLogger logger;
+    EXAMPLE_TRACE_SETUP();
+    EXAMPLE_TRACE_THREAD_NAME("main");
+
+    // load the deployment's settings before anything else
+    AppConfig config;
+    if (!app_config_from_command_line(&config, &argc, argv, std::cout)) {
+        std::cout << "usage: " << argv[0] 
+                << " [--config FILE] [--set section.key=value]..." 
+                << std::endl;
+        return -1;
+    }
+    if (config.print_config) {
+        app_config_print(config, std::cout);
+    }
+    profiler.mark("load config");
+    if (config.integrity_enabled) {
+        std::cout << "integrity: crc32c trailer, "
+                << crc32c_implementation() << std::endl;
     }
+    if (config.integrity_benchmark) {
+        crc32c_print_benchmark(std::cout, k_my_type_msg_max_length);
+        profiler.mark("integrity benchmark");
+    }
+    if (config.type_plugin_check) {
+        if (!plugin_check(std::cout)) {
+            return -1;
+        }
+        profiler.mark("plugin check");
+    }
+    DiscoveryMonitor discovery(&profiler);
+    PublisherListenerContext listener_context;
+    listener_context.discovery = &discovery;
 
-    // Create the Topic to which we will publish. Note that the name of the 
-    // Topic is stored in my-topic-name, which was defined in the IDL 
-    auto topic = DDS_DomainParticipant_create_topic(
-            dp,
-            my_topic_name,
-            type_name.c_str(),
-            &DDS_TOPIC_QOS_DEFAULT, 
-            NULL,
-            DDS_STATUS_MASK_NONE);
-    if(topic == NULL) {
-        std::cout << "ERROR: topic == NULL" << std::endl;
+    if (!dds_setup_register_components(config, &profiler)) {
+        return -1;
     }
 
-    // assert remote DomainParticipant
-    retcode = DPSE_RemoteParticipant_assert(dp, k_PARTICIPANT02_NAME.c_str());
-    if(retcode != DDS_RETCODE_OK) {
-        std::cout << "ERROR: failed to assert remote participant" << std::endl;
+    // With several subscriber processes on one host, each takes its own
+    // participant index; "N@address" announces to indexes 0..N there
+    ParticipantSetup setup;
+    setup.name = config.publisher_name;
+    setup.initial_peer = config.publisher_initial_peer;
+    if (config.fanout_subscribers > 1 &&
+            setup.initial_peer.find('@') == std::string::npos) {
+        setup.initial_peer = std::to_string(config.fanout_subscribers) + "@" +
+                setup.initial_peer;
+    }
+    setup.max_destination_ports = 32 + config.fanout_subscribers;
+    // a reader per lane in each subscriber process
+    auto lanes = dds_setup_lane_count(config);
+    setup.remote_reader_allocation =
+            std::max(8, config.fanout_subscribers * lanes);
+    auto dp = dds_setup_create_participant(config, setup, &profiler);
+    // declared after discovery, so the writer stops calling its listener
+    // before discovery goes, whichever way main() returns
+    ParticipantTeardown teardown(dp, &listener_context.gate);
+    auto topic = dds_setup_create_topic(dp, config, &profiler);
+    DDS_Topic *urgent_topic = NULL;
+    if (lanes > 1) {
+        urgent_topic = dds_setup_create_topic(
+                dp, config, &profiler, LANE_URGENT);
     }
 
+    // assert the remote DomainParticipant(s), one per subscriber process
+    for (int k = 0; k < config.fanout_subscribers; ++k) {
+        retcode = DPSE_RemoteParticipant_assert(
+                dp,
+                app_config_subscriber_name(config, k).c_str());
+        if(retcode != DDS_RETCODE_OK) {
+            std::cout << "ERROR: failed to assert remote participant" 
+                    << std::endl;
+        }
+    }
+    profiler.mark("assert remote participant");
+
     // create the Publisher
     auto publisher = DDS_DomainParticipant_create_publisher(
             dp,
@@ -235,53 +401,100 @@ int main(void)
     if(publisher == NULL) {
         std::cout << "ERROR: Publisher == NULL" << std::endl;
     }
+    profiler.mark("create publisher");
 
     // Configure the DataWriter's QoS, then create the DataWriter
     struct DDS_DataWriterQos dw_qos = DDS_DataWriterQos_INITIALIZER;
+    dds_setup_writer_qos(config, &dw_qos);
 
-    dw_qos.protocol.rtps_object_id = k_OBJ_ID_PARTICIPANT01_DW01;
-    dw_qos.reliability.kind = DDS_RELIABLE_RELIABILITY_QOS;
-    dw_qos.resource_limits.max_samples_per_instance = 32;
-    dw_qos.resource_limits.max_instances = 2;
-    dw_qos.resource_limits.max_samples = dw_qos.resource_limits.max_instances *
-            dw_qos.resource_limits.max_samples_per_instance;
-    dw_qos.history.depth = 16;
-    dw_qos.protocol.rtps_reliable_writer.heartbeat_period.sec = 0;
-    dw_qos.protocol.rtps_reliable_writer.heartbeat_period.nanosec = 250000000;
+    // the listener reports when the remote reader is matched
+    struct DDS_DataWriterListener dw_listener = 
+            DDS_DataWriterListener_INITIALIZER;
+    dw_listener.on_publication_matched = 
+            my_typePublisher_on_publication_matched;
+    dw_listener.as_listener.listener_data = &listener_context;
 
     auto datawriter = DDS_Publisher_create_datawriter(
             publisher, 
             topic, 
             &dw_qos,
-            NULL,
-            DDS_STATUS_MASK_NONE);
+            &dw_listener,
+            DDS_PUBLICATION_MATCHED_STATUS);
     if(datawriter == NULL) {
         std::cout << "ERROR: datawriter == NULL" << std::endl;
     }   
+    teardown.add_writer(datawriter);
+    profiler.mark("create datawriter");
+
+    // the urgent lane's writer, with its own QoS; its matches are polled
+    DDS_DataWriter *urgent_datawriter = NULL;
+    if (urgent_topic != NULL) {
+        struct DDS_DataWriterQos urgent_dw_qos = DDS_DataWriterQos_INITIALIZER;
+        dds_setup_writer_qos(config, &urgent_dw_qos, LANE_URGENT);
+        urgent_datawriter = DDS_Publisher_create_datawriter(
+                publisher,
+                urgent_topic,
+                &urgent_dw_qos,
+                NULL,
+                DDS_STATUS_MASK_NONE);
+        if (urgent_datawriter == NULL) {
+            std::cout << "ERROR: urgent datawriter == NULL" << std::endl;
+        }
+        profiler.mark("create urgent datawriter");
+    }
 
-    // setup information about the subscriber we are expecting to discover 
-    struct DDS_SubscriptionBuiltinTopicData rem_subscription_data =
-            DDS_SubscriptionBuiltinTopicData_INITIALIZER;
-    rem_subscription_data.key.value[DDS_BUILTIN_TOPIC_KEY_OBJECT_ID] = 
-            k_OBJ_ID_PARTICIPANT02_DR01;
-    rem_subscription_data.topic_name = DDS_String_dup(my_topic_name);
-    rem_subscription_data.type_name = DDS_String_dup(type_name.c_str());
-    rem_subscription_data.reliability.kind = DDS_RELIABLE_RELIABILITY_QOS;
-
-    retcode = DPSE_RemoteSubscription_assert(
-            dp,
-            k_PARTICIPANT02_NAME.c_str(),
-            &rem_subscription_data,
-            my_type_get_key_kind(my_typeTypePlugin_get(), NULL));
-    if (retcode != DDS_RETCODE_OK) {
-        std::cout << "ERROR: failed to assert remote publication" << std::endl;
-    }    
+    // setup information about the subscriber(s) we are expecting to
+    // discover: the same reader, one per lane, in every subscriber process
+    for (int lane = LANE_BULK; lane < lanes; ++lane) {
+        struct DDS_SubscriptionBuiltinTopicData rem_subscription_data =
+                DDS_SubscriptionBuiltinTopicData_INITIALIZER;
+        dds_setup_remote_subscription_data(
+                config, &rem_subscription_data, static_cast<Lane>(lane));
+        for (int k = 0; k < config.fanout_subscribers; ++k) {
+            retcode = DPSE_RemoteSubscription_assert(
+                    dp,
+                    app_config_subscriber_name(config, k).c_str(),
+                    &rem_subscription_data,
+                    dds_setup_key_kind(config, static_cast<Lane>(lane)));
+            if (retcode != DDS_RETCODE_OK) {
+                std::cout << "ERROR: failed to assert remote subscription" 
+                        << std::endl;
+            }
+        }
+    }
+    profiler.mark("assert remote subscription");
 
     // create the data sample that we will write
     auto sample = my_type_create();
     if(sample == NULL) {
         std::cout << "ERROR: failed my_type_create" << std::endl;
     }
+    profiler.mark("create sample");
+
+    // map the recording to replay, if any, before enable
+    CdrReplayer replayer;
+    if (!config.replay_prefix.empty()) {
+        if (!replayer.open(config.replay_prefix, std::cout)) {
+            return -1;
+        }
+        profiler.mark("open recording");
+    }
+    // and the snapshot, whose contents are republished once matched
+    SampleSnapshot snapshot;
+    if (!config.durability_snapshot_path.empty()) {
+        if (!snapshot.open(
+                    config.durability_snapshot_path,
+                    config.max_instances,
+                    std::cout)) {
+            return -1;
+        }
+        profiler.mark("open snapshot");
+    }
+
+    if (!discovery.reserve(config.remote_participant_allocation)) {
+        std::cout << "ERROR: failed to reserve discovered participants" 
+                << std::endl;
+    }
 
     // Finally, now that all of the entities are created, we can enable them all
     auto entity = DDS_DomainParticipant_as_entity(dp);
@@ -289,28 +502,174 @@ int main(void)
     if(retcode != DDS_RETCODE_OK) {
         std::cout << "ERROR: failed to enable entity" << std::endl;
     }
+    profiler.mark_enabled();
+    profiler.print_phases(std::cout);
+
+    // Hold off the write loop until the subscriber(s) have been matched, so
+    // the first samples are not written before the remote readers exist. 
+    if (config.wait_for_match) {
+        std::cout << "Waiting for " << config.fanout_subscribers 
+                << " matching subscriber(s)..." << std::endl;
+        if (!discovery.wait_for_match(
+                    dp, 
+                    std::chrono::milliseconds(config.match_timeout_ms),
+                    config.fanout_subscribers)) {
+            std::cout << "WARNING: " << discovery.matched() << " of " 
+                    << config.fanout_subscribers 
+                    << " subscribers matched after " 
+                    << config.match_timeout_ms << " ms, writing anyway" 
+                    << std::endl;
+        }
+        if (urgent_datawriter != NULL &&
+                !wait_for_urgent_match(
+                        urgent_datawriter,
+                        std::chrono::milliseconds(config.match_timeout_ms),
+                        config.fanout_subscribers)) {
+            std::cout << "WARNING: urgent lane not matched by all "
+                    << config.fanout_subscribers
+                    << " subscribers, writing anyway" << std::endl;
+        }
+    }
 
-    // Now we can narrow (downcast) the DataWriter and write some samples
-    auto hw_datawriter = my_typeDataWriter_narrow(datawriter);
-    auto i = 0;
-    while (1) {
+    // Now we can narrow (downcast) the DataWriter and write some samples,
+    // paced by the flow controller when one is configured. With batching
+    // the samples only reach the DataWriter inside batches.
+    my_typeDataWriter *hw_datawriter = NULL;
+    my_type_batchDataWriter *batch_datawriter = NULL;
+    if (config.batch_enabled) {
+        batch_datawriter = my_type_batchDataWriter_narrow(datawriter);
+    } else {
+        hw_datawriter = my_typeDataWriter_narrow(datawriter);
+    }
+    BatchAccumulator batcher(
+            batch_datawriter,
+            config.batch_max_records,
+            config.batch_max_bytes,
+            static_cast<std::int64_t>(config.batch_max_delay_us) * 1000,
+            config.latency_monotonic_source_timestamp);
+    TokenBucket flow(config.flow_bytes_per_second, config.flow_burst_bytes);
+    auto policy = BACKPRESSURE_BLOCK;
+    parse_backpressure_policy(config.backpressure_policy, &policy);
+    BackpressureWriter writer(
+            hw_datawriter,
+            policy,
+            config.backpressure_staging_capacity,
+            config.latency_monotonic_source_timestamp);
+    // the urgent lane is never batched and has a policy of its own
+    std::vector<DDS_Long> urgent_ids;
+    parse_lane_ids(config.lanes_urgent_ids, &urgent_ids, std::cout);
+    LaneRouter router(urgent_ids);
+    auto urgent_policy = BACKPRESSURE_BLOCK;
+    parse_backpressure_policy(
+            config.lanes_urgent_backpressure_policy, &urgent_policy);
+    BackpressureWriter urgent_writer(
+            urgent_datawriter != NULL
+                    ? my_typeDataWriter_narrow(urgent_datawriter) : NULL,
+            urgent_policy,
+            config.backpressure_staging_capacity,
+            config.latency_monotonic_source_timestamp);
+    WritePath path = {
+        &flow, &writer, &batcher, &snapshot, &router, &urgent_writer
+    };
+    SoakMonitor soak(
+            config,
+            [&writer, &urgent_writer, &batcher](SoakCounters *counters) {
+                counters->samples = writer.written() +
+                        urgent_writer.written() + batcher.records_written();
+                counters->protocol_events =
+                        writer.writer_full() + urgent_writer.writer_full();
+            });
+    auto publish_start = std::chrono::steady_clock::now();
+    auto recovered = snapshot.loaded();
+    if (recovered > 0) {
+        republish_snapshot(config, path, &profiler, sample);
+    }
+    if (!config.replay_prefix.empty()) {
+        replay_recording(config, replayer, path, sample);
+    } else if (!config.schedule_streams.empty()) {
+        publish_on_schedule(config, path, &soak, sample);
+    } else {
+        auto i = 0;
+        while (!shutdown_requested()) {
         
-        // add some data to the sample
-        std::ostringstream msg;  
-        msg << "sample #" << i;
-        msg.str().copy(sample->msg, 128);
-
-        retcode = my_typeDataWriter_write(
-                hw_datawriter, 
-                sample, 
-                &DDS_HANDLE_NIL);
-        if(retcode != DDS_RETCODE_OK) {
-            std::cout << "ERROR: Failed to write sample" << std::endl;
-        } else {
-            std::cout << "Wrote sample " << i << std::endl;
-            i++;
-        } 
-        sleep(1); // sleep 1s between writes 
+            // add some data to the sample
+            snprintf(sample->msg, k_my_type_msg_max_length + 1,
+                    "sample #%d", i);
+            pad_payload(sample, config.payload_bytes);
+
+            auto result = write_sample(config, path, sample);
+            if (result == BackpressureWriter::RESULT_FAILED) {
+                EXAMPLE_LOG_ERROR("Failed to write sample");
+            } else {
+                if (result == BackpressureWriter::RESULT_WRITTEN) {
+                    EXAMPLE_LOG_INFO("Wrote sample {}", i);
+                } else {
+                    EXAMPLE_LOG_WARNING(
+                            "Writer full, sample {} {}",
+                            i,
+                            result == BackpressureWriter::RESULT_STAGED
+                                    ? "staged" : "dropped");
+                }
+                if (profiler.record_once(
+                            StartupProfiler::EVENT_FIRST_SAMPLE)) {
+                    profiler.print_event(
+                            std::cout, 
+                            StartupProfiler::EVENT_FIRST_SAMPLE);
+                }
+                i++;
+            } 
+            discovery.poll_participants(dp);
+            if (soak.poll()) {
+                request_shutdown();
+            }
+            // sleep between writes
+            std::this_thread::sleep_for(
+                    std::chrono::milliseconds(config.write_period_ms));
+            batcher.poll();
+        }
     }
-}
 
+    // one last chance for anything still staged or batched
+    flush_writes(path);
+    teardown.shutdown();
+    auto publish_elapsed = std::chrono::duration<double>(
+            std::chrono::steady_clock::now() - publish_start).count();
+    if (batcher.enabled()) {
+        batcher.print_stats(std::cout);
+    } else {
+        writer.print_stats(std::cout);
+    }
+    if (router.enabled()) {
+        std::cout << "urgent lane: ";
+        urgent_writer.print_stats(std::cout);
+    }
+    flow.print_stats(std::cout);
+    snapshot.print_stats(std::cout);
+    if (!config.stats_output.empty()) {
+        StatsReport report;
+        report.add("role", "publisher");
+        report.add("elapsed_s", publish_elapsed);
+        report.add("written", writer.written() + urgent_writer.written() +
+                batcher.records_written());
+        report.add("dropped", writer.dropped() + urgent_writer.dropped());
+        report.add("failed", writer.failed() + urgent_writer.failed() +
+                batcher.records_failed());
+        if (router.enabled()) {
+            report.add("urgent_written", urgent_writer.written());
+        }
+        if (batcher.enabled()) {
+            report.add("batches", batcher.batches());
+        }
+        if (recovered > 0) {
+            report.add("recovered_samples", recovered);
+            report.add("recovery_ms", profiler.ms_after_start(
+                    StartupProfiler::EVENT_SNAPSHOT_REPUBLISHED));
+        }
+        report.add_process_usage();
+        report.write(config.stats_output, std::cout);
+    }
+    if (!config.trace_output.empty()) {
+        trace_export_chrome_json(config.trace_output, std::cout);
+    }
+    return soak.print_summary(std::cout) ? 0 : 2;
+}
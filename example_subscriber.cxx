@@ -8,268 +8,517 @@
 // any incidental or consequential damages arising out of the use or inability
 // to use the software.
 
+#include <chrono>
+#include <cstdint>
 #include <iostream>
+#include <mutex>
+#include <sys/epoll.h>
 #include <unistd.h>
 
 // headers from Connext DDS Micro/Cert installation
 #include "rti_me_c.h"
 #include "disc_dpse/disc_dpse_dpsediscovery.h"
-#include "wh_sm/wh_sm_history.h"
-#include "rh_sm/rh_sm_history.h"
-#include "netio/netio_udp.h"
 
 // rtiddsgen generated headers
 #include "example.h"
 #include "examplePlugin.h"
 #include "exampleSupport.h"
+#include "sample_batch.h"
 
 #include "common_config.h"
+#include "app_config.h"
+#include "startup_profiler.h"
+#include "dds_setup.h"
+#include "discovery_monitor.h"
+#include "cdr_recording.h"
+#include "shutdown_signal.h"
+#include "trace.h"
+#include "binary_log.h"
+#include "adaptive_take.h"
+#include "batch_accumulator.h"
+#include "columnar_export.h"
+#include "downsample_filter.h"
+#include "latest_value_cache.h"
+#include "latency_stats.h"
+#include "payload_integrity.h"
+#include "reader_event.h"
+#include "stats_report.h"
+#include "soak_monitor.h"
+
+// state shared between main() and the DataReader listener
+struct SubscriberContext {
+    AdaptiveTakeSizer take_sizer;
+    TakeStats take_stats;
+    OneWayLatency latency;
+    // the urgent lane's reader, if any, sizes its takes on its own and
+    // records its latency here as well as in latency
+    DDS_DataReader *urgent_reader;
+    AdaptiveTakeSizer urgent_take_sizer;
+    OneWayLatency urgent_latency;
+    LateJoinerCatchUp catch_up;
+    LatestValueCache latest_values;
+    DiscoveryMonitor discovery;
+    CdrRecorder recorder;
+    IntegrityStats integrity;
+    DownsampleFilter downsample;
+    // per-id counts and rate, per sample or through columns
+    ColumnarExporter columnar;
+    // signalled by the listener when the application thread does the takes
+    ReaderReadyEvent ready;
+    // holds the key of disposed/unregistered instances, see get_key_value();
+    // one per reader, as the two lanes look keys up independently
+    my_type *key_holder;
+    my_type *urgent_key_holder;
+    // With lanes, Micro may call the listener for the two readers on two
+    // receive threads at once. The take stats, catch-up, latest-value
+    // cache, downsampling, columnar exporter and recorder each have one
+    // writer at a time, so each take's processing holds this (LaneLock).
+    // Without lanes only one reader feeds them and it is never taken.
+    // Set before the first reader is created.
+    bool serialize_lanes;
+    std::mutex lane_mutex;
+    // every listener callback runs inside it; closed by the teardown
+    CallbackGate listener_gate;
+
+    bool print_samples;
+    bool event_loop;
+    // the reader takes my_type_batch samples and unpacks their records
+    bool batch;
+    // check each msg's CRC32C trailer
+    bool verify_integrity;
+
+    // The smallest batch the adaptive take will shrink to comes from the
+    // configuration; the upper bound is the DataReader's max_samples.
+    SubscriberContext(
+            const AppConfig &config,
+            DDS_Long max_samples,
+            StartupProfiler *startup_profiler)
+        : take_sizer(config.min_samples_per_take, max_samples),
+          latency(config.latency_monotonic_source_timestamp),
+          urgent_reader(NULL),
+          urgent_take_sizer(config.min_samples_per_take, max_samples),
+          urgent_latency(config.latency_monotonic_source_timestamp),
+          catch_up(config.latency_monotonic_source_timestamp),
+          latest_values(config.latest_value_cache_capacity),
+          discovery(startup_profiler),
+          downsample(
+                  static_cast<std::int64_t>(
+                          config.downsample_min_separation_ms) * 1000000,
+                  config.max_instances),
+          columnar(
+                  columnar_mode(config),
+                  config.columnar_rows,
+                  config.max_instances),
+          key_holder(my_type_create()),
+          urgent_key_holder(my_type_create()),
+          serialize_lanes(false),
+          print_samples(config.print_samples),
+          event_loop(config.event_loop),
+          batch(config.batch_enabled),
+          verify_integrity(config.integrity_enabled)
+    {
+    }
 
-extern "C" void my_typeSubscriber_on_data_available(
-        void *listener_data,
-        DDS_DataReader * reader)
+    static ColumnarMode columnar_mode(const AppConfig &config)
+    {
+        // validated with the rest of the configuration
+        ColumnarMode mode = COLUMNAR_OFF;
+        parse_columnar_mode(config.columnar_mode, &mode);
+        return mode;
+    }
+};
+
+// Holds SubscriberContext::lane_mutex while there is an urgent lane
+class LaneLock {
+public:
+    explicit LaneLock(SubscriberContext *context)
+        : mutex_(context->serialize_lanes ? &context->lane_mutex : NULL)
+    {
+        if (mutex_ != NULL) {
+            mutex_->lock();
+        }
+    }
+    ~LaneLock() { release(); }
+    LaneLock(const LaneLock &) = delete;
+    LaneLock &operator=(const LaneLock &) = delete;
+
+    void release()
+    {
+        if (mutex_ != NULL) {
+            mutex_->unlock();
+            mutex_ = NULL;
+        }
+    }
+
+private:
+    std::mutex *mutex_;
+};
+
+// What is done with each valid sample, whether it arrived on its own or as
+// a record of a batch (batched_ns is then how long it waited in the batch).
+// A sample the downsampling discards, or that fails the integrity check,
+// is counted and goes no further; only a sample that passes both starts
+// its id's next downsampling window.
+static void process_sample(
+        SubscriberContext *context,
+        Lane lane,
+        const my_type &sample,
+        const struct DDS_SampleInfo &info,
+        std::int64_t realtime_offset_ns,
+        std::int64_t batched_ns)
 {
-    (void)(listener_data);  // to suppress -Wunused-parameter warning
+    // a batched record was written batched_ns before its batch
+    auto source_ns = dds_time_to_ns(info.source_timestamp) - batched_ns;
+    context->catch_up.record(source_ns, monotonic_now_ns());
+    if (!context->downsample.due(sample.id, source_ns)) {
+        return;
+    }
+    EXAMPLE_TRACE_SCOPE("process sample", sample.id);
+    if (context->verify_integrity) {
+        auto result = integrity_verify(sample);
+        context->integrity.record(result);
+        if (result != INTEGRITY_OK) {
+            EXAMPLE_LOG_WARNING(
+                    "sample of id {} dropped: {}",
+                    sample.id,
+                    result == INTEGRITY_MISSING
+                            ? "no integrity trailer" : "crc mismatch");
+            return;
+        }
+    }
+    context->downsample.mark_delivered(sample.id, source_ns);
+    context->latest_values.update(sample, info);
+    context->columnar.append(sample, info);
+    auto now_ns = monotonic_now_ns();
+    context->latency.record(info, now_ns, realtime_offset_ns, batched_ns);
+    if (lane == LANE_URGENT) {
+        context->urgent_latency.record(
+                info,
+                now_ns,
+                realtime_offset_ns,
+                batched_ns);
+    }
+    if (context->recorder.is_open()) {
+        context->recorder.record(sample, info);
+    }
 
-    auto hw_reader = my_typeDataReader_narrow(reader);
+    if (context->print_samples) {
+        EXAMPLE_LOG_INFO(
+                "\nValid sample received\n"
+                "\tsample id = {}\n"
+                "\tsample msg = {}",
+                sample.id,
+                sample.msg);
+    }
+}
+
+// Take and process everything the reader holds, on whichever thread is
+// doing the work: the listener or the application's event loop
+static void drain_reader(
+        SubscriberContext *context,
+        my_typeDataReader *hw_reader,
+        Lane lane)
+{
+    auto take_sizer = lane == LANE_URGENT
+            ? &context->urgent_take_sizer : &context->take_sizer;
+    auto key_holder = lane == LANE_URGENT
+            ? context->urgent_key_holder : context->key_holder;
     struct DDS_SampleInfoSeq info_seq = DDS_SEQUENCE_INITIALIZER;
     struct my_typeSeq sample_seq = DDS_SEQUENCE_INITIALIZER;
-    const DDS_Long MAX_SAMPLES_PER_TAKE = 32;
     DDS_ReturnCode_t retcode;
+    auto start = std::chrono::steady_clock::now();
+    std::uint64_t callback_samples = 0;
+    std::uint64_t callback_takes = 0;
+    auto realtime_offset_ns = OneWayLatency::realtime_offset_ns();
+
+    // Keep taking until a take comes back short (or with NO_DATA), so a
+    // burst larger than one batch is handled now instead of waiting for the
+    // next notification.
+    DDS_Long requested;
+    DDS_Long taken;
+    do {
+        requested = take_sizer->next();
+        {
+            EXAMPLE_TRACE_SCOPE("take", requested);
+            retcode = my_typeDataReader_take(
+                    hw_reader, 
+                    &sample_seq, 
+                    &info_seq, 
+                    requested, 
+                    DDS_ANY_SAMPLE_STATE, 
+                    DDS_ANY_VIEW_STATE, 
+                    DDS_ANY_INSTANCE_STATE);
+        }
+        if (retcode == DDS_RETCODE_NO_DATA) {
+            break;
+        } else if (retcode != DDS_RETCODE_OK) {
+            EXAMPLE_LOG_ERROR("failed to take data, retcode = {}", retcode);
+            break;
+        }
 
-    retcode = my_typeDataReader_take(
-            hw_reader, 
-            &sample_seq, 
-            &info_seq, 
-            MAX_SAMPLES_PER_TAKE, 
-            DDS_ANY_SAMPLE_STATE, 
-            DDS_ANY_VIEW_STATE, 
-            DDS_ANY_INSTANCE_STATE);
-    if (retcode != DDS_RETCODE_OK) {
-        std::cout << "ERROR: failed to take data, retcode = " 
-                << retcode << std::endl;
-    }
-
-    // print each valid sample taken
-    DDS_Long i;
-    for (i = 0; i < my_typeSeq_get_length(&sample_seq); ++i) {
-        struct DDS_SampleInfo *sample_info = 
-                DDS_SampleInfoSeq_get_reference(&info_seq, i);
-        if (sample_info->valid_data) {
-            my_type *sample = my_typeSeq_get_reference(&sample_seq, i);
-
-            std::cout << "\nValid sample received" << std::endl;
-            std::cout << "\tsample id = " << sample->id << std::endl;
-            std::cout << "\tsample msg = " << sample->msg << std::endl;
-        } else {
-            std::cout << "\nSample received\n\tINVALID DATA" << std::endl;
+        // print each valid sample taken and update the latest-value cache
+        // straight from the loaned samples
+        taken = my_typeSeq_get_length(&sample_seq);
+        LaneLock lane_lock(context);
+        for (DDS_Long i = 0; i < taken; ++i) {
+            struct DDS_SampleInfo *sample_info = 
+                    DDS_SampleInfoSeq_get_reference(&info_seq, i);
+            if (sample_info->valid_data) {
+                process_sample(
+                        context,
+                        lane,
+                        *my_typeSeq_get_reference(&sample_seq, i),
+                        *sample_info,
+                        realtime_offset_ns,
+                        0);
+            } else {
+                // a dispose or unregister: there is no data, so recover the
+                // key from the instance handle to find the cached value
+                retcode = my_typeDataReader_get_key_value(
+                        hw_reader,
+                        key_holder,
+                        &sample_info->instance_handle);
+                if (retcode == DDS_RETCODE_OK) {
+                    context->latest_values.update_state(
+                            key_holder->id,
+                            sample_info->instance_state);
+                }
+                EXAMPLE_LOG_INFO(
+                        "\nSample received\n\tINVALID DATA, "
+                        "instance state = {}",
+                        instance_state_to_string(
+                                sample_info->instance_state));
+            }
+        }
+        context->columnar.end_take();
+        lane_lock.release();
+        {
+            EXAMPLE_TRACE_SCOPE("return_loan", taken);
+            my_typeDataReader_return_loan(hw_reader, &sample_seq, &info_seq);
         }
+
+        take_sizer->update(taken);
+        callback_samples += taken;
+        ++callback_takes;
+    } while (taken == requested);
+
+    LaneLock lane_lock(context);
+    if (callback_samples > 0) {
+        context->discovery.on_sample();
     }
-    my_typeDataReader_return_loan(hw_reader, &sample_seq, &info_seq);
+
+    context->take_stats.record_callback(
+            callback_samples,
+            callback_takes,
+            std::chrono::duration_cast<std::chrono::nanoseconds>(
+                    std::chrono::steady_clock::now() - start).count());
 }
 
-int main(void)
+// drain_reader() for a batching publisher: the same loop over takes, but
+// every batch taken is unpacked in place and each record processed as a
+// sample. The adaptive take sizes itself in batches; take_stats counts
+// records.
+static void drain_batch_reader(
+        SubscriberContext *context,
+        my_type_batchDataReader *batch_reader)
 {
+    struct DDS_SampleInfoSeq info_seq = DDS_SEQUENCE_INITIALIZER;
+    struct my_type_batchSeq batch_seq = DDS_SEQUENCE_INITIALIZER;
     DDS_ReturnCode_t retcode;
+    auto start = std::chrono::steady_clock::now();
+    std::uint64_t callback_samples = 0;
+    std::uint64_t callback_takes = 0;
+    auto realtime_offset_ns = OneWayLatency::realtime_offset_ns();
+
+    DDS_Long requested;
+    DDS_Long taken;
+    do {
+        requested = context->take_sizer.next();
+        {
+            EXAMPLE_TRACE_SCOPE("take", requested);
+            retcode = my_type_batchDataReader_take(
+                    batch_reader,
+                    &batch_seq,
+                    &info_seq,
+                    requested,
+                    DDS_ANY_SAMPLE_STATE,
+                    DDS_ANY_VIEW_STATE,
+                    DDS_ANY_INSTANCE_STATE);
+        }
+        if (retcode == DDS_RETCODE_NO_DATA) {
+            break;
+        } else if (retcode != DDS_RETCODE_OK) {
+            EXAMPLE_LOG_ERROR("failed to take data, retcode = {}", retcode);
+            break;
+        }
 
-    // create the DomainParticipantFactory and registry so that we can make some 
-    // changes to the default values
-    auto dpf = DDS_DomainParticipantFactory_get_instance();
-    auto registry = DDS_DomainParticipantFactory_get_registry(dpf);
+        taken = my_type_batchSeq_get_length(&batch_seq);
+        LaneLock lane_lock(context);
+        for (DDS_Long i = 0; i < taken; ++i) {
+            struct DDS_SampleInfo *sample_info =
+                    DDS_SampleInfoSeq_get_reference(&info_seq, i);
+            if (!sample_info->valid_data) {
+                // the batch topic is keyless, so this is the writer going
+                EXAMPLE_LOG_INFO(
+                        "\nBatch received\n\tINVALID DATA, "
+                        "instance state = {}",
+                        instance_state_to_string(
+                                sample_info->instance_state));
+                continue;
+            }
+            BatchRecords records(
+                    *my_type_batchSeq_get_reference(&batch_seq, i));
+            my_type record;
+            std::int64_t batched_ns;
+            EXAMPLE_TRACE_SCOPE("unpack batch", i);
+            while (records.next(&record, &batched_ns)) {
+                process_sample(
+                        context,
+                        LANE_BULK,
+                        record,
+                        *sample_info,
+                        realtime_offset_ns,
+                        batched_ns);
+                ++callback_samples;
+            }
+            if (records.malformed()) {
+                EXAMPLE_LOG_ERROR("malformed batch, rest of it skipped");
+            }
+        }
+        context->columnar.end_take();
+        lane_lock.release();
+        {
+            EXAMPLE_TRACE_SCOPE("return_loan", taken);
+            my_type_batchDataReader_return_loan(
+                    batch_reader,
+                    &batch_seq,
+                    &info_seq);
+        }
 
-    // register writer history
-    if (!RT_Registry_register(
-            registry, 
-            DDSHST_WRITER_DEFAULT_HISTORY_NAME,
-            WHSM_HistoryFactory_get_interface(), 
-            NULL, 
-            NULL))
-    {
-        std::cout << "ERROR: failed to register wh" << std::endl;
-    }
-    // register reader history
-    if (!RT_Registry_register(
-            registry, 
-            DDSHST_READER_DEFAULT_HISTORY_NAME,
-            RHSM_HistoryFactory_get_interface(), 
-            NULL, 
-            NULL))
-    {
-        std::cout << "ERROR: failed to register rh" << std::endl;
-    }
+        context->take_sizer.update(taken);
+        ++callback_takes;
+    } while (taken == requested);
 
-    // Set up the UDP transport's allowed interfaces. To do this we:
-    // (1) unregister the UDP transport
-    // (2) name the allowed interfaces
-    // (3) re-register the transport
-    if (!RT_Registry_unregister(
-            registry, 
-            NETIO_DEFAULT_UDP_NAME, 
-            NULL, 
-            NULL)) 
-    {
-        std::cout << "ERROR: failed to unregister udp" << std::endl;
+    LaneLock lane_lock(context);
+    if (callback_samples > 0) {
+        context->discovery.on_sample();
     }
 
-    auto udp_property = (struct UDP_InterfaceFactoryProperty *)malloc(
-            sizeof(struct UDP_InterfaceFactoryProperty));
-    if (udp_property == NULL) {
-        std::cout << "ERROR: failed to allocate udp properties" << std::endl;
+    context->take_stats.record_callback(
+            callback_samples,
+            callback_takes,
+            std::chrono::duration_cast<std::chrono::nanoseconds>(
+                    std::chrono::steady_clock::now() - start).count());
+}
+
+static void drain(SubscriberContext *context, DDS_DataReader *reader)
+{
+    if (reader == context->urgent_reader) {
+        drain_reader(
+                context,
+                my_typeDataReader_narrow(reader),
+                LANE_URGENT);
+    } else if (context->batch) {
+        drain_batch_reader(context, my_type_batchDataReader_narrow(reader));
+    } else {
+        drain_reader(context, my_typeDataReader_narrow(reader), LANE_BULK);
     }
-    *udp_property = UDP_INTERFACE_FACTORY_PROPERTY_DEFAULT;
-    udp_property->disable_auto_interface_config = RTI_TRUE;
-    
-    if (!DDS_StringSeq_set_maximum(&udp_property->allow_interface,2)) {
-        printf("failed to set allow_interface maximum\n");
-        return -1;
+}
+
+extern "C" void my_typeSubscriber_on_data_available(
+        void *listener_data,
+        DDS_DataReader * reader)
+{
+    auto context = static_cast<SubscriberContext *>(listener_data);
+    CallbackGate::Scope scope(&context->listener_gate);
+    if (!scope.entered()) {
+        return;
     }
-    if (!DDS_StringSeq_set_length(&udp_property->allow_interface,2)) {
-        printf("failed to set allow_interface length\n");
-        return -1;
+    EXAMPLE_TRACE_THREAD_NAME("listener");
+    EXAMPLE_TRACE_SCOPE("on_data_available", 0);
+
+    // with an event loop the listener only wakes the application thread
+    if (context->event_loop) {
+        context->ready.notify();
+        return;
     }
+    drain(context, reader);
+}
 
-    if (!UDP_InterfaceTableEntrySeq_set_maximum(&udp_property->if_table,2)) {
-        printf("failed to set if_table maximum\n");
-        return -1;
+extern "C" void my_typeSubscriber_on_subscription_matched(
+        void *listener_data,
+        DDS_DataReader *reader,
+        const struct DDS_SubscriptionMatchedStatus *status)
+{
+    (void)(reader);  // to suppress -Wunused-parameter warning
+
+    auto context = static_cast<SubscriberContext *>(listener_data);
+    CallbackGate::Scope scope(&context->listener_gate);
+    if (scope.entered()) {
+        context->discovery.on_matched(status->current_count);
     }
+}
 
-    *DDS_StringSeq_get_reference(&udp_property->allow_interface,0) = 
-            DDS_String_dup(k_loopback_name.c_str());
-    if (!UDP_InterfaceTable_add_entry(
-            &udp_property->if_table,
-            k_loopback_ip,
-            k_loopback_mask,
-            k_loopback_name.c_str(),
-            UDP_INTERFACE_INTERFACE_UP_FLAG)) 
-    {
-        std::cout << "ERROR: failed to add " << k_loopback_name.c_str() <<
-                "interface" << std::endl;
-        return -1;
+extern "C" void my_typeSubscriber_on_liveliness_changed(
+        void *listener_data,
+        DDS_DataReader *reader,
+        const struct DDS_LivelinessChangedStatus *status)
+{
+    (void)(reader);  // to suppress -Wunused-parameter warning
+
+    auto context = static_cast<SubscriberContext *>(listener_data);
+    CallbackGate::Scope scope(&context->listener_gate);
+    if (scope.entered()) {
+        context->discovery.on_liveliness_changed(status->alive_count);
     }
+}
 
-    *DDS_StringSeq_get_reference(&udp_property->allow_interface,1) = 
-            DDS_String_dup(k_real_nic_name.c_str());
-    if (!UDP_InterfaceTable_add_entry(
-            &udp_property->if_table,
-            k_real_nic_ip,
-            k_real_nic_mask,
-            k_real_nic_name.c_str(),
-            UDP_INTERFACE_INTERFACE_UP_FLAG)) 
-    {
-        std::cout << "ERROR: failed to add " << k_loopback_name.c_str() <<
-                "interface" << std::endl;
+int main(int argc, char *argv[])
+{
+    DDS_ReturnCode_t retcode;
+    StartupProfiler profiler;
+    install_shutdown_handler();
+    BinaryLogger logger;
+    EXAMPLE_TRACE_SETUP();
+    EXAMPLE_TRACE_THREAD_NAME("main");
+
+    // load the deployment's settings before anything else
+    AppConfig config;
+    if (!app_config_from_command_line(&config, &argc, argv, std::cout)) {
+        std::cout << "usage: " << argv[0] 
+                << " [--config FILE] [--set section.key=value]..." 
+                << std::endl;
         return -1;
     }
-
-    //explicitly set the "real NIC" as the multicast interface
-    udp_property->multicast_interface = DDS_String_dup(k_real_nic_name.c_str());
-
-    if(!RT_Registry_register(
-            registry, 
-            NETIO_DEFAULT_UDP_NAME,
-            UDP_InterfaceFactory_get_interface(),
-            (struct RT_ComponentFactoryProperty*)udp_property, NULL))
-    {
-        std::cout << "ERROR: failed to re-register udp" << std::endl;
-    } 
-
-    // register the dpse (discovery) component
-    struct DPSE_DiscoveryPluginProperty discovery_plugin_properties =
-            DPSE_DiscoveryPluginProperty_INITIALIZER;
-    if (!RT_Registry_register(
-            registry,
-            "dpse",
-            DPSE_DiscoveryFactory_get_interface(),
-            &discovery_plugin_properties._parent, 
-            NULL))
-    {
-        std::cout << "ERROR: failed to register dpse" << std::endl;
-    }
-
-    // Now that we've finished the changes to the registry, we will start 
-    // creating DDS entities. By setting autoenable_created_entities to false 
-    // until all of the DDS entities are created, we limit all dynamic memory 
-    // allocation to happen *before* the point where we enable everything.
-    struct DDS_DomainParticipantFactoryQos dpf_qos =
-            DDS_DomainParticipantFactoryQos_INITIALIZER;
-    DDS_DomainParticipantFactory_get_qos(dpf, &dpf_qos);
-    dpf_qos.entity_factory.autoenable_created_entities = DDS_BOOLEAN_FALSE;
-    DDS_DomainParticipantFactory_set_qos(dpf, &dpf_qos);
-
-    // configure discovery prior to creating our DomainParticipant
-    struct DDS_DomainParticipantQos dp_qos = 
-            DDS_DomainParticipantQos_INITIALIZER;
-    if(!RT_ComponentFactoryId_set_name(
-            &dp_qos.discovery.discovery.name,
-            "dpse"))
-    {
-        std::cout << "ERROR: failed to set discovery plugin name" << std::endl;
-    }
-    if(!DDS_StringSeq_set_maximum(&dp_qos.discovery.initial_peers, 1)) {
-        std::cout << "ERROR: failed to set initial peers maximum" << std::endl;
-    }
-    if (!DDS_StringSeq_set_length(&dp_qos.discovery.initial_peers, 1)) {
-        std::cout << "ERROR: failed to set initial peers length" << std::endl;
-    }
-    *DDS_StringSeq_get_reference(&dp_qos.discovery.initial_peers, 0) = 
-            DDS_String_dup(k_subscriber_initial_peer.c_str());
-
-    // configure the DomainParticipant's resource limits... these are just 
-    // examples, if there are more remote or local endpoints these values would
-    // need to be increased
-    dp_qos.resource_limits.max_destination_ports = 32;
-    dp_qos.resource_limits.max_receive_ports = 32;
-    dp_qos.resource_limits.local_topic_allocation = 1;
-    dp_qos.resource_limits.local_type_allocation = 1;
-    dp_qos.resource_limits.local_reader_allocation = 1;
-    dp_qos.resource_limits.local_writer_allocation = 1;
-    dp_qos.resource_limits.remote_participant_allocation = 8;
-    dp_qos.resource_limits.remote_reader_allocation = 8;
-    dp_qos.resource_limits.remote_writer_allocation = 8;
-
-    //  set the name of the local DomainParticipant
-    // (this is required for DPSE discovery)
-    strcpy(dp_qos.participant_name.name, k_PARTICIPANT02_NAME.c_str());
-
-    // now the DomainParticipant can be created
-    auto dp = DDS_DomainParticipantFactory_create_participant(
-            dpf, 
-            domain_id,
-            &dp_qos, 
-            NULL,
-            DDS_STATUS_MASK_NONE);
-    if(dp == NULL) {
-        std::cout << "ERROR: failed to create participant" << std::endl;
+    if (config.print_config) {
+        app_config_print(config, std::cout);
     }
+    profiler.mark("load config");
 
-    // register the type (my_type, from the idl) with the middleware
-    std::string type_name = "my_type";
-    retcode = DDS_DomainParticipant_register_type(
-            dp,
-            type_name.c_str(),
-            my_typeTypePlugin_get());
-    if(retcode != DDS_RETCODE_OK) {
-        std::cout << "ERROR: failed to register type" << std::endl;
+    if (!dds_setup_register_components(config, &profiler)) {
+        return -1;
     }
 
-    // Create the Topic to which we will publish. Note that the name of the 
-    // Topic is stored in my-topic-name, which was defined in the IDL 
-    auto topic = DDS_DomainParticipant_create_topic(
-            dp,
-            my_topic_name,
-            type_name.c_str(),
-            &DDS_TOPIC_QOS_DEFAULT, 
-            NULL,
-            DDS_STATUS_MASK_NONE);
-    if(topic == NULL) {
-        std::cout << "ERROR: topic == NULL" << std::endl;
+    // in fan-out, each subscriber process has its own participant name
+    ParticipantSetup setup;
+    setup.name =
+            app_config_subscriber_name(config, config.fanout_subscriber_index);
+    setup.initial_peer = config.subscriber_initial_peer;
+    auto dp = dds_setup_create_participant(config, setup, &profiler);
+    auto topic = dds_setup_create_topic(dp, config, &profiler);
+    auto lanes = dds_setup_lane_count(config);
+    DDS_Topic *urgent_topic = NULL;
+    if (lanes > 1) {
+        urgent_topic = dds_setup_create_topic(
+                dp, config, &profiler, LANE_URGENT);
     }
 
     // assert remote DomainParticipant
-    retcode = DPSE_RemoteParticipant_assert(dp, k_PARTICIPANT01_NAME.c_str());
+    retcode = DPSE_RemoteParticipant_assert(dp, config.publisher_name.c_str());
     if(retcode != DDS_RETCODE_OK) {
         std::cout << "ERROR: failed to assert remote participant" << std::endl;
     }
+    profiler.mark("assert remote participant");
 
     // create the Subscriber
     auto subscriber = DDS_DomainParticipant_create_subscriber(
@@ -280,66 +529,300 @@ int main(void)
     if(subscriber == NULL) {
         std::cout << "ERROR: subscriber == NULL" << std::endl;
     }
+    profiler.mark("create subscriber");
 
     // Create a listener to pass to the DataReader when we create it
     struct DDS_DataReaderListener dr_listener =
             DDS_DataReaderListener_INITIALIZER;
     dr_listener.on_data_available = my_typeSubscriber_on_data_available;
+    dr_listener.on_subscription_matched = 
+            my_typeSubscriber_on_subscription_matched;
+    dr_listener.on_liveliness_changed = my_typeSubscriber_on_liveliness_changed;
 
     // Configure the DataReader's QoS, then create the DataReader
     struct DDS_DataReaderQos dr_qos = DDS_DataReaderQos_INITIALIZER;
-
-    dr_qos.protocol.rtps_object_id = k_OBJ_ID_PARTICIPANT02_DR01;
-    dr_qos.reliability.kind = DDS_RELIABLE_RELIABILITY_QOS;
-    dr_qos.resource_limits.max_instances = 2;
-    dr_qos.resource_limits.max_samples_per_instance = 32;
-    dr_qos.resource_limits.max_samples = dr_qos.resource_limits.max_instances *
-            dr_qos.resource_limits.max_samples_per_instance;
-    dr_qos.reader_resource_limits.max_remote_writers = 10;
-    dr_qos.reader_resource_limits.max_remote_writers_per_instance = 10;
-    dr_qos.history.depth = 16;
+    dds_setup_reader_qos(config, &dr_qos);
+
+    // a single take can never loan out more than max_samples, so that bounds
+    // the adaptive batch size used by the listener
+    SubscriberContext context(
+            config,
+            dr_qos.resource_limits.max_samples,
+            &profiler);
+    context.serialize_lanes = lanes > 1;
+    dr_listener.as_listener.listener_data = &context;
+    // declared after context, so the readers stop calling the listener
+    // before context goes, whichever way main() returns
+    ParticipantTeardown teardown(dp, &context.listener_gate);
 
     auto datareader = DDS_Subscriber_create_datareader(
             subscriber,
             DDS_Topic_as_topicdescription(topic), 
             &dr_qos,
             &dr_listener,
-            DDS_DATA_AVAILABLE_STATUS);
+            DDS_DATA_AVAILABLE_STATUS | 
+                    DDS_SUBSCRIPTION_MATCHED_STATUS |
+                    DDS_LIVELINESS_CHANGED_STATUS);
     if(datareader == NULL) {
         std::cout << "ERROR: datareader == NULL" << std::endl;
     }
+    teardown.add_reader(datareader);
+    profiler.mark("create datareader");
+
+    // The urgent lane's reader shares the listener for its data only;
+    // matching and liveliness are followed on the bulk lane
+    if (urgent_topic != NULL) {
+        struct DDS_DataReaderQos urgent_dr_qos = DDS_DataReaderQos_INITIALIZER;
+        dds_setup_reader_qos(config, &urgent_dr_qos, LANE_URGENT);
+        context.urgent_reader = DDS_Subscriber_create_datareader(
+                subscriber,
+                DDS_Topic_as_topicdescription(urgent_topic),
+                &urgent_dr_qos,
+                &dr_listener,
+                DDS_DATA_AVAILABLE_STATUS);
+        if (context.urgent_reader == NULL) {
+            std::cout << "ERROR: urgent datareader == NULL" << std::endl;
+        }
+        teardown.add_reader(context.urgent_reader);
+        profiler.mark("create urgent datareader");
+    }
 
-    // setup information about the publisher we are expecting to discover 
-    struct DDS_PublicationBuiltinTopicData rem_publication_data =
-        DDS_PublicationBuiltinTopicData_INITIALIZER;
-    rem_publication_data.key.value[DDS_BUILTIN_TOPIC_KEY_OBJECT_ID] = 
-            k_OBJ_ID_PARTICIPANT01_DW01;
-    rem_publication_data.topic_name = DDS_String_dup(my_topic_name);
-    rem_publication_data.type_name = DDS_String_dup(type_name.c_str());
-    rem_publication_data.reliability.kind = DDS_RELIABLE_RELIABILITY_QOS;    
+    // now assert the publisher's writer(s), one per lane, so the local DP
+    // knows that we expect to find them
+    for (int lane = LANE_BULK; lane < lanes; ++lane) {
+        struct DDS_PublicationBuiltinTopicData rem_publication_data =
+            DDS_PublicationBuiltinTopicData_INITIALIZER;
+        dds_setup_remote_publication_data(
+                config, &rem_publication_data, static_cast<Lane>(lane));
+        retcode = DPSE_RemotePublication_assert(
+                dp,
+                config.publisher_name.c_str(),
+                &rem_publication_data,
+                dds_setup_key_kind(config, static_cast<Lane>(lane)));
+        if (retcode != DDS_RETCODE_OK) {
+            std::cout << "ERROR: failed to assert remote publication"
+                    << std::endl;
+        }
+    }
+    profiler.mark("assert remote publication");
+
+    // the recording files are created and preallocated before enable
+    if (!config.record_prefix.empty()) {
+        if (!context.recorder.open(
+                    config.record_prefix,
+                    (std::size_t)config.record_segment_size_mb << 20,
+                    std::cout)) {
+            return -1;
+        }
+        std::cout << "Recording samples to " << config.record_prefix 
+                << ".*" << std::endl;
+        profiler.mark("open recording");
+    }
 
-    // now assert the publisher so the local DP knows that we expect to find it
-    retcode = DPSE_RemotePublication_assert(
-            dp,
-            k_PARTICIPANT01_NAME.c_str(),
-            &rem_publication_data,
-            my_type_get_key_kind(my_typeTypePlugin_get(), 
-            NULL));
-    if (retcode != DDS_RETCODE_OK) {
-        std::cout << "ERROR: failed to assert remote publication" << std::endl;
+    if (!context.discovery.reserve(config.remote_participant_allocation)) {
+        std::cout << "ERROR: failed to reserve discovered participants" 
+                << std::endl;
     }
 
     // Finally, now that all of the entities are created, we can enable them all
+    context.catch_up.start();
     retcode = DDS_Entity_enable(DDS_DomainParticipant_as_entity(dp));
     if(retcode != DDS_RETCODE_OK) {
         std::cout << "ERROR: failed to enable entity" << std::endl;
     }
+    profiler.mark_enabled();
+    profiler.print_phases(std::cout);
+
+    // In event-loop mode the reader's eventfd sits in an epoll set next to
+    // whatever else the application waits on; here that is just the tick.
+    auto epoll_fd = -1;
+    if (config.event_loop) {
+        epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+        struct epoll_event event;
+        event.events = EPOLLIN;
+        event.data.fd = context.ready.fd();
+        if (!context.ready.is_valid() || epoll_fd < 0 ||
+                epoll_ctl(
+                    epoll_fd,
+                    EPOLL_CTL_ADD,
+                    context.ready.fd(),
+                    &event) != 0) {
+            std::cout << "ERROR: failed to set up the event loop" 
+                    << std::endl;
+            return -1;
+        }
+    }
 
     std::cout << "Waiting for samples to arrive, press Ctrl-C to exit" 
             << std::endl;
-    while(1) {
-        // optional work could be done here
-        sleep(10); // sleep for 10s, then loop again
-    }    
-}
+    auto run_start = std::chrono::steady_clock::now();
+    SoakMonitor soak(config, [&](SoakCounters *counters) {
+        counters->samples =
+                context.take_stats.samples.load(std::memory_order_relaxed);
+        counters->latency = context.latency.transport.snapshot();
+        struct DDS_SampleLostStatus lost;
+        struct DDS_SampleRejectedStatus rejected;
+        if (DDS_DataReader_get_sample_lost_status(datareader, &lost) ==
+                    DDS_RETCODE_OK &&
+                DDS_DataReader_get_sample_rejected_status(
+                    datareader,
+                    &rejected) == DDS_RETCODE_OK) {
+            counters->protocol_events =
+                    lost.total_count + rejected.total_count;
+        }
+    });
+    const unsigned int k_tick_us = 100000;
+    // in 64 bits: report periods of over 35 minutes overflow an int in us
+    const unsigned int k_ticks_per_report = static_cast<unsigned int>(
+            static_cast<std::int64_t>(config.report_period_ms) * 1000 /
+                    k_tick_us);
+    const unsigned int k_ticks_per_second = 1000000 / k_tick_us;
+    for (unsigned int tick = 1; !shutdown_requested(); ++tick) {
+        if (config.event_loop) {
+            auto next_tick = std::chrono::steady_clock::now() +
+                    std::chrono::microseconds(k_tick_us);
+            for (;;) {
+                auto timeout_ms = std::chrono::duration_cast<
+                        std::chrono::milliseconds>(
+                                next_tick - std::chrono::steady_clock::now())
+                        .count();
+                if (timeout_ms <= 0 || shutdown_requested()) {
+                    break;
+                }
+                struct epoll_event event;
+                if (epoll_wait(epoll_fd, &event, 1, (int)timeout_ms) == 1) {
+                    EXAMPLE_TRACE_SCOPE("event loop drain", 0);
+                    context.ready.consume();
+                    // the urgent lane never waits behind a bulk burst
+                    if (context.urgent_reader != NULL) {
+                        drain(&context, context.urgent_reader);
+                    }
+                    drain(&context, datareader);
+                }
+            }
+        } else {
+            usleep(k_tick_us);
+        }
+        context.discovery.poll_participants(dp);
+        if (soak.poll()) {
+            request_shutdown();
+        }
+        if (config.latency_per_second_report &&
+                tick % k_ticks_per_second == 0) {
+            context.latency.print_interval(
+                    std::cout,
+                    tick / k_ticks_per_second);
+        }
+        if (tick % k_ticks_per_report != 0) {
+            continue;
+        }
+
+        // periodically report what the listener has done
+        context.take_stats.print(std::cout);
+        context.latency.transport.print(std::cout);
+        if (context.urgent_reader != NULL) {
+            std::cout << "urgent lane ";
+            context.urgent_latency.transport.print(std::cout);
+        }
+        if (config.integrity_enabled) {
+            context.integrity.print(std::cout);
+        }
+        if (config.event_loop) {
+            context.ready.print_stats(std::cout);
+        }
+        if (context.recorder.is_open()) {
+            context.recorder.print_stats(std::cout);
+        }
+        context.downsample.print_stats(std::cout);
+        context.columnar.print(std::cout);
+
+        // application threads read the cache without taking from the reader
+        std::cout << "latest values (" << context.latest_values.size() 
+                << " ids):" << std::endl;
+        context.latest_values.for_each([](const LatestValue &value) {
+            std::cout << "\tid = " << value.id 
+                    << ", state = " 
+                    << instance_state_to_string(value.instance_state)
+                    << ", updates = " << value.update_count
+                    << ", msg = " << value.msg << std::endl;
+        });
+    }
 
+    // once the teardown returns no callback is running or will run: the
+    // recorder, the exporter and the counters below are the listener's no
+    // more
+    teardown.shutdown();
+
+    // final totals, e.g. for fanout_benchmark.sh
+    context.take_stats.print(std::cout);
+    context.latency.transport.print(std::cout);
+    if (context.urgent_reader != NULL) {
+        std::cout << "urgent lane ";
+        context.urgent_latency.transport.print(std::cout);
+    }
+    if (config.integrity_enabled) {
+        context.integrity.print(std::cout);
+    }
+    if (config.event_loop) {
+        context.ready.print_stats(std::cout);
+        close(epoll_fd);
+    }
+    context.downsample.print_stats(std::cout);
+    if (config.durability_transient_local) {
+        context.catch_up.print(std::cout);
+    }
+    // with the listener detached, the consumer also gets the last rows
+    context.columnar.stop();
+    context.columnar.print(std::cout);
+
+    if (!config.stats_output.empty()) {
+        StatsReport report;
+        report.add("role", "subscriber");
+        report.add("elapsed_s", std::chrono::duration<double>(
+                std::chrono::steady_clock::now() - run_start).count());
+        report.add("received",
+                context.take_stats.samples.load(std::memory_order_relaxed));
+        report.add_latency("latency", context.latency.transport.snapshot());
+        if (context.urgent_reader != NULL) {
+            report.add_latency("urgent_latency",
+                    context.urgent_latency.transport.snapshot());
+        }
+        report.add("take_ns_per_sample", context.take_stats.ns_per_sample());
+        if (config.durability_transient_local) {
+            report.add("catch_up_samples", context.catch_up.historical());
+            report.add("catch_up_ms", context.catch_up.catch_up_ms());
+        }
+        if (context.downsample.enabled()) {
+            report.add("downsample_delivered",
+                    context.downsample.delivered());
+            report.add("downsample_discarded",
+                    context.downsample.discarded());
+        }
+        if (context.columnar.mode() != COLUMNAR_OFF) {
+            report.add("columnar_dropped_rows",
+                    context.columnar.dropped_rows());
+            report.add("columnar_ns_per_row", context.columnar.ns_per_row());
+        }
+        if (config.integrity_enabled) {
+            report.add("integrity_verified", context.integrity.verified.load(
+                    std::memory_order_relaxed));
+            report.add("integrity_missing", context.integrity.missing.load(
+                    std::memory_order_relaxed));
+            report.add("integrity_mismatched",
+                    context.integrity.mismatched.load(
+                            std::memory_order_relaxed));
+        }
+        report.add_process_usage();
+        report.write(config.stats_output, std::cout);
+    }
+
+    // flush the recording and trim its preallocated tail
+    if (context.recorder.is_open()) {
+        context.recorder.print_stats(std::cout);
+        context.recorder.close();
+    }
+    if (!config.trace_output.empty()) {
+        trace_export_chrome_json(config.trace_output, std::cout);
+    }
+    return soak.print_summary(std::cout) ? 0 : 2;
+}
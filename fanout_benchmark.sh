@@ -0,0 +1,118 @@
+#!/bin/bash
+# (c) Copyright, Real-Time Innovations, 2021.  All rights reserved.
+# RTI grants Licensee a license to use, modify, compile, and create derivative
+# works of the software solely for use with RTI Connext DDS. Licensee may
+# redistribute copies of the software provided that all such copies are subject
+# to this license. The software is provided "as is", with no warranty of any
+# type, including any warranty for fitness for any purpose. RTI is under no
+# obligation to maintain or support the software. RTI shall not be liable for
+# any incidental or consequential damages arising out of the use or inability
+# to use the software.
+
+# Compare unicast and multicast fan-out as the number of subscribers grows.
+# For each N and mode, starts N example_subscriber processes and one
+# example_publisher on this host, publishes for DURATION seconds on the
+# cyclic scheduler, then reports the publisher's CPU use, the samples
+# written and delivered per second, and the subscribers' average and worst
+# write-to-receive latency.
+#
+#     ./fanout_benchmark.sh objs/x64Linux4gcc7.3.0_cert
+#
+# Environment: SUBSCRIBERS (default "1 2 4 8 16 24"), STREAMS (the
+# schedule.streams value, default "1000:1"), DURATION (seconds, default 10),
+# MULTICAST_ADDRESS (default 239.255.0.1), CONFIG (an extra --config file).
+
+set -u
+
+BIN_DIR=${1:-objs/${RTIME_TARGET_NAME:-x64Linux4gcc7.3.0_cert}}
+SUBSCRIBERS=${SUBSCRIBERS:-"1 2 4 8 16 24"}
+STREAMS=${STREAMS:-"1000:1"}
+DURATION=${DURATION:-10}
+MULTICAST_ADDRESS=${MULTICAST_ADDRESS:-239.255.0.1}
+LOG_DIR=$(mktemp -d /tmp/fanout_benchmark.XXXXXX)
+CLK_TCK=$(getconf CLK_TCK)
+
+source "$(dirname "$0")/benchmark_common.sh"
+require_binaries
+
+common_args=()
+if [ -n "${CONFIG:-}" ]; then
+    common_args+=(--config "$CONFIG")
+fi
+
+per_second() {
+    awk -v n=$1 -v d=$DURATION 'BEGIN { printf "%.0f", n / d }'
+}
+
+run_one() {
+    local n=$1 mode=$2
+    local multicast=""
+    [ "$mode" = multicast ] && multicast=$MULTICAST_ADDRESS
+    local args=(${common_args[@]+"${common_args[@]}"}
+            --set "fanout.subscribers=$n"
+            --set "fanout.multicast_address=$multicast"
+            --set "discovery.remote_participant_allocation=$((n > 8 ? n : 8))")
+
+    local sub_pids=()
+    for ((k = 0; k < n; ++k)); do
+        "$BIN_DIR/example_subscriber" "${args[@]}" \
+                --set "fanout.subscriber_index=$k" \
+                --set subscriber.print_samples=false \
+                > "$LOG_DIR/sub_${mode}_${n}_$k.log" 2>&1 &
+        sub_pids+=($!)
+    done
+
+    "$BIN_DIR/example_publisher" "${args[@]}" \
+            --set "schedule.streams=$STREAMS" \
+            > "$LOG_DIR/pub_${mode}_$n.log" 2>&1 &
+    local pub_pid=$!
+
+    # measure from the first write, once every subscriber is matched
+    local waited=0
+    while ! grep -q "^schedule:" "$LOG_DIR/pub_${mode}_$n.log" &&
+            [ $waited -lt 300 ]; do
+        sleep 0.1
+        waited=$((waited + 1))
+    done
+    local start_ticks=$(cpu_ticks $pub_pid)
+    sleep "$DURATION"
+    local end_ticks=$(cpu_ticks $pub_pid)
+
+    kill -INT $pub_pid; wait $pub_pid
+    kill -INT "${sub_pids[@]}"; wait "${sub_pids[@]}"
+
+    local cpu=$(awk -v t=$((end_ticks - start_ticks)) -v hz=$CLK_TCK \
+            -v d=$DURATION 'BEGIN { printf "%.1f", 100 * t / hz / d }')
+    local written=$(grep -o "releases = [0-9]*" "$LOG_DIR/pub_${mode}_$n.log" |
+            awk '{ s += $3 } END { print s + 0 }')
+    # the last "take stats"/"latency" lines of each subscriber are its totals
+    local delivered=0 latency_sum=0 latency_max=0
+    for ((k = 0; k < n; ++k)); do
+        local log="$LOG_DIR/sub_${mode}_${n}_$k.log"
+        local samples=$(grep "^take stats:" "$log" | tail -1 |
+                sed -n 's/.* samples = \([0-9]*\),.*/\1/p')
+        local line=$(grep "^latency:" "$log" | tail -1)
+        local avg=$(echo "$line" | sed -n 's/.*avg = \([0-9.e+-]*\) us.*/\1/p')
+        local max=$(echo "$line" | sed -n 's/.*max = \([0-9.e+-]*\) us.*/\1/p')
+        delivered=$((delivered + ${samples:-0}))
+        latency_sum=$(awk -v a=$latency_sum -v b=${avg:-0} \
+                -v c=${samples:-0} 'BEGIN { print a + b * c }')
+        latency_max=$(awk -v a=$latency_max -v b=${max:-0} \
+                'BEGIN { print (b > a) ? b : a }')
+    done
+    local latency_avg=$(awk -v s=$latency_sum -v n=$delivered \
+            'BEGIN { printf "%.1f", n ? s / n : 0 }')
+
+    printf "%4d  %-9s  %8s  %10s  %12s  %10s  %10s\n" "$n" "$mode" "$cpu" \
+            "$(per_second $written)" "$(per_second $delivered)" \
+            "$latency_avg" "$latency_max"
+}
+
+echo "logs in $LOG_DIR"
+printf "%4s  %-9s  %8s  %10s  %12s  %10s  %10s\n" "N" "mode" "pub CPU%" \
+        "written/s" "delivered/s" "avg us" "max us"
+for n in $SUBSCRIBERS; do
+    for mode in unicast multicast; do
+        run_one "$n" "$mode"
+    done
+done
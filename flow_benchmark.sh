@@ -0,0 +1,80 @@
+#!/bin/bash
+# (c) Copyright, Real-Time Innovations, 2021.  All rights reserved.
+# RTI grants Licensee a license to use, modify, compile, and create derivative
+# works of the software solely for use with RTI Connext DDS. Licensee may
+# redistribute copies of the software provided that all such copies are subject
+# to this license. The software is provided "as is", with no warranty of any
+# type, including any warranty for fitness for any purpose. RTI is under no
+# obligation to maintain or support the software. RTI shall not be liable for
+# any incidental or consequential damages arising out of the use or inability
+# to use the software.
+
+# Goodput of a bulk reliable writer over a constrained link, with and
+# without the publisher's token-bucket flow controller. The loopback
+# interface stands in for the slow link: a tbf qdisc limits it to
+# LINK_RATE with a small queue, so bursts beyond it are dropped and must be
+# repaired (needs root for tc). The publisher offers STREAMS through the
+# cyclic scheduler; each run reports the samples delivered per second and
+# the flow controller's throttle count and queueing delay.
+#
+#     sudo ./flow_benchmark.sh objs/x64Linux4gcc7.3.0_cert
+#
+# Environment: LINK_RATE (tc rate, default 8mbit), FLOW_RATES (flow
+# bytes_per_second values to try, 0 = off, default "0 500000 900000"),
+# STREAMS (default "10000:4"), DURATION (seconds, default 10), CONFIG.
+
+set -u
+
+BIN_DIR=${1:-objs/${RTIME_TARGET_NAME:-x64Linux4gcc7.3.0_cert}}
+LINK_RATE=${LINK_RATE:-8mbit}
+FLOW_RATES=${FLOW_RATES:-"0 500000 900000"}
+STREAMS=${STREAMS:-"10000:4"}
+DURATION=${DURATION:-10}
+LOG_DIR=$(mktemp -d /tmp/flow_benchmark.XXXXXX)
+
+source "$(dirname "$0")/benchmark_common.sh"
+require_binaries
+
+common_args=(--set qos.reliable=true --set qos.max_instances=64)
+if [ -n "${CONFIG:-}" ]; then
+    common_args+=(--config "$CONFIG")
+fi
+
+if ! tc qdisc replace dev lo root tbf rate "$LINK_RATE" burst 16kb \
+        latency 20ms; then
+    echo "ERROR: could not rate-limit the loopback interface (run as root)"
+    exit 1
+fi
+trap 'tc qdisc del dev lo root 2>/dev/null' EXIT
+
+echo "logs in $LOG_DIR, link limited to $LINK_RATE"
+printf "%12s  %12s  %10s  %14s\n" "flow B/s" "delivered/s" "throttled" \
+        "avg delay us"
+for rate in $FLOW_RATES; do
+    sub_log="$LOG_DIR/sub_$rate.log"
+    pub_log="$LOG_DIR/pub_$rate.log"
+    "$BIN_DIR/example_subscriber" "${common_args[@]}" \
+            --set subscriber.print_samples=false > "$sub_log" 2>&1 &
+    sub_pid=$!
+    "$BIN_DIR/example_publisher" "${common_args[@]}" \
+            --set "schedule.streams=$STREAMS" \
+            --set "flow.bytes_per_second=$rate" > "$pub_log" 2>&1 &
+    pub_pid=$!
+
+    sleep "$DURATION"
+    kill -INT $pub_pid; wait $pub_pid
+    # let the reliable protocol finish repairing before counting
+    sleep 1
+    kill -INT $sub_pid; wait $sub_pid
+
+    delivered=$(grep "^take stats:" "$sub_log" | tail -1 |
+            sed -n 's/.* samples = \([0-9]*\),.*/\1/p')
+    flow_line=$(grep "^flow control:" "$pub_log" | tail -1)
+    throttled=$(echo "$flow_line" | sed -n 's/.*throttled = \([0-9]*\),.*/\1/p')
+    delay=$(echo "$flow_line" |
+            sed -n 's/.*avg queueing delay = \([0-9.e+-]*\) us.*/\1/p')
+    printf "%12s  %12s  %10s  %14s\n" "$rate" \
+            "$(awk -v n=${delivered:-0} -v d=$DURATION \
+                    'BEGIN { printf "%.0f", n / d }')" \
+            "${throttled:--}" "${delay:--}"
+done
@@ -0,0 +1,83 @@
+// (c) Copyright, Real-Time Innovations, 2021.  All rights reserved.
+// RTI grants Licensee a license to use, modify, compile, and create derivative
+// works of the software solely for use with RTI Connext DDS. Licensee may
+// redistribute copies of the software provided that all such copies are subject
+// to this license. The software is provided "as is", with no warranty of any
+// type, including any warranty for fitness for any purpose. RTI is under no
+// obligation to maintain or support the software. RTI shall not be liable for
+// any incidental or consequential damages arising out of the use or inability
+// to use the software.
+
+#include "lane_router.h"
+
+#include <cstdlib>
+#include <sstream>
+
+namespace {
+
+// a whole decimal int, nothing else
+bool parse_id(const std::string &text, DDS_Long *id)
+{
+    if (text.empty()) {
+        return false;
+    }
+    char *end = NULL;
+    auto value = std::strtol(text.c_str(), &end, 10);
+    if (*end != '\0' || value < -2147483647L - 1 || value > 2147483647L) {
+        return false;
+    }
+    *id = static_cast<DDS_Long>(value);
+    return true;
+}
+
+}  // namespace
+
+const char *lane_name(Lane lane)
+{
+    switch (lane) {
+    case LANE_BULK:
+        return "bulk";
+    case LANE_URGENT:
+        return "urgent";
+    default:
+        return "unknown";
+    }
+}
+
+bool parse_lane_ids(
+        const std::string &text,
+        std::vector<DDS_Long> *ids,
+        std::ostream &errors)
+{
+    ids->clear();
+    std::istringstream input(text);
+    std::string item;
+    while (std::getline(input, item, ',')) {
+        item.erase(0, item.find_first_not_of(" \t"));
+        item.erase(item.find_last_not_of(" \t") + 1);
+        // a '-' after the first character separates a range
+        auto dash = item.find('-', 1);
+        DDS_Long first;
+        DDS_Long last;
+        if (dash == std::string::npos) {
+            if (!parse_id(item, &first)) {
+                errors << "ERROR: expected an id, got \"" << item << "\""
+                        << std::endl;
+                return false;
+            }
+            last = first;
+        } else if (!parse_id(item.substr(0, dash), &first) ||
+                !parse_id(item.substr(dash + 1), &last) || last < first ||
+                static_cast<long>(last) - first >= 65536) {
+            errors << "ERROR: expected first-last (at most 65536 ids), got \""
+                    << item << "\"" << std::endl;
+            return false;
+        }
+        for (long id = first; id <= last; ++id) {
+            ids->push_back(static_cast<DDS_Long>(id));
+        }
+    }
+    std::sort(ids->begin(), ids->end());
+    ids->erase(std::unique(ids->begin(), ids->end()), ids->end());
+    return true;
+}
@@ -0,0 +1,70 @@
+// (c) Copyright, Real-Time Innovations, 2021.  All rights reserved.
+// RTI grants Licensee a license to use, modify, compile, and create derivative
+// works of the software solely for use with RTI Connext DDS. Licensee may
+// redistribute copies of the software provided that all such copies are subject
+// to this license. The software is provided "as is", with no warranty of any
+// type, including any warranty for fitness for any purpose. RTI is under no
+// obligation to maintain or support the software. RTI shall not be liable for
+// any incidental or consequential damages arising out of the use or inability
+// to use the software.
+
+#ifndef LANE_ROUTER_H
+#define LANE_ROUTER_H
+
+#include <algorithm>
+#include <iostream>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "rti_me_c.h"
+#include "example.h"
+
+// Priority lanes. By default every sample goes through one DataWriter and
+// one DataReader, so a burst of bulk samples fills the history and the
+// reliability window that an urgent control message then has to queue
+// behind. With lanes.urgent_ids set, the samples of those ids go on an
+// urgent lane instead: a writer and a reader of their own, with their own
+// object ids, on a topic of their own (my_topic_urgent), with a short
+// history and a fast heartbeat, outside the flow controller and batching.
+// dds_setup.h builds each lane's QoS and DPSE data.
+//
+// Connext Micro has no TRANSPORT_PRIORITY QoS, so the lanes share the UDP
+// transport and are kept apart only above it.
+enum Lane {
+    LANE_BULK = 0,
+    LANE_URGENT,
+    LANE_COUNT
+};
+
+const char *lane_name(Lane lane);
+
+// "id,id,first-last,..." (e.g. "0,7,100-109"), into a sorted list
+bool parse_lane_ids(
+        const std::string &text,
+        std::vector<DDS_Long> *ids,
+        std::ostream &errors);
+
+// Picks the lane of each sample, by id
+class LaneRouter {
+public:
+    // ids must be sorted; empty routes everything to LANE_BULK
+    explicit LaneRouter(std::vector<DDS_Long> urgent_ids)
+        : urgent_ids_(std::move(urgent_ids))
+    {
+    }
+
+    bool enabled() const { return !urgent_ids_.empty(); }
+
+    Lane route(const my_type &sample) const
+    {
+        return std::binary_search(
+                        urgent_ids_.begin(), urgent_ids_.end(), sample.id)
+                ? LANE_URGENT : LANE_BULK;
+    }
+
+private:
+    const std::vector<DDS_Long> urgent_ids_;
+};
+
+#endif
@@ -0,0 +1,65 @@
+#!/bin/bash
+# (c) Copyright, Real-Time Innovations, 2021.  All rights reserved.
+# RTI grants Licensee a license to use, modify, compile, and create derivative
+# works of the software solely for use with RTI Connext DDS. Licensee may
+# redistribute copies of the software provided that all such copies are subject
+# to this license. The software is provided "as is", with no warranty of any
+# type, including any warranty for fitness for any purpose. RTI is under no
+# obligation to maintain or support the software. RTI shall not be liable for
+# any incidental or consequential damages arising out of the use or inability
+# to use the software.
+
+# Latency of urgent samples as the bulk load grows. For each bulk stream
+# count in LOADS, runs benchmark_runner.sh (one publisher, one subscriber)
+# with one urgent stream (id 0, at URGENT_HZ) next to that many bulk
+# streams (ids 1 and up, at BULK_HZ), twice: once on a single lane and
+# once with id 0 on the urgent lane (lanes.urgent_ids=0). Prints one line
+# per load: the delivered rate, the p99 of all samples on a single lane,
+# and with lanes the p99 of all samples and of the urgent ones alone.
+#
+#     ./lanes_benchmark.sh objs/x64Linux4gcc7.3.0_cert
+#
+# Environment: LOADS (default "16 64 256 1024"), URGENT_HZ (default 100),
+# BULK_HZ (default 1000), PAYLOAD (publisher.payload_bytes, default 64),
+# DURATION (seconds per run, default 10), CORES, SETTINGS and CONFIG as
+# for benchmark_runner.sh.
+
+set -u
+
+BIN_DIR=${1:-objs/${RTIME_TARGET_NAME:-x64Linux4gcc7.3.0_cert}}
+LOADS=${LOADS:-"16 64 256 1024"}
+URGENT_HZ=${URGENT_HZ:-100}
+BULK_HZ=${BULK_HZ:-1000}
+LOG_DIR=$(mktemp -d /tmp/lanes_benchmark.XXXXXX)
+
+source "$(dirname "$0")/benchmark_common.sh"
+require_binaries
+
+# run one load on a single lane ("single") or with lanes ("lanes")
+run() {
+    local name=$1_$2
+    local lane_setting=""
+    if [ "$1" = lanes ]; then
+        lane_setting="lanes.urgent_ids=0"
+    fi
+    run_point "$name" "$URGENT_HZ:1,$BULK_HZ:$2" "${PAYLOAD:-64}" \
+            "${SETTINGS:-} $lane_setting"
+}
+
+printf "%-7s %12s %14s %13s %14s\n" streams delivered/s single_p99_us \
+        lanes_p99_us urgent_p99_us
+for load in $LOADS; do
+    if ! run single "$load" || ! run lanes "$load"; then
+        echo "ERROR: no report for $load streams, see $LOG_DIR"
+        continue
+    fi
+    # the urgent lane's latency comes from the subscriber's own stats file
+    urgent=$(report_value "$(subscriber_stats "lanes_$load")" \
+            urgent_latency_p99_us)
+    printf "%-7s %12s %14s %13s %14s\n" "$load" \
+            "$(report_value "$LOG_DIR/lanes_$load.txt" delivered_per_s)" \
+            "$(report_value "$LOG_DIR/single_$load.txt" latency_p99_us)" \
+            "$(report_value "$LOG_DIR/lanes_$load.txt" latency_p99_us)" \
+            "${urgent:-n/a}"
+done
+echo "logs in $LOG_DIR"
@@ -0,0 +1,385 @@
+// (c) Copyright, Real-Time Innovations, 2021.  All rights reserved.
+// RTI grants Licensee a license to use, modify, compile, and create derivative
+// works of the software solely for use with RTI Connext DDS. Licensee may
+// redistribute copies of the software provided that all such copies are subject
+// to this license. The software is provided "as is", with no warranty of any
+// type, including any warranty for fitness for any purpose. RTI is under no
+// obligation to maintain or support the software. RTI shall not be liable for
+// any incidental or consequential damages arising out of the use or inability
+// to use the software.
+
+#ifndef LATENCY_STATS_H
+#define LATENCY_STATS_H
+
+#include <atomic>
+#include <cstdint>
+#include <ctime>
+#include <iostream>
+
+#include "rti_me_c.h"
+
+#include "cyclic_scheduler.h"
+
+inline std::int64_t dds_time_to_ns(const DDS_Time_t &time)
+{
+    return static_cast<std::int64_t>(time.sec) * 1000000000 + time.nanosec;
+}
+
+inline DDS_Time_t ns_to_dds_time(std::int64_t ns)
+{
+    DDS_Time_t time;
+    time.sec = static_cast<DDS_Long>(ns / 1000000000);
+    time.nanosec = static_cast<DDS_UnsignedLong>(ns % 1000000000);
+    return time;
+}
+
+// the clock Connext Micro stamps samples with by default
+inline std::int64_t realtime_now_ns()
+{
+    struct timespec now;
+    clock_gettime(CLOCK_REALTIME, &now);
+    return static_cast<std::int64_t>(now.tv_sec) * 1000000000 + now.tv_nsec;
+}
+
+// Latency histogram and totals, e.g. write-to-receive latency as the
+// difference between SampleInfo's reception_timestamp and source_timestamp.
+// Both come from the same clock only when publisher and subscriber share a
+// host (or synchronized clocks). Written by one thread taking samples at a
+// time, read by main().
+class LatencyStats {
+public:
+    static const int k_histogram_buckets = 16;  // <1 us, 1-2 us, ... 16+ ms
+    // The same range, log-linear: 1 us wide up to 8 us, then each of the
+    // log2 buckets split into 8, so no bucket is more than 12.5% wide.
+    // It is what is recorded; the log2 histogram is summed from it.
+    static const int k_fine_buckets = 8 + (k_histogram_buckets - 5) * 8 + 1;
+
+    struct Snapshot {
+        std::uint64_t count;
+        std::int64_t total_ns;
+        std::int64_t max_ns;
+        std::uint64_t histogram[k_histogram_buckets];
+        std::uint64_t fine_histogram[k_fine_buckets];
+
+        // upper bound of the histogram bucket holding that fraction (or
+        // the maximum, if lower)
+        double percentile_us(double fraction) const
+        {
+            auto max_us = max_ns / 1000.0;
+            auto rank = static_cast<std::uint64_t>(fraction * count);
+            std::uint64_t seen = 0;
+            for (auto i = 0; i < k_histogram_buckets - 1; ++i) {
+                seen += histogram[i];
+                if (seen > rank) {
+                    return (1 << i) < max_us ? (1 << i) : max_us;
+                }
+            }
+            return max_us;
+        }
+
+        // that fraction from the log-linear histogram, interpolated within
+        // its bucket (or the maximum, if lower): a shift of the latency
+        // moves it gradually rather than by a factor of two, so it suits a
+        // series that is fitted or compared over time
+        double fine_percentile_us(double fraction) const
+        {
+            auto max_us = max_ns / 1000.0;
+            auto rank = static_cast<std::uint64_t>(fraction * count);
+            std::uint64_t seen = 0;
+            for (auto i = 0; i < k_fine_buckets - 1; ++i) {
+                if (seen + fine_histogram[i] > rank) {
+                    auto lower = fine_lower_us(i);
+                    auto upper = fine_lower_us(i + 1);
+                    auto value = lower + (upper - lower) *
+                            (rank - seen + 1) / fine_histogram[i];
+                    return value < max_us ? value : max_us;
+                }
+                seen += fine_histogram[i];
+            }
+            return max_us;
+        }
+    };
+
+    LatencyStats()
+    {
+        for (auto &bucket : fine_histogram_) {
+            bucket.store(0, std::memory_order_relaxed);
+        }
+    }
+
+    // log-linear bucket of a latency in whole microseconds
+    static int fine_bucket(std::int64_t us)
+    {
+        if (us < 8) {
+            return static_cast<int>(us);
+        }
+        auto octave = 3;
+        while (octave < k_histogram_buckets - 2 && (us >> (octave + 1)) > 0) {
+            ++octave;
+        }
+        if (octave == k_histogram_buckets - 2) {
+            return k_fine_buckets - 1;
+        }
+        return 8 + (octave - 3) * 8 +
+                static_cast<int>((us >> (octave - 3)) - 8);
+    }
+
+    // lower bound of a log-linear bucket, in microseconds
+    static double fine_lower_us(int bucket)
+    {
+        if (bucket < 8) {
+            return bucket;
+        }
+        auto octave = 3 + (bucket - 8) / 8;
+        return static_cast<double>((8 + (bucket - 8) % 8) << (octave - 3));
+    }
+
+    // the log2 bucket a log-linear one lies in
+    static int coarse_bucket(int fine)
+    {
+        if (fine < 8) {
+            auto bucket = 0;
+            for (; fine > 0; fine >>= 1) {
+                ++bucket;
+            }
+            return bucket;
+        }
+        return 4 + (fine - 8) / 8;
+    }
+
+    void record(std::int64_t latency_ns)
+    {
+        if (latency_ns < 0) {
+            // the clocks disagree; count it, but as zero
+            latency_ns = 0;
+        }
+        count_.fetch_add(1, std::memory_order_relaxed);
+        total_ns_.fetch_add(latency_ns, std::memory_order_relaxed);
+        auto max = max_ns_.load(std::memory_order_relaxed);
+        while (latency_ns > max &&
+                !max_ns_.compare_exchange_weak(
+                        max, latency_ns, std::memory_order_relaxed)) {
+        }
+
+        fine_histogram_[fine_bucket(latency_ns / 1000)].fetch_add(
+                1, std::memory_order_relaxed);
+    }
+
+    // the counters so far, without resetting them
+    Snapshot snapshot() const
+    {
+        Snapshot snapshot;
+        snapshot.count = count_.load(std::memory_order_relaxed);
+        snapshot.total_ns = total_ns_.load(std::memory_order_relaxed);
+        snapshot.max_ns = max_ns_.load(std::memory_order_relaxed);
+        for (auto i = 0; i < k_fine_buckets; ++i) {
+            snapshot.fine_histogram[i] =
+                    fine_histogram_[i].load(std::memory_order_relaxed);
+        }
+        sum_histogram(&snapshot);
+        return snapshot;
+    }
+
+    // Read and zero the counters: the samples recorded since the previous
+    // call. Samples recorded concurrently land in this interval or the next.
+    Snapshot take_interval()
+    {
+        Snapshot snapshot;
+        snapshot.count = count_.exchange(0, std::memory_order_relaxed);
+        snapshot.total_ns = total_ns_.exchange(0, std::memory_order_relaxed);
+        snapshot.max_ns = max_ns_.exchange(0, std::memory_order_relaxed);
+        for (auto i = 0; i < k_fine_buckets; ++i) {
+            snapshot.fine_histogram[i] =
+                    fine_histogram_[i].exchange(0, std::memory_order_relaxed);
+        }
+        sum_histogram(&snapshot);
+        return snapshot;
+    }
+
+    void print(std::ostream &os) const
+    {
+        auto count = count_.load(std::memory_order_relaxed);
+        os << "latency: samples = " << count << ", avg = "
+                << (count ? total_ns_.load(std::memory_order_relaxed) / 1000.0
+                        / count : 0.0)
+                << " us, max = "
+                << max_ns_.load(std::memory_order_relaxed) / 1000.0 << " us"
+                << std::endl;
+        auto current = snapshot();
+        os << "\tlatency histogram (us):";
+        for (auto i = 0; i < k_histogram_buckets; ++i) {
+            auto n = current.histogram[i];
+            if (n == 0) {
+                continue;
+            }
+            os << " [" << (i == 0 ? 0 : 1 << (i - 1))
+                    << (i == k_histogram_buckets - 1 ? "+" : "")
+                    << "]=" << n;
+        }
+        os << std::endl;
+    }
+
+    // the log2 histogram of a snapshot from its log-linear one
+    static void sum_histogram(Snapshot *snapshot)
+    {
+        for (auto &bucket : snapshot->histogram) {
+            bucket = 0;
+        }
+        for (auto i = 0; i < k_fine_buckets; ++i) {
+            snapshot->histogram[coarse_bucket(i)] +=
+                    snapshot->fine_histogram[i];
+        }
+    }
+
+private:
+    std::atomic<std::uint64_t> count_{0};
+    std::atomic<std::int64_t> total_ns_{0};
+    std::atomic<std::int64_t> max_ns_{0};
+    std::atomic<std::uint64_t> fine_histogram_[k_fine_buckets];
+};
+
+// One-way latency of every sample, split at the reception timestamp:
+//     transport = reception_timestamp - source_timestamp
+//     dispatch  = processed - reception_timestamp
+//     total     = processed - source_timestamp
+// where "processed" is when the application got to the sample (listener or
+// event loop). Micro stamps reception with the realtime clock; when the
+// publisher writes monotonic source timestamps (latency.monotonic_source_
+// timestamp, co-hosted runs only) reception is mapped onto the monotonic
+// clock first, so an NTP step can't show up as latency.
+//
+// transport keeps the cumulative totals; the three interval_ stats are
+// drained once per second by main() for the per-second histograms.
+class OneWayLatency {
+public:
+    explicit OneWayLatency(bool monotonic_source)
+        : monotonic_source_(monotonic_source)
+    {
+    }
+
+    // Offset from the monotonic to the realtime clock right now; take it
+    // once per batch of samples, not per sample.
+    static std::int64_t realtime_offset_ns()
+    {
+        return realtime_now_ns() - monotonic_now_ns();
+    }
+
+    // batched_ns is how long a record waited in the publisher's batch
+    // before the batch was written (and stamped); it counts as transport
+    void record(
+            const DDS_SampleInfo &info,
+            std::int64_t processed_mono_ns,
+            std::int64_t realtime_offset_ns,
+            std::int64_t batched_ns = 0)
+    {
+        auto reception_ns =
+                dds_time_to_ns(info.reception_timestamp) - realtime_offset_ns;
+        auto source_ns = dds_time_to_ns(info.source_timestamp) - batched_ns;
+        if (!monotonic_source_) {
+            source_ns -= realtime_offset_ns;
+        }
+        transport.record(reception_ns - source_ns);
+        interval_transport.record(reception_ns - source_ns);
+        interval_dispatch.record(processed_mono_ns - reception_ns);
+        interval_total.record(processed_mono_ns - source_ns);
+    }
+
+    // one line per interval with samples: count, then p50/p99/max per part
+    void print_interval(std::ostream &os, std::int64_t second)
+    {
+        auto transport_interval = interval_transport.take_interval();
+        auto dispatch_interval = interval_dispatch.take_interval();
+        auto total_interval = interval_total.take_interval();
+        if (transport_interval.count == 0) {
+            return;
+        }
+        os << "one-way latency @ " << second << " s: samples = "
+                << transport_interval.count;
+        print_part(os, "transport", transport_interval);
+        print_part(os, "dispatch", dispatch_interval);
+        print_part(os, "total", total_interval);
+        os << std::endl;
+    }
+
+    LatencyStats transport;
+    LatencyStats interval_transport;
+    LatencyStats interval_dispatch;
+    LatencyStats interval_total;
+
+private:
+    static void print_part(
+            std::ostream &os,
+            const char *name,
+            const LatencyStats::Snapshot &snapshot)
+    {
+        os << ", " << name << " p50/p99/max = "
+                << snapshot.percentile_us(0.5) << "/"
+                << snapshot.percentile_us(0.99) << "/"
+                << snapshot.max_ns / 1000.0 << " us";
+    }
+
+    const bool monotonic_source_;
+};
+
+// How long a late-joining reader takes to catch up on the history a
+// transient-local writer kept for it. A sample written before the reader
+// was enabled is historical, and catch-up lasts from enabling the reader
+// until the last historical sample has been processed. Source times are
+// compared on the clock the publisher stamps with, as in OneWayLatency;
+// with realtime stamps across hosts, clock skew blurs the boundary by as
+// much. Updated by one thread taking samples at a time.
+class LateJoinerCatchUp {
+public:
+    explicit LateJoinerCatchUp(bool monotonic_source)
+        : monotonic_source_(monotonic_source),
+          enabled_mono_ns_(0),
+          enabled_source_ns_(0)
+    {
+    }
+
+    // just before DDS_Entity_enable(), so no sample arrives first
+    void start()
+    {
+        enabled_mono_ns_ = monotonic_now_ns();
+        enabled_source_ns_ =
+                monotonic_source_ ? enabled_mono_ns_ : realtime_now_ns();
+    }
+
+    // source_ns as the publisher stamped the sample (less any time in a
+    // batch)
+    void record(std::int64_t source_ns, std::int64_t processed_mono_ns)
+    {
+        if (source_ns >= enabled_source_ns_) {
+            return;
+        }
+        historical_.fetch_add(1, std::memory_order_relaxed);
+        last_ns_.store(
+                processed_mono_ns - enabled_mono_ns_,
+                std::memory_order_relaxed);
+    }
+
+    std::uint64_t historical() const
+    {
+        return historical_.load(std::memory_order_relaxed);
+    }
+    double catch_up_ms() const
+    {
+        return last_ns_.load(std::memory_order_relaxed) / 1e6;
+    }
+
+    void print(std::ostream &os) const
+    {
+        os << "late joiner: historical samples = " << historical()
+                << ", caught up " << catch_up_ms() << " ms after enabling"
+                << std::endl;
+    }
+
+private:
+    const bool monotonic_source_;
+    std::int64_t enabled_mono_ns_;
+    std::int64_t enabled_source_ns_;
+    std::atomic<std::uint64_t> historical_{0};
+    std::atomic<std::int64_t> last_ns_{0};
+};
+
+#endif
@@ -0,0 +1,228 @@
+// (c) Copyright, Real-Time Innovations, 2021.  All rights reserved.
+// RTI grants Licensee a license to use, modify, compile, and create derivative
+// works of the software solely for use with RTI Connext DDS. Licensee may
+// redistribute copies of the software provided that all such copies are subject
+// to this license. The software is provided "as is", with no warranty of any
+// type, including any warranty for fitness for any purpose. RTI is under no
+// obligation to maintain or support the software. RTI shall not be liable for
+// any incidental or consequential damages arising out of the use or inability
+// to use the software.
+
+#ifndef LATEST_VALUE_CACHE_H
+#define LATEST_VALUE_CACHE_H
+
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+
+#include "rti_me_c.h"
+#include "example.h"
+
+#include "common_config.h"
+
+// The most recent value seen for one my_type instance (one id)
+struct LatestValue {
+    DDS_Long id;
+    DDS_InstanceStateKind instance_state;
+    DDS_Time_t source_timestamp;
+    std::uint64_t update_count;
+    char msg[k_my_type_msg_max_length + 1];
+};
+
+// Reader-side cache holding the latest value per key. The table is a flat,
+// open-addressed array sized once at construction (before the DataReader is
+// enabled), so updating it from the listener never allocates.
+//
+// There is one writer at a time: the DataReader listener, which copies each
+// loaned sample in place into its slot (with two lanes, the subscriber
+// serializes their listeners). Any number of application threads can
+// take snapshots concurrently without locks; each slot is guarded by a
+// sequence counter (seqlock) and a reader simply retries if it raced with an
+// update.
+class LatestValueCache {
+public:
+    // capacity is rounded up to a power of two
+    explicit LatestValueCache(std::size_t capacity)
+        : mask_(round_up_pow2(capacity) - 1),
+          slots_(new Slot[mask_ + 1]),
+          size_(0),
+          overflows_(0)
+    {
+    }
+
+    // --- listener thread only -------------------------------------------
+
+    // store a valid sample along with the instance state from its SampleInfo
+    bool update(const my_type &sample, const struct DDS_SampleInfo &info)
+    {
+        auto slot = find_or_insert(sample.id);
+        if (slot == NULL) {
+            return false;
+        }
+        begin_write(*slot);
+        slot->value.instance_state = info.instance_state;
+        slot->value.source_timestamp = info.source_timestamp;
+        slot->value.update_count++;
+        std::strncpy(slot->value.msg, sample.msg, k_my_type_msg_max_length);
+        slot->value.msg[k_my_type_msg_max_length] = '\0';
+        end_write(*slot);
+        return true;
+    }
+
+    // record a dispose or unregister (a sample without valid data); the last
+    // value is kept so consumers can still see what the instance held
+    bool update_state(DDS_Long id, DDS_InstanceStateKind instance_state)
+    {
+        auto slot = find_or_insert(id);
+        if (slot == NULL) {
+            return false;
+        }
+        begin_write(*slot);
+        slot->value.instance_state = instance_state;
+        end_write(*slot);
+        return true;
+    }
+
+    // --- any thread -------------------------------------------------------
+
+    // copy out a consistent view of the latest value for id
+    bool snapshot(DDS_Long id, LatestValue *out) const
+    {
+        auto slot = find(id);
+        if (slot == NULL) {
+            return false;
+        }
+        read_slot(*slot, out);
+        return true;
+    }
+
+    // call f(const LatestValue &) with a snapshot of every cached key
+    template <typename F>
+    void for_each(F f) const
+    {
+        LatestValue value;
+        for (std::size_t i = 0; i <= mask_; ++i) {
+            if (slots_[i].used.load(std::memory_order_acquire)) {
+                read_slot(slots_[i], &value);
+                f(value);
+            }
+        }
+    }
+
+    std::size_t size() const { return size_.load(std::memory_order_relaxed); }
+    std::size_t capacity() const { return mask_ + 1; }
+
+    // number of updates dropped because the table was full
+    std::uint64_t overflows() const
+    {
+        return overflows_.load(std::memory_order_relaxed);
+    }
+
+private:
+    struct Slot {
+        std::atomic<bool> used;
+        std::atomic<std::uint32_t> sequence;
+        LatestValue value;
+
+        Slot() : used(false), sequence(0), value() {}
+    };
+
+    static std::size_t round_up_pow2(std::size_t n)
+    {
+        std::size_t pow2 = 1;
+        while (pow2 < n) {
+            pow2 <<= 1;
+        }
+        return pow2;
+    }
+
+    std::size_t home(DDS_Long id) const
+    {
+        // Fibonacci hashing spreads sequential ids across the table
+        return ((std::uint32_t)id * 2654435769u) & mask_;
+    }
+
+    const Slot *find(DDS_Long id) const
+    {
+        for (std::size_t probe = 0, i = home(id);
+                probe <= mask_;
+                ++probe, i = (i + 1) & mask_) {
+            if (!slots_[i].used.load(std::memory_order_acquire)) {
+                return NULL;
+            }
+            if (slots_[i].value.id == id) {
+                return &slots_[i];
+            }
+        }
+        return NULL;
+    }
+
+    Slot *find_or_insert(DDS_Long id)
+    {
+        for (std::size_t probe = 0, i = home(id);
+                probe <= mask_;
+                ++probe, i = (i + 1) & mask_) {
+            auto &slot = slots_[i];
+            if (!slot.used.load(std::memory_order_relaxed)) {
+                // publish the key before marking the slot used so that a
+                // concurrent find() never sees a used slot with a stale id
+                slot.value.id = id;
+                slot.used.store(true, std::memory_order_release);
+                size_.fetch_add(1, std::memory_order_relaxed);
+                return &slot;
+            }
+            if (slot.value.id == id) {
+                return &slot;
+            }
+        }
+        overflows_.fetch_add(1, std::memory_order_relaxed);
+        return NULL;
+    }
+
+    static void begin_write(Slot &slot)
+    {
+        auto seq = slot.sequence.load(std::memory_order_relaxed);
+        slot.sequence.store(seq + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+    }
+
+    static void end_write(Slot &slot)
+    {
+        auto seq = slot.sequence.load(std::memory_order_relaxed);
+        slot.sequence.store(seq + 1, std::memory_order_release);
+    }
+
+    static void read_slot(const Slot &slot, LatestValue *out)
+    {
+        std::uint32_t before;
+        std::uint32_t after;
+        do {
+            before = slot.sequence.load(std::memory_order_acquire);
+            std::memcpy(out, &slot.value, sizeof(*out));
+            std::atomic_thread_fence(std::memory_order_acquire);
+            after = slot.sequence.load(std::memory_order_relaxed);
+        } while ((before & 1) || before != after);
+    }
+
+    const std::size_t mask_;
+    std::unique_ptr<Slot[]> slots_;
+    std::atomic<std::size_t> size_;
+    std::atomic<std::uint64_t> overflows_;
+};
+
+inline const char *instance_state_to_string(DDS_InstanceStateKind state)
+{
+    switch (state) {
+    case DDS_ALIVE_INSTANCE_STATE:
+        return "ALIVE";
+    case DDS_NOT_ALIVE_DISPOSED_INSTANCE_STATE:
+        return "DISPOSED";
+    case DDS_NOT_ALIVE_NO_WRITERS_INSTANCE_STATE:
+        return "NO_WRITERS";
+    default:
+        return "UNKNOWN";
+    }
+}
+
+#endif
@@ -0,0 +1,41 @@
+// (c) Copyright, Real-Time Innovations, 2021.  All rights reserved.
+// RTI grants Licensee a license to use, modify, compile, and create derivative
+// works of the software solely for use with RTI Connext DDS. Licensee may
+// redistribute copies of the software provided that all such copies are subject
+// to this license. The software is provided "as is", with no warranty of any
+// type, including any warranty for fitness for any purpose. RTI is under no
+// obligation to maintain or support the software. RTI shall not be liable for
+// any incidental or consequential damages arising out of the use or inability
+// to use the software.
+
+#ifndef MY_TYPE_PLUGIN_H
+#define MY_TYPE_PLUGIN_H
+
+#include "type_plugin.h"
+#include "example.h"
+#include "common_config.h"
+
+// example.idl's my_type, described for type_plugin.h:
+//     struct my_type { long id; //@key
+//                      string<128> msg; };
+struct MyTypeDescription {
+    typedef my_type Struct;
+    typedef type_plugin::Fields<
+            type_plugin::LongField<my_type, &my_type::id, true>,
+            type_plugin::StringField<
+                    my_type, &my_type::msg, k_my_type_msg_max_length>>
+        Members;
+};
+
+// wire-compatible alternative to my_typeTypePlugin_get()
+typedef type_plugin::TypePlugin<MyTypeDescription> MyTypeTemplatePlugin;
+
+static_assert(
+        MyTypeTemplatePlugin::max_serialized_key_size() == 4,
+        "the my_type key is a single long");
+static_assert(
+        MyTypeTemplatePlugin::max_serialized_size()
+                == 4 + 4 + k_my_type_msg_max_length + 1,
+        "id, then the string length and up to 128 characters plus NUL");
+
+#endif
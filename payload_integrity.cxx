@@ -0,0 +1,108 @@
+// (c) Copyright, Real-Time Innovations, 2021.  All rights reserved.
+// RTI grants Licensee a license to use, modify, compile, and create derivative
+// works of the software solely for use with RTI Connext DDS. Licensee may
+// redistribute copies of the software provided that all such copies are subject
+// to this license. The software is provided "as is", with no warranty of any
+// type, including any warranty for fitness for any purpose. RTI is under no
+// obligation to maintain or support the software. RTI shall not be liable for
+// any incidental or consequential damages arising out of the use or inability
+// to use the software.
+
+#include "payload_integrity.h"
+
+#include <cstring>
+
+#include "crc32c.h"
+
+namespace {
+
+const char k_hex_digits[] = "0123456789abcdef";
+
+std::uint32_t payload_crc(DDS_Long id, const char *payload, std::size_t length)
+{
+    auto value = static_cast<std::uint32_t>(id);
+    unsigned char id_bytes[4] = {
+        static_cast<unsigned char>(value),
+        static_cast<unsigned char>(value >> 8),
+        static_cast<unsigned char>(value >> 16),
+        static_cast<unsigned char>(value >> 24)
+    };
+    auto crc = crc32c_update(0xffffffff, id_bytes, sizeof(id_bytes));
+    return ~crc32c_update(crc, payload, length);
+}
+
+int hex_value(char c)
+{
+    if (c >= '0' && c <= '9') {
+        return c - '0';
+    }
+    if (c >= 'a' && c <= 'f') {
+        return c - 'a' + 10;
+    }
+    return -1;
+}
+
+// the CRC in a trailer at the end of msg[0..length), if there is one
+bool parse_trailer(const char *msg, std::size_t length, std::uint32_t *crc)
+{
+    if (length < k_integrity_trailer_length) {
+        return false;
+    }
+    auto trailer = msg + length - k_integrity_trailer_length;
+    if (trailer[0] != '#') {
+        return false;
+    }
+    std::uint32_t value = 0;
+    for (std::size_t i = 1; i < k_integrity_trailer_length; ++i) {
+        auto digit = hex_value(trailer[i]);
+        if (digit < 0) {
+            return false;
+        }
+        value = value << 4 | static_cast<std::uint32_t>(digit);
+    }
+    *crc = value;
+    return true;
+}
+
+}  // namespace
+
+bool integrity_seal(my_type *sample)
+{
+    auto length = std::strlen(sample->msg);
+    if (length > k_integrity_max_payload) {
+        return false;
+    }
+    auto crc = payload_crc(sample->id, sample->msg, length);
+    auto trailer = sample->msg + length;
+    trailer[0] = '#';
+    for (std::size_t i = k_integrity_trailer_length - 1; i > 0; --i) {
+        trailer[i] = k_hex_digits[crc & 0xf];
+        crc >>= 4;
+    }
+    trailer[k_integrity_trailer_length] = '\0';
+    return true;
+}
+
+bool integrity_unseal(my_type *sample)
+{
+    if (integrity_verify(*sample) != INTEGRITY_OK) {
+        return false;
+    }
+    sample->msg[std::strlen(sample->msg) - k_integrity_trailer_length] =
+            '\0';
+    return true;
+}
+
+IntegrityResult integrity_verify(const my_type &sample)
+{
+    auto length = std::strlen(sample.msg);
+    std::uint32_t expected;
+    if (!parse_trailer(sample.msg, length, &expected)) {
+        return INTEGRITY_MISSING;
+    }
+    auto crc = payload_crc(
+            sample.id,
+            sample.msg,
+            length - k_integrity_trailer_length);
+    return crc == expected ? INTEGRITY_OK : INTEGRITY_MISMATCH;
+}
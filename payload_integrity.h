@@ -0,0 +1,87 @@
+// (c) Copyright, Real-Time Innovations, 2021.  All rights reserved.
+// RTI grants Licensee a license to use, modify, compile, and create derivative
+// works of the software solely for use with RTI Connext DDS. Licensee may
+// redistribute copies of the software provided that all such copies are subject
+// to this license. The software is provided "as is", with no warranty of any
+// type, including any warranty for fitness for any purpose. RTI is under no
+// obligation to maintain or support the software. RTI shall not be liable for
+// any incidental or consequential damages arising out of the use or inability
+// to use the software.
+
+#ifndef PAYLOAD_INTEGRITY_H
+#define PAYLOAD_INTEGRITY_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <iostream>
+
+#include "rti_me_c.h"
+#include "example.h"
+
+#include "common_config.h"
+
+// End-to-end integrity for my_type, on top of the UDP checksum. my_type
+// has no field for it, so the publisher appends a trailer to msg:
+//     msg = payload '#' crc
+// where crc is 8 lower-case hex digits of the CRC32C (crc32c.h) of the id,
+// as 4 little-endian bytes, followed by the payload. The subscriber
+// recomputes it and counts samples whose trailer is missing or wrong.
+
+// '#' and 8 hex digits
+static const std::size_t k_integrity_trailer_length = 9;
+// the longest payload that still leaves room for the trailer
+static const std::size_t k_integrity_max_payload =
+        k_my_type_msg_max_length - k_integrity_trailer_length;
+
+// Append the trailer to msg; all of msg is the payload. False if it is
+// longer than k_integrity_max_payload; the sample is then left as it was.
+bool integrity_seal(my_type *sample);
+
+// Remove the trailer from a msg that may already be sealed (a replayed
+// recording or a snapshot), so it can be sealed again. Only a trailer that
+// verifies is removed; true if there was one.
+bool integrity_unseal(my_type *sample);
+
+enum IntegrityResult {
+    INTEGRITY_OK,
+    INTEGRITY_MISSING,
+    INTEGRITY_MISMATCH
+};
+
+IntegrityResult integrity_verify(const my_type &sample);
+
+// Counters for the subscriber; record() may run on the listener thread
+// while main() prints
+struct IntegrityStats {
+    std::atomic<std::uint64_t> verified{0};
+    std::atomic<std::uint64_t> missing{0};
+    std::atomic<std::uint64_t> mismatched{0};
+
+    void record(IntegrityResult result)
+    {
+        switch (result) {
+        case INTEGRITY_OK:
+            verified.fetch_add(1, std::memory_order_relaxed);
+            break;
+        case INTEGRITY_MISSING:
+            missing.fetch_add(1, std::memory_order_relaxed);
+            break;
+        case INTEGRITY_MISMATCH:
+            mismatched.fetch_add(1, std::memory_order_relaxed);
+            break;
+        }
+    }
+
+    void print(std::ostream &os) const
+    {
+        os << "integrity: verified = "
+                << verified.load(std::memory_order_relaxed)
+                << ", missing trailer = "
+                << missing.load(std::memory_order_relaxed)
+                << ", crc mismatch = "
+                << mismatched.load(std::memory_order_relaxed) << std::endl;
+    }
+};
+
+#endif
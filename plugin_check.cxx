@@ -0,0 +1,325 @@
+// (c) Copyright, Real-Time Innovations, 2021.  All rights reserved.
+// RTI grants Licensee a license to use, modify, compile, and create derivative
+// works of the software solely for use with RTI Connext DDS. Licensee may
+// redistribute copies of the software provided that all such copies are subject
+// to this license. The software is provided "as is", with no warranty of any
+// type, including any warranty for fitness for any purpose. RTI is under no
+// obligation to maintain or support the software. RTI shall not be liable for
+// any incidental or consequential damages arising out of the use or inability
+// to use the software.
+
+#include "plugin_check.h"
+
+#include <climits>
+#include <cstdint>
+#include <cstring>
+#include <random>
+#include <vector>
+
+#include "rti_me_c.h"
+#include "example.h"
+#include "examplePlugin.h"
+#include "my_type_plugin.h"
+
+#include "common_config.h"
+#include "cyclic_scheduler.h"
+
+namespace {
+
+const int k_random_ids = 1000;
+const int k_timing_rounds = 1000000;
+
+// keeps the timed loops from being optimized away
+volatile DDS_Octet g_check_sink;
+
+// the ids every check covers: the edges of the range, then random ones
+std::vector<DDS_Long> check_ids()
+{
+    std::vector<DDS_Long> ids = { 0, 1, -1, INT_MIN, INT_MAX };
+    std::mt19937 random(12345);
+    for (auto i = 0; i < k_random_ids; ++i) {
+        ids.push_back(static_cast<DDS_Long>(random()));
+    }
+    return ids;
+}
+
+typedef RTI_BOOL (*SerializeFunction)(
+        struct CDR_Stream_t *,
+        const void *,
+        void *);
+typedef RTI_BOOL (*DeserializeFunction)(
+        struct CDR_Stream_t *,
+        void *,
+        void *);
+typedef RTI_BOOL (*KeyHashFunction)(
+        struct NDDS_Type_Plugin *,
+        struct CDR_Stream_t *,
+        DDS_KeyHash_t *,
+        const void *,
+        void *);
+
+// the key hash of a sample with the given id; the generic path serializes
+// the key into stream, so it starts from the beginning every time
+bool key_hash(
+        KeyHashFunction function,
+        struct CDR_Stream_t *stream,
+        my_type *sample,
+        DDS_Long id,
+        DDS_KeyHash_t *hash)
+{
+    sample->id = id;
+    CDR_Stream_Reset(stream);
+    std::memset(hash->value, 0xa5, sizeof(hash->value));
+    return function(my_typeTypePlugin_get(), stream, hash, sample, NULL) ==
+            RTI_TRUE;
+}
+
+// ns per call, cycling through ids
+double time_key_hash(
+        KeyHashFunction function,
+        struct CDR_Stream_t *stream,
+        my_type *sample,
+        const std::vector<DDS_Long> &ids)
+{
+    DDS_KeyHash_t hash;
+    auto start = monotonic_now_ns();
+    for (auto i = 0; i < k_timing_rounds; ++i) {
+        key_hash(function, stream, sample, ids[i % ids.size()], &hash);
+        g_check_sink = hash.value[3];
+    }
+    return static_cast<double>(monotonic_now_ns() - start) / k_timing_rounds;
+}
+
+bool check_key_hash(std::ostream &os)
+{
+    char msg[k_my_type_msg_max_length + 1] = "";
+    my_type sample;
+    sample.msg = msg;
+    char key_buffer[64];
+    struct CDR_Stream_t stream;
+    CDR_Stream_Initialize(&stream, key_buffer, sizeof(key_buffer));
+
+    auto ids = check_ids();
+    auto mismatches = 0;
+    for (auto id : ids) {
+        DDS_KeyHash_t direct;
+        DDS_KeyHash_t generic;
+        if (!key_hash(my_type_instance_to_keyhash, &stream, &sample, id,
+                    &direct) ||
+                !key_hash(PluginHelper_instance_to_keyhash, &stream, &sample,
+                        id, &generic) ||
+                std::memcmp(direct.value, generic.value,
+                        sizeof(direct.value)) != 0) {
+            if (mismatches++ == 0) {
+                os << "ERROR: key hash of id " << id
+                        << " differs from PluginHelper_instance_to_keyhash"
+                        << std::endl;
+            }
+        }
+    }
+    os << "plugin check: key hash, " << ids.size() - mismatches << " of "
+            << ids.size() << " ids match the generic path" << std::endl;
+
+    // warm up both, so neither timing pays for the first pass over the ids
+    time_key_hash(my_type_instance_to_keyhash, &stream, &sample, ids);
+    time_key_hash(PluginHelper_instance_to_keyhash, &stream, &sample, ids);
+    auto direct_ns = time_key_hash(
+            my_type_instance_to_keyhash, &stream, &sample, ids);
+    auto generic_ns = time_key_hash(
+            PluginHelper_instance_to_keyhash, &stream, &sample, ids);
+    os << "plugin check: key hash per write/receive: direct " << direct_ns
+            << " ns, generic " << generic_ns << " ns" << std::endl;
+    return mismatches == 0;
+}
+
+// A serialize buffer and the samples to (de)serialize, shared by the
+// template plugin's checks
+struct PluginCheckState {
+    char buffer[MyTypeTemplatePlugin::max_serialized_size() + 8];
+    struct CDR_Stream_t stream;
+    char msg[k_my_type_msg_max_length + 1];
+    my_type sample;
+    char out_msg[k_my_type_msg_max_length + 1];
+    my_type out;
+
+    PluginCheckState()
+    {
+        CDR_Stream_Initialize(&stream, buffer, sizeof(buffer));
+        sample.id = 0;
+        sample.msg = msg;
+        out.id = 0;
+        out.msg = out_msg;
+    }
+
+    // msg of the given length, different for every id
+    void fill(DDS_Long id, std::size_t length)
+    {
+        sample.id = id;
+        for (std::size_t i = 0; i < length; ++i) {
+            msg[i] = static_cast<char>('a' + (id + i) % 26);
+        }
+        msg[length] = '\0';
+    }
+
+    // false if the sample does not serialize; else its bytes in buffer
+    bool serialize(SerializeFunction function, RTI_UINT32 *length)
+    {
+        CDR_Stream_Reset(&stream);
+        if (!function(&stream, &sample, NULL)) {
+            return false;
+        }
+        *length = CDR_Stream_GetCurrentPositionOffset(&stream);
+        return true;
+    }
+
+    // deserialize buffer into out and compare it with sample
+    bool round_trips(DeserializeFunction function)
+    {
+        CDR_Stream_Reset(&stream);
+        out.id = ~sample.id;
+        out_msg[0] = '\0';
+        return function(&stream, &out, NULL) && out.id == sample.id &&
+                std::strcmp(out.msg, sample.msg) == 0;
+    }
+};
+
+// where the template plugin first differs from the generated one for the
+// sample in state, or NULL
+const char *compare_template_plugin(PluginCheckState *state)
+{
+    RTI_UINT32 generated_length = 0;
+    RTI_UINT32 template_length = 0;
+    char generated[sizeof(state->buffer)];
+    if (!state->serialize(my_type_cdr_serialize, &generated_length)) {
+        return "generated serialize failed";
+    }
+    std::memcpy(generated, state->buffer, generated_length);
+    if (!state->round_trips(MyTypeTemplatePlugin::deserialize)) {
+        return "template deserialize of the generated bytes";
+    }
+    if (!state->serialize(MyTypeTemplatePlugin::serialize, &template_length)) {
+        return "template serialize failed";
+    }
+    if (template_length != generated_length ||
+            std::memcmp(generated, state->buffer, generated_length) != 0) {
+        return "serialized sample";
+    }
+    if (!state->round_trips(my_type_cdr_deserialize)) {
+        return "generated deserialize of the template bytes";
+    }
+
+    if (!state->serialize(my_type_cdr_serialize_key, &generated_length)) {
+        return "generated serialize_key failed";
+    }
+    std::memcpy(generated, state->buffer, generated_length);
+    if (!state->serialize(
+                MyTypeTemplatePlugin::serialize_key, &template_length) ||
+            template_length != generated_length ||
+            std::memcmp(generated, state->buffer, generated_length) != 0) {
+        return "serialized key";
+    }
+
+    DDS_KeyHash_t generated_hash;
+    DDS_KeyHash_t template_hash;
+    if (!key_hash(my_type_instance_to_keyhash, &state->stream,
+                &state->sample, state->sample.id, &generated_hash) ||
+            !key_hash(MyTypeTemplatePlugin::instance_to_keyhash,
+                    &state->stream, &state->sample, state->sample.id,
+                    &template_hash) ||
+            std::memcmp(generated_hash.value, template_hash.value,
+                    sizeof(generated_hash.value)) != 0) {
+        return "key hash";
+    }
+    return NULL;
+}
+
+// ns per serialize and deserialize of the sample in state
+void time_plugin(
+        PluginCheckState *state,
+        SerializeFunction serialize,
+        DeserializeFunction deserialize,
+        double *serialize_ns,
+        double *deserialize_ns)
+{
+    RTI_UINT32 length = 0;
+    auto start = monotonic_now_ns();
+    for (auto i = 0; i < k_timing_rounds; ++i) {
+        state->serialize(serialize, &length);
+    }
+    *serialize_ns = static_cast<double>(monotonic_now_ns() - start) /
+            k_timing_rounds;
+    start = monotonic_now_ns();
+    for (auto i = 0; i < k_timing_rounds; ++i) {
+        CDR_Stream_Reset(&state->stream);
+        deserialize(&state->stream, &state->out, NULL);
+    }
+    *deserialize_ns = static_cast<double>(monotonic_now_ns() - start) /
+            k_timing_rounds;
+    g_check_sink = static_cast<DDS_Octet>(state->out.id + length);
+}
+
+bool check_template_plugin(std::ostream &os)
+{
+    auto ids = check_ids();
+    PluginCheckState state;
+    auto samples = 0;
+    auto mismatches = 0;
+    for (std::size_t i = 0; i < ids.size(); ++i) {
+        // the edge ids at every msg length, the random ones at one each
+        std::size_t first = i < 5 ? 0 : i % (k_my_type_msg_max_length + 1);
+        std::size_t last = i < 5 ? k_my_type_msg_max_length : first;
+        for (auto length = first; length <= last; ++length) {
+            state.fill(ids[i], length);
+            ++samples;
+            auto difference = compare_template_plugin(&state);
+            if (difference != NULL && mismatches++ == 0) {
+                os << "ERROR: template plugin differs from the generated "
+                        << "one for id " << ids[i] << ", msg length "
+                        << length << ": " << difference << std::endl;
+            }
+        }
+    }
+    for (RTI_UINT32 alignment = 0; alignment < 8; ++alignment) {
+        if (MyTypeTemplatePlugin::get_serialized_sample_max_size(
+                    NULL, alignment, NULL) !=
+                        my_type_get_serialized_sample_max_size(
+                                NULL, alignment, NULL) ||
+                MyTypeTemplatePlugin::get_serialized_key_max_size(
+                        NULL, alignment, NULL) !=
+                        my_type_get_serialized_key_max_size(
+                                NULL, alignment, NULL)) {
+            if (mismatches++ == 0) {
+                os << "ERROR: template plugin max sizes differ at alignment "
+                        << alignment << std::endl;
+            }
+        }
+    }
+    os << "plugin check: template plugin, " << samples - mismatches
+            << " of " << samples << " samples identical to the generated "
+            << "plugin" << std::endl;
+
+    // a mid-sized msg, as a typical sample
+    state.fill(42, k_my_type_msg_max_length / 2);
+    double serialize_ns[2];
+    double deserialize_ns[2];
+    time_plugin(&state, my_type_cdr_serialize, my_type_cdr_deserialize,
+            &serialize_ns[0], &deserialize_ns[0]);
+    time_plugin(&state, MyTypeTemplatePlugin::serialize,
+            MyTypeTemplatePlugin::deserialize,
+            &serialize_ns[1], &deserialize_ns[1]);
+    os << "plugin check: serialize/deserialize of a "
+            << k_my_type_msg_max_length / 2 << "-character msg: generated "
+            << serialize_ns[0] << "/" << deserialize_ns[0] << " ns, template "
+            << serialize_ns[1] << "/" << deserialize_ns[1] << " ns"
+            << std::endl;
+    return mismatches == 0;
+}
+
+}  // namespace
+
+bool plugin_check(std::ostream &os)
+{
+    auto key_hash_ok = check_key_hash(os);
+    auto template_ok = check_template_plugin(os);
+    return key_hash_ok && template_ok;
+}
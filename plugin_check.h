@@ -0,0 +1,32 @@
+// (c) Copyright, Real-Time Innovations, 2021.  All rights reserved.
+// RTI grants Licensee a license to use, modify, compile, and create derivative
+// works of the software solely for use with RTI Connext DDS. Licensee may
+// redistribute copies of the software provided that all such copies are subject
+// to this license. The software is provided "as is", with no warranty of any
+// type, including any warranty for fitness for any purpose. RTI is under no
+// obligation to maintain or support the software. RTI shall not be liable for
+// any incidental or consequential damages arising out of the use or inability
+// to use the software.
+
+#ifndef PLUGIN_CHECK_H
+#define PLUGIN_CHECK_H
+
+#include <iostream>
+
+// Startup self-checks for type.plugin_check. The my_type plugin replaces
+// generic code with hand-written paths that must give the same bytes; this
+// compares each with the path it replaces and times both, so a regenerated
+// examplePlugin.c or a different Micro release that breaks the equivalence
+// fails loudly instead of putting different key hashes on the wire.
+//
+//     my_type_instance_to_keyhash against PluginHelper_instance_to_keyhash,
+//     for 0, 1, -1, INT_MIN, INT_MAX and pseudo-random ids
+//     MyTypeTemplatePlugin against the generated my_typeTypePlugin: the
+//     serialized sample and key byte for byte, what each deserializes
+//     from the other's bytes, the key hash and the maximum sizes, over
+//     the same ids with msg lengths from 0 to 128
+//
+// Prints one line per check and per timing; false if anything differed.
+bool plugin_check(std::ostream &os);
+
+#endif
@@ -0,0 +1,116 @@
+// (c) Copyright, Real-Time Innovations, 2021.  All rights reserved.
+// RTI grants Licensee a license to use, modify, compile, and create derivative
+// works of the software solely for use with RTI Connext DDS. Licensee may
+// redistribute copies of the software provided that all such copies are subject
+// to this license. The software is provided "as is", with no warranty of any
+// type, including any warranty for fitness for any purpose. RTI is under no
+// obligation to maintain or support the software. RTI shall not be liable for
+// any incidental or consequential damages arising out of the use or inability
+// to use the software.
+
+#ifndef READER_EVENT_H
+#define READER_EVENT_H
+
+#include <atomic>
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+
+#include <sys/eventfd.h>
+#include <unistd.h>
+
+#include "cyclic_scheduler.h"
+
+// Turns DataReader readiness into a file descriptor for an application's
+// epoll/poll loop. The listener's on_data_available calls notify() and
+// returns; the application thread waits for fd() to become readable, calls
+// consume() and then takes from the reader itself.
+//
+// Notifications are coalesced: only the first one after a consume()
+// writes to the eventfd, later ones just count, so a burst of samples
+// costs the listener one syscall and the application one wakeup. The
+// wakeup latency is the time from that first notify() to the consume().
+class ReaderReadyEvent {
+public:
+    ReaderReadyEvent()
+        : fd_(eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC)),
+          pending_(false),
+          first_notify_ns_(0)
+    {
+    }
+
+    ~ReaderReadyEvent()
+    {
+        if (fd_ >= 0) {
+            close(fd_);
+        }
+    }
+
+    ReaderReadyEvent(const ReaderReadyEvent &) = delete;
+    ReaderReadyEvent &operator=(const ReaderReadyEvent &) = delete;
+
+    bool is_valid() const { return fd_ >= 0; }
+    int fd() const { return fd_; }
+
+    // listener thread
+    void notify()
+    {
+        notifications_.fetch_add(1, std::memory_order_relaxed);
+        if (pending_.exchange(true, std::memory_order_acq_rel)) {
+            return;
+        }
+        first_notify_ns_.store(monotonic_now_ns(), std::memory_order_relaxed);
+        std::uint64_t one = 1;
+        if (write(fd_, &one, sizeof(one)) != sizeof(one)) {
+            errors_.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+
+    // Application thread, when fd() is readable. Clears the event before
+    // the caller drains the reader, so samples arriving during the drain
+    // signal again instead of being missed.
+    void consume()
+    {
+        std::uint64_t count;
+        if (read(fd_, &count, sizeof(count)) != sizeof(count) &&
+                errno != EAGAIN) {
+            errors_.fetch_add(1, std::memory_order_relaxed);
+        }
+        auto latency_ns = monotonic_now_ns() -
+                first_notify_ns_.load(std::memory_order_relaxed);
+        pending_.store(false, std::memory_order_release);
+
+        ++wakeups_;
+        total_latency_ns_ += latency_ns;
+        if (latency_ns > max_latency_ns_) {
+            max_latency_ns_ = latency_ns;
+        }
+    }
+
+    void print_stats(std::ostream &os) const
+    {
+        os << "event loop: notifications = "
+                << notifications_.load(std::memory_order_relaxed)
+                << ", wakeups = " << wakeups_
+                << ", avg wakeup latency = "
+                << (wakeups_ ? total_latency_ns_ / 1000.0 / wakeups_ : 0.0)
+                << " us, max wakeup latency = " << max_latency_ns_ / 1000.0
+                << " us, errors = " << errors_.load(std::memory_order_relaxed)
+                << std::endl;
+    }
+
+private:
+    const int fd_;
+    std::atomic<bool> pending_;
+    std::atomic<std::int64_t> first_notify_ns_;
+    std::atomic<std::uint64_t> notifications_{0};
+    std::atomic<std::uint64_t> errors_{0};
+
+    // application thread only
+    std::uint64_t wakeups_ = 0;
+    std::int64_t total_latency_ns_ = 0;
+    std::int64_t max_latency_ns_ = 0;
+};
+
+#endif
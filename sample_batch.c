@@ -0,0 +1,103 @@
+// (c) Copyright, Real-Time Innovations, 2021.  All rights reserved.
+// RTI grants Licensee a license to use, modify, compile, and create derivative
+// works of the software solely for use with RTI Connext DDS. Licensee may
+// redistribute copies of the software provided that all such copies are subject
+// to this license. The software is provided "as is", with no warranty of any
+// type, including any warranty for fitness for any purpose. RTI is under no
+// obligation to maintain or support the software. RTI shall not be liable for
+// any incidental or consequential damages arising out of the use or inability
+// to use the software.
+
+#include "sample_batch.h"
+
+const char *my_type_batchTYPENAME = "my_type_batch";
+
+RTI_BOOL
+my_type_batch_initialize(my_type_batch *sample)
+{
+    if (sample == NULL) {
+        return RTI_FALSE;
+    }
+    CDR_Primitive_init_unsigned_long(&sample->count);
+    CDR_Primitive_init_unsigned_long(&sample->span_us);
+    if (!DDS_OctetSeq_initialize(&sample->records) ||
+            !DDS_OctetSeq_set_maximum(
+                    &sample->records,
+                    MY_TYPE_BATCH_MAX_BYTES)) {
+        return RTI_FALSE;
+    }
+    return RTI_TRUE;
+}
+
+my_type_batch *
+my_type_batch_create(void)
+{
+    my_type_batch *sample;
+
+    OSAPI_Heap_allocate_struct(&sample, my_type_batch);
+    if (sample != NULL && !my_type_batch_initialize(sample)) {
+        OSAPI_Heap_free_struct(sample);
+        sample = NULL;
+    }
+    return sample;
+}
+
+#ifndef RTI_CERT
+RTI_BOOL
+my_type_batch_finalize(my_type_batch *sample)
+{
+    if (sample == NULL) {
+        return RTI_FALSE;
+    }
+    return DDS_OctetSeq_finalize(&sample->records);
+}
+
+void
+my_type_batch_delete(my_type_batch *sample)
+{
+    if (sample != NULL) {
+        my_type_batch_finalize(sample);
+        OSAPI_Heap_free_struct(sample);
+    }
+}
+#endif
+
+RTI_BOOL
+my_type_batch_copy(my_type_batch *dst, const my_type_batch *src)
+{
+    if (dst == NULL || src == NULL) {
+        return RTI_FALSE;
+    }
+    CDR_Primitive_copy_unsigned_long(&dst->count, &src->count);
+    CDR_Primitive_copy_unsigned_long(&dst->span_us, &src->span_us);
+    return DDS_OctetSeq_copy(&dst->records, &src->records);
+}
+
+// the sequence of batches a DataReader loans out
+#define REDA_SEQUENCE_USER_API
+#define T my_type_batch
+#define TSeq my_type_batchSeq
+#define T_initialize my_type_batch_initialize
+#define T_finalize   my_type_batch_finalize
+#define T_copy       my_type_batch_copy
+#include "reda/reda_sequence_defn.h"
+#undef T_copy
+#undef T_finalize
+#undef T_initialize
+
+// the typed DataWriter and DataReader
+#define TTYPENAME   my_type_batchTYPENAME
+
+#define TDataWriter my_type_batchDataWriter
+#define TData       my_type_batch
+#include "dds_c/dds_c_tdatawriter_gen.h"
+#undef TDataWriter
+#undef TData
+
+#define TDataReader my_type_batchDataReader
+#define TDataSeq    my_type_batchSeq
+#define TData       my_type_batch
+#include "dds_c/dds_c_tdatareader_gen.h"
+#undef TDataReader
+#undef TDataSeq
+#undef TData
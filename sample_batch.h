@@ -0,0 +1,80 @@
+// (c) Copyright, Real-Time Innovations, 2021.  All rights reserved.
+// RTI grants Licensee a license to use, modify, compile, and create derivative
+// works of the software solely for use with RTI Connext DDS. Licensee may
+// redistribute copies of the software provided that all such copies are subject
+// to this license. The software is provided "as is", with no warranty of any
+// type, including any warranty for fitness for any purpose. RTI is under no
+// obligation to maintain or support the software. RTI shall not be liable for
+// any incidental or consequential damages arising out of the use or inability
+// to use the software.
+
+#ifndef SAMPLE_BATCH_H
+#define SAMPLE_BATCH_H
+
+#include "rti_me_c.h"
+
+// The container type for application-level batching (batch_accumulator.h),
+// laid out the way rtiddsgen would generate it from
+//
+//     const string my_topic_batch_name = "my_topic_batch";
+//     const long MY_TYPE_BATCH_MAX_BYTES = 8192;
+//     struct my_type_batch {
+//         unsigned long count;     // records packed in records
+//         unsigned long span_us;   // first record added to batch written
+//         sequence<octet, MY_TYPE_BATCH_MAX_BYTES> records;
+//     };
+//
+// The sample functions, the sequence and the typed DataWriter/DataReader
+// are in sample_batch.c; the type plugin is described in
+// sample_batch_plugin.h.
+
+#define my_topic_batch_name ("my_topic_batch")
+#define MY_TYPE_BATCH_MAX_BYTES (8192)
+
+typedef struct my_type_batch
+{
+    CDR_UnsignedLong count;
+    CDR_UnsignedLong span_us;
+    struct DDS_OctetSeq records;
+} my_type_batch;
+
+#define REDA_SEQUENCE_USER_API
+#define T my_type_batch
+#define TSeq my_type_batchSeq
+#define REDA_SEQUENCE_EXCLUDE_C_METHODS
+#define REDA_SEQUENCE_USER_CPP
+#include <reda/reda_sequence_decl.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define REDA_SEQUENCE_USER_API
+#define T my_type_batch
+#define TSeq my_type_batchSeq
+#define REDA_SEQUENCE_EXCLUDE_STRUCT
+#define REDA_SEQUENCE_USER_CPP
+#include <reda/reda_sequence_decl.h>
+
+extern const char *my_type_batchTYPENAME;
+
+// the records sequence gets its full maximum, so a received batch never
+// allocates
+RTI_BOOL my_type_batch_initialize(my_type_batch *sample);
+my_type_batch *my_type_batch_create(void);
+RTI_BOOL my_type_batch_copy(my_type_batch *dst, const my_type_batch *src);
+
+// Connext Micro Cert has no delete APIs, so neither does the batch
+#ifndef RTI_CERT
+RTI_BOOL my_type_batch_finalize(my_type_batch *sample);
+void my_type_batch_delete(my_type_batch *sample);
+#endif
+
+DDS_DATAWRITER_C(my_type_batchDataWriter, my_type_batch);
+DDS_DATAREADER_C(my_type_batchDataReader, my_type_batchSeq, my_type_batch);
+
+#ifdef __cplusplus
+} /* extern "C" */
+#endif
+
+#endif
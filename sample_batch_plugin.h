@@ -0,0 +1,43 @@
+// (c) Copyright, Real-Time Innovations, 2021.  All rights reserved.
+// RTI grants Licensee a license to use, modify, compile, and create derivative
+// works of the software solely for use with RTI Connext DDS. Licensee may
+// redistribute copies of the software provided that all such copies are subject
+// to this license. The software is provided "as is", with no warranty of any
+// type, including any warranty for fitness for any purpose. RTI is under no
+// obligation to maintain or support the software. RTI shall not be liable for
+// any incidental or consequential damages arising out of the use or inability
+// to use the software.
+
+#ifndef SAMPLE_BATCH_PLUGIN_H
+#define SAMPLE_BATCH_PLUGIN_H
+
+#include "type_plugin.h"
+#include "sample_batch.h"
+
+// my_type_batch (sample_batch.h), described for type_plugin.h. There is no
+// generated plugin for it, so this is the one it is registered with.
+struct MyTypeBatchDescription {
+    typedef my_type_batch Struct;
+    typedef type_plugin::Fields<
+            type_plugin::UnsignedLongField<
+                    my_type_batch, &my_type_batch::count>,
+            type_plugin::UnsignedLongField<
+                    my_type_batch, &my_type_batch::span_us>,
+            type_plugin::OctetSeqField<
+                    my_type_batch,
+                    &my_type_batch::records,
+                    MY_TYPE_BATCH_MAX_BYTES>>
+        Members;
+};
+
+typedef type_plugin::TypePlugin<MyTypeBatchDescription> MyTypeBatchPlugin;
+
+static_assert(
+        !MyTypeBatchPlugin::has_key,
+        "a batch carries many ids, so the batch topic is keyless");
+static_assert(
+        MyTypeBatchPlugin::max_serialized_size()
+                == 4 + 4 + 4 + MY_TYPE_BATCH_MAX_BYTES,
+        "count, span, then the sequence length and its bytes");
+
+#endif
@@ -0,0 +1,165 @@
+// (c) Copyright, Real-Time Innovations, 2021.  All rights reserved.
+// RTI grants Licensee a license to use, modify, compile, and create derivative
+// works of the software solely for use with RTI Connext DDS. Licensee may
+// redistribute copies of the software provided that all such copies are subject
+// to this license. The software is provided "as is", with no warranty of any
+// type, including any warranty for fitness for any purpose. RTI is under no
+// obligation to maintain or support the software. RTI shall not be liable for
+// any incidental or consequential damages arising out of the use or inability
+// to use the software.
+
+#include "sample_snapshot.h"
+
+#include <atomic>
+#include <unistd.h>
+
+#include "latency_stats.h"
+
+namespace {
+
+const char k_snapshot_magic[8] = { 'M', 'Y', 'T', 'Y', 'P', 'S', 'N', 'P' };
+const std::uint32_t k_snapshot_version = 1;
+
+static_assert(sizeof(SnapshotHeader) == 64, "SnapshotHeader layout");
+
+std::uint32_t round_up_pow2(std::size_t n)
+{
+    std::uint32_t pow2 = 1;
+    while (pow2 < n) {
+        pow2 <<= 1;
+    }
+    return pow2;
+}
+
+std::size_t file_size(std::uint32_t slot_count)
+{
+    return sizeof(SnapshotHeader) + slot_count * sizeof(SnapshotSlot);
+}
+
+// an existing snapshot that matches this build and capacity
+bool matches(const MappedFile &file, std::uint32_t slot_count)
+{
+    auto header = reinterpret_cast<const SnapshotHeader *>(file.data());
+    return file.size() == file_size(slot_count) &&
+            std::memcmp(header->magic, k_snapshot_magic,
+                    sizeof(header->magic)) == 0 &&
+            header->version == k_snapshot_version &&
+            header->slot_count == slot_count &&
+            header->slot_size == sizeof(SnapshotSlot);
+}
+
+} // namespace
+
+SampleSnapshot::SampleSnapshot()
+    : slots_(NULL),
+      slot_count_(0),
+      loaded_(0),
+      torn_(0),
+      updates_(0),
+      overflows_(0)
+{
+}
+
+bool SampleSnapshot::open(
+        const std::string &path,
+        std::size_t capacity,
+        std::ostream &errors)
+{
+    auto slot_count = round_up_pow2(capacity);
+    if (access(path.c_str(), F_OK) == 0) {
+        if (file_.open_read_write(path) && matches(file_, slot_count)) {
+            slots_ = reinterpret_cast<SnapshotSlot *>(
+                    file_.data() + sizeof(SnapshotHeader));
+            slot_count_ = slot_count;
+            for (std::uint32_t i = 0; i < slot_count_; ++i) {
+                auto sequence = slots_[i].sequence;
+                if (sequence != 0 && (sequence & 1) == 0) {
+                    ++loaded_;
+                } else if ((sequence & 1) != 0) {
+                    ++torn_;
+                }
+            }
+            return true;
+        }
+        file_.unmap(0);
+        errors << "WARNING: " << path << " is not a snapshot for "
+                << slot_count << " slots, starting a new one" << std::endl;
+    }
+
+    // a new file is all zero: every slot unused
+    if (!file_.create(path, file_size(slot_count))) {
+        errors << "ERROR: failed to create snapshot " << path << std::endl;
+        return false;
+    }
+    auto header = reinterpret_cast<SnapshotHeader *>(file_.data());
+    std::memcpy(header->magic, k_snapshot_magic, sizeof(header->magic));
+    header->version = k_snapshot_version;
+    header->slot_count = slot_count;
+    header->slot_size = sizeof(SnapshotSlot);
+    slots_ = reinterpret_cast<SnapshotSlot *>(
+            file_.data() + sizeof(SnapshotHeader));
+    slot_count_ = slot_count;
+    return true;
+}
+
+void SampleSnapshot::close()
+{
+    file_.unmap(0);
+    slots_ = NULL;
+    slot_count_ = 0;
+}
+
+SnapshotSlot *SampleSnapshot::find_or_insert(DDS_Long id)
+{
+    auto mask = slot_count_ - 1;
+    // Fibonacci hashing spreads sequential ids across the table
+    for (std::uint32_t probe = 0, i = ((std::uint32_t)id * 2654435769u) & mask;
+            probe < slot_count_;
+            ++probe, i = (i + 1) & mask) {
+        auto &slot = slots_[i];
+        if (slot.sequence == 0) {
+            slot.id = id;
+            return &slot;
+        }
+        if (slot.id == id) {
+            return &slot;
+        }
+    }
+    return NULL;
+}
+
+bool SampleSnapshot::update(const my_type &sample)
+{
+    if (!is_open()) {
+        return false;
+    }
+    auto slot = find_or_insert(sample.id);
+    if (slot == NULL) {
+        ++overflows_;
+        return false;
+    }
+    // odd while the slot is inconsistent (a slot a crash left odd stays
+    // odd until this write completes). The stores reach the shared pages
+    // in program order, so only the compiler has to be kept from moving
+    // them; nothing reads the file while this process has it.
+    auto sequence = slot->sequence | 1;
+    slot->sequence = sequence;
+    std::atomic_signal_fence(std::memory_order_seq_cst);
+    slot->written_ns = realtime_now_ns();
+    std::strncpy(slot->msg, sample.msg, k_my_type_msg_max_length);
+    slot->msg[k_my_type_msg_max_length] = '\0';
+    std::atomic_signal_fence(std::memory_order_seq_cst);
+    slot->sequence = sequence + 1;
+    ++updates_;
+    return true;
+}
+
+void SampleSnapshot::print_stats(std::ostream &os) const
+{
+    if (!is_open()) {
+        return;
+    }
+    os << "snapshot: " << slot_count_ << " slots, loaded = " << loaded_
+            << ", torn = " << torn_ << ", updates = " << updates_
+            << ", overflows = " << overflows_ << std::endl;
+}
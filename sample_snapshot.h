@@ -0,0 +1,115 @@
+// (c) Copyright, Real-Time Innovations, 2021.  All rights reserved.
+// RTI grants Licensee a license to use, modify, compile, and create derivative
+// works of the software solely for use with RTI Connext DDS. Licensee may
+// redistribute copies of the software provided that all such copies are subject
+// to this license. The software is provided "as is", with no warranty of any
+// type, including any warranty for fitness for any purpose. RTI is under no
+// obligation to maintain or support the software. RTI shall not be liable for
+// any incidental or consequential damages arising out of the use or inability
+// to use the software.
+
+#ifndef SAMPLE_SNAPSHOT_H
+#define SAMPLE_SNAPSHOT_H
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <string>
+
+#include "rti_me_c.h"
+#include "example.h"
+
+#include "common_config.h"
+#include "cdr_recording.h"
+
+// The latest sample the publisher wrote for each id, kept in a memory-mapped
+// file so a restarted publisher can put its last state back on the wire
+// before it writes anything new. The file is an open-addressed table sized
+// once (like LatestValueCache); update() rewrites one slot in place, so the
+// file is kept current a slot at a time, with no system call. The mapping
+// is shared, so a crashed process loses nothing; the kernel writes the
+// dirty pages back, and close() flushes them.
+//
+// Each slot carries a sequence that is odd while the slot is being
+// written. A slot left odd by a crash is skipped when the file is loaded.
+//
+// File layout:
+//     SnapshotHeader
+//     SnapshotSlot[slot_count]
+
+struct SnapshotHeader {
+    char magic[8];
+    std::uint32_t version;
+    std::uint32_t slot_count;           // a power of two
+    std::uint32_t slot_size;
+    std::uint8_t reserved[44];
+};
+
+struct SnapshotSlot {
+    // 0: never used; odd: being written; even: holds a sample
+    std::uint32_t sequence;
+    std::int32_t id;
+    std::int64_t written_ns;            // realtime clock
+    char msg[k_my_type_msg_max_length + 1];
+};
+
+// Used from the publisher's writing thread only
+class SampleSnapshot {
+public:
+    SampleSnapshot();
+    ~SampleSnapshot() { close(); }
+    SampleSnapshot(const SampleSnapshot &) = delete;
+    SampleSnapshot &operator=(const SampleSnapshot &) = delete;
+
+    // Map path, creating it if it is missing or was made for another
+    // capacity (rounded up to a power of two). The samples already in it
+    // are kept for for_each().
+    bool open(
+            const std::string &path,
+            std::size_t capacity,
+            std::ostream &errors);
+    void close();
+
+    bool is_open() const { return file_.is_open(); }
+    // samples found in the file when it was opened
+    std::size_t loaded() const { return loaded_; }
+
+    // store sample as the latest value of its id
+    bool update(const my_type &sample);
+
+    // call f(const my_type &) for every complete slot, in table order
+    template <typename F>
+    void for_each(F f) const
+    {
+        my_type sample;
+        char msg[k_my_type_msg_max_length + 1];
+        sample.msg = msg;
+        for (std::uint32_t i = 0; i < slot_count_; ++i) {
+            const auto &slot = slots_[i];
+            if (slot.sequence == 0 || (slot.sequence & 1) != 0) {
+                continue;
+            }
+            sample.id = slot.id;
+            std::memcpy(msg, slot.msg, sizeof(msg));
+            msg[k_my_type_msg_max_length] = '\0';
+            f(static_cast<const my_type &>(sample));
+        }
+    }
+
+    void print_stats(std::ostream &os) const;
+
+private:
+    SnapshotSlot *find_or_insert(DDS_Long id);
+
+    MappedFile file_;
+    SnapshotSlot *slots_;
+    std::uint32_t slot_count_;
+    std::size_t loaded_;
+    std::size_t torn_;
+
+    std::uint64_t updates_;
+    std::uint64_t overflows_;
+};
+
+#endif
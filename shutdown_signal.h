@@ -0,0 +1,51 @@
+// (c) Copyright, Real-Time Innovations, 2021.  All rights reserved.
+// RTI grants Licensee a license to use, modify, compile, and create derivative
+// works of the software solely for use with RTI Connext DDS. Licensee may
+// redistribute copies of the software provided that all such copies are subject
+// to this license. The software is provided "as is", with no warranty of any
+// type, including any warranty for fitness for any purpose. RTI is under no
+// obligation to maintain or support the software. RTI shall not be liable for
+// any incidental or consequential damages arising out of the use or inability
+// to use the software.
+
+#ifndef SHUTDOWN_SIGNAL_H
+#define SHUTDOWN_SIGNAL_H
+
+#include <atomic>
+#include <csignal>
+
+// Ctrl-C (SIGINT) and SIGTERM end the applications' main loops instead of
+// killing the process, so files being written (recordings, traces, reports)
+// can be closed properly on the way out.
+inline std::atomic<bool> &shutdown_flag()
+{
+    static std::atomic<bool> flag(false);
+    return flag;
+}
+
+extern "C" inline void shutdown_signal_handler(int signal_number)
+{
+    (void)(signal_number);  // to suppress -Wunused-parameter warning
+    shutdown_flag().store(true, std::memory_order_relaxed);
+}
+
+inline void install_shutdown_handler()
+{
+    // create the flag before a signal can arrive
+    shutdown_flag();
+    std::signal(SIGINT, shutdown_signal_handler);
+    std::signal(SIGTERM, shutdown_signal_handler);
+}
+
+// end the main loops as Ctrl-C would, e.g. when a timed run is over
+inline void request_shutdown()
+{
+    shutdown_flag().store(true, std::memory_order_relaxed);
+}
+
+inline bool shutdown_requested()
+{
+    return shutdown_flag().load(std::memory_order_relaxed);
+}
+
+#endif
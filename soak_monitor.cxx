@@ -0,0 +1,252 @@
+// (c) Copyright, Real-Time Innovations, 2021.  All rights reserved.
+// RTI grants Licensee a license to use, modify, compile, and create derivative
+// works of the software solely for use with RTI Connext DDS. Licensee may
+// redistribute copies of the software provided that all such copies are subject
+// to this license. The software is provided "as is", with no warranty of any
+// type, including any warranty for fitness for any purpose. RTI is under no
+// obligation to maintain or support the software. RTI shall not be liable for
+// any incidental or consequential damages arising out of the use or inability
+// to use the software.
+
+#include "soak_monitor.h"
+
+#include <cstdio>
+#include <dirent.h>
+#include <string>
+#include <unistd.h>
+
+#include "cyclic_scheduler.h"
+
+namespace {
+
+// with no soak.duration_s, keep a week of samples
+const std::int64_t k_unbounded_soak_s = 7 * 24 * 3600;
+
+// resident set size now, from /proc/self/statm (in pages)
+double current_rss_kb()
+{
+    auto statm = std::fopen("/proc/self/statm", "r");
+    if (statm == NULL) {
+        return 0;
+    }
+    unsigned long size = 0;
+    unsigned long resident = 0;
+    auto fields = std::fscanf(statm, "%lu %lu", &size, &resident);
+    std::fclose(statm);
+    if (fields != 2) {
+        return 0;
+    }
+    return resident * (sysconf(_SC_PAGESIZE) / 1024.0);
+}
+
+double open_fd_count()
+{
+    auto dir = opendir("/proc/self/fd");
+    if (dir == NULL) {
+        return 0;
+    }
+    auto count = 0;
+    while (auto entry = readdir(dir)) {
+        if (entry->d_name[0] != '.') {
+            ++count;
+        }
+    }
+    closedir(dir);
+    // not counting the descriptor used to read the directory
+    return count - 1;
+}
+
+// latency recorded between two cumulative snapshots
+LatencyStats::Snapshot difference(
+        const LatencyStats::Snapshot &now,
+        const LatencyStats::Snapshot &before)
+{
+    LatencyStats::Snapshot period = now;
+    period.count -= before.count;
+    period.total_ns -= before.total_ns;
+    for (auto i = 0; i < LatencyStats::k_fine_buckets; ++i) {
+        period.fine_histogram[i] -= before.fine_histogram[i];
+    }
+    LatencyStats::sum_histogram(&period);
+    return period;
+}
+
+// Least-squares slope per hour and mean of one series over time
+struct Trend {
+    double per_hour;
+    double mean;
+
+    // relative change per hour, 0 for a series that is all zero
+    double percent_per_hour() const
+    {
+        return mean != 0 ? 100 * per_hour / mean : 0;
+    }
+};
+
+template <typename Sample, typename Field>
+Trend fit(const std::vector<Sample> &samples, std::size_t first, Field field)
+{
+    double n = 0;
+    double sum_t = 0;
+    double sum_y = 0;
+    double sum_tt = 0;
+    double sum_ty = 0;
+    for (auto i = first; i < samples.size(); ++i) {
+        auto t = samples[i].elapsed_s / 3600;
+        auto y = field(samples[i]);
+        n += 1;
+        sum_t += t;
+        sum_y += y;
+        sum_tt += t * t;
+        sum_ty += t * y;
+    }
+    Trend trend;
+    auto denominator = n * sum_tt - sum_t * sum_t;
+    trend.per_hour = denominator != 0
+            ? (n * sum_ty - sum_t * sum_y) / denominator : 0;
+    trend.mean = n > 0 ? sum_y / n : 0;
+    return trend;
+}
+
+}  // namespace
+
+SoakMonitor::SoakMonitor(const AppConfig &config, Collector collect)
+    : enabled_(config.soak_enabled),
+      period_ns_(static_cast<std::int64_t>(config.soak_sample_period_s) *
+              1000000000),
+      duration_ns_(static_cast<std::int64_t>(config.soak_duration_s) *
+              1000000000),
+      warmup_s_(config.soak_warmup_s),
+      max_rss_growth_kb_per_hour_(config.soak_max_rss_growth_kb_per_hour),
+      max_fd_growth_per_hour_(config.soak_max_fd_growth_per_hour),
+      max_latency_growth_pct_per_hour_(
+              config.soak_max_latency_growth_pct_per_hour),
+      max_throughput_decay_pct_per_hour_(
+              config.soak_max_throughput_decay_pct_per_hour),
+      collect_(collect),
+      start_ns_(monotonic_now_ns()),
+      next_sample_ns_(start_ns_ + period_ns_),
+      finished_(false)
+{
+    if (!enabled_) {
+        return;
+    }
+    auto soak_s = config.soak_duration_s > 0
+            ? config.soak_duration_s : k_unbounded_soak_s;
+    samples_.reserve(soak_s / config.soak_sample_period_s + 2);
+    collect_(&previous_);
+}
+
+bool SoakMonitor::poll()
+{
+    if (!enabled_) {
+        return false;
+    }
+    auto now_ns = monotonic_now_ns();
+    if (now_ns >= next_sample_ns_) {
+        take_sample(now_ns);
+        next_sample_ns_ += period_ns_;
+        // a stalled loop samples once, not once per missed period
+        if (next_sample_ns_ <= now_ns) {
+            next_sample_ns_ = now_ns + period_ns_;
+        }
+    }
+    if (duration_ns_ > 0 && now_ns - start_ns_ >= duration_ns_) {
+        finished_ = true;
+    }
+    return finished_;
+}
+
+void SoakMonitor::take_sample(std::int64_t now_ns)
+{
+    SoakCounters counters;
+    collect_(&counters);
+    auto period_s = samples_.empty()
+            ? (now_ns - start_ns_) / 1e9
+            : (now_ns - start_ns_) / 1e9 - samples_.back().elapsed_s;
+
+    Sample sample;
+    sample.elapsed_s = (now_ns - start_ns_) / 1e9;
+    sample.rss_kb = current_rss_kb();
+    sample.open_fds = open_fd_count();
+    sample.samples_per_s = period_s > 0
+            ? (counters.samples - previous_.samples) / period_s : 0;
+    auto latency = difference(counters.latency, previous_.latency);
+    sample.latency_p99_us = latency.count > 0
+            ? latency.fine_percentile_us(0.99) : 0;
+    sample.protocol_events_per_s = period_s > 0
+            ? (counters.protocol_events - previous_.protocol_events) /
+                    period_s
+            : 0;
+    previous_ = counters;
+    // past the reserved capacity the samples are only printed
+    if (samples_.size() < samples_.capacity()) {
+        samples_.push_back(sample);
+    }
+
+    std::cout << "soak @ " << static_cast<long>(sample.elapsed_s) / 60
+            << " min: rss = " << sample.rss_kb << " kB, fds = "
+            << sample.open_fds << ", samples/s = " << sample.samples_per_s
+            << ", latency p99 = " << sample.latency_p99_us
+            << " us, protocol events/s = " << sample.protocol_events_per_s
+            << std::endl;
+}
+
+bool SoakMonitor::print_summary(std::ostream &os) const
+{
+    if (!enabled_) {
+        return true;
+    }
+    std::size_t first = 0;
+    while (first < samples_.size() && samples_[first].elapsed_s < warmup_s_) {
+        ++first;
+    }
+    if (samples_.size() - first < 3) {
+        os << "soak verdict: not enough samples after the "
+                << warmup_s_ << " s warmup (" << samples_.size() - first
+                << ")" << std::endl;
+        return true;
+    }
+
+    auto rss = fit(samples_, first,
+            [](const Sample &s) { return s.rss_kb; });
+    auto fds = fit(samples_, first,
+            [](const Sample &s) { return s.open_fds; });
+    auto latency = fit(samples_, first,
+            [](const Sample &s) { return s.latency_p99_us; });
+    auto throughput = fit(samples_, first,
+            [](const Sample &s) { return s.samples_per_s; });
+    auto protocol = fit(samples_, first,
+            [](const Sample &s) { return s.protocol_events_per_s; });
+    os << "soak trend (" << samples_.size() - first << " samples over "
+            << (samples_.back().elapsed_s - samples_[first].elapsed_s) / 3600
+            << " h): rss = " << rss.per_hour << " kB/h, fds = "
+            << fds.per_hour << " /h, latency p99 = "
+            << latency.percent_per_hour() << " %/h, samples/s = "
+            << throughput.percent_per_hour()
+            << " %/h, protocol events/s = " << protocol.per_hour << " /h"
+            << std::endl;
+
+    std::string drift;
+    auto flag = [&drift](const char *what) {
+        drift += drift.empty() ? what : std::string(", ") + what;
+    };
+    if (rss.per_hour > max_rss_growth_kb_per_hour_) {
+        flag("memory leak");
+    }
+    if (fds.per_hour > max_fd_growth_per_hour_) {
+        flag("file descriptor leak");
+    }
+    if (latency.percent_per_hour() > max_latency_growth_pct_per_hour_) {
+        flag("latency creep");
+    }
+    if (-throughput.percent_per_hour() > max_throughput_decay_pct_per_hour_) {
+        flag("throughput decay");
+    }
+    if (drift.empty()) {
+        os << "soak verdict: flat" << std::endl;
+        return true;
+    }
+    os << "soak verdict: drift (" << drift << ")" << std::endl;
+    return false;
+}
@@ -0,0 +1,92 @@
+// (c) Copyright, Real-Time Innovations, 2021.  All rights reserved.
+// RTI grants Licensee a license to use, modify, compile, and create derivative
+// works of the software solely for use with RTI Connext DDS. Licensee may
+// redistribute copies of the software provided that all such copies are subject
+// to this license. The software is provided "as is", with no warranty of any
+// type, including any warranty for fitness for any purpose. RTI is under no
+// obligation to maintain or support the software. RTI shall not be liable for
+// any incidental or consequential damages arising out of the use or inability
+// to use the software.
+
+#ifndef SOAK_MONITOR_H
+#define SOAK_MONITOR_H
+
+#include <cstdint>
+#include <functional>
+#include <iostream>
+#include <vector>
+
+#include "app_config.h"
+#include "latency_stats.h"
+
+// Endurance (soak) runs: once per soak.sample_period_s the monitor records
+// the process's resident set size and open file descriptors together with
+// the application's throughput, latency p99 and reliable-protocol counter
+// over the last period, and prints them as a "soak @" line. The p99 comes
+// from the log-linear histogram, interpolated, so the fitted trend follows
+// the latency rather than steps between powers of two. At the end it
+// fits a least-squares line to each series (after soak.warmup_s, which
+// covers discovery and the first allocations) and flags
+//     a leak          RSS or open FDs growing faster than allowed per hour
+//     latency creep   p99 growing by more than a percentage per hour
+//     throughput decay
+// so a long run either ends with "soak verdict: flat" or names what drifted.
+//
+// poll() is called from the application's own loop; it costs a clock read
+// except once per period. Storage for every sample is reserved up front.
+
+// what the application counts, cumulatively; read by poll() on the
+// application's thread
+struct SoakCounters {
+    std::uint64_t samples = 0;
+    // e.g. writes that found the writer full, or samples lost and rejected
+    std::uint64_t protocol_events = 0;
+    // cumulative latency; the period's p99 comes from the difference
+    LatencyStats::Snapshot latency = LatencyStats::Snapshot();
+};
+
+class SoakMonitor {
+public:
+    typedef std::function<void(SoakCounters *)> Collector;
+
+    SoakMonitor(const AppConfig &config, Collector collect);
+
+    bool enabled() const { return enabled_; }
+
+    // Record a sample if a period has passed. Returns true once
+    // soak.duration_s is over (never if it is 0).
+    bool poll();
+
+    // the fitted trends and the verdict; false if anything drifted
+    bool print_summary(std::ostream &os) const;
+
+private:
+    struct Sample {
+        double elapsed_s;
+        double rss_kb;
+        double open_fds;
+        double samples_per_s;
+        double latency_p99_us;
+        double protocol_events_per_s;
+    };
+
+    void take_sample(std::int64_t now_ns);
+
+    const bool enabled_;
+    const std::int64_t period_ns_;
+    const std::int64_t duration_ns_;
+    const double warmup_s_;
+    const double max_rss_growth_kb_per_hour_;
+    const double max_fd_growth_per_hour_;
+    const double max_latency_growth_pct_per_hour_;
+    const double max_throughput_decay_pct_per_hour_;
+    Collector collect_;
+
+    std::int64_t start_ns_;
+    std::int64_t next_sample_ns_;
+    SoakCounters previous_;
+    std::vector<Sample> samples_;
+    bool finished_;
+};
+
+#endif
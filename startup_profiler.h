@@ -0,0 +1,153 @@
+// (c) Copyright, Real-Time Innovations, 2021.  All rights reserved.
+// RTI grants Licensee a license to use, modify, compile, and create derivative
+// works of the software solely for use with RTI Connext DDS. Licensee may
+// redistribute copies of the software provided that all such copies are subject
+// to this license. The software is provided "as is", with no warranty of any
+// type, including any warranty for fitness for any purpose. RTI is under no
+// obligation to maintain or support the software. RTI shall not be liable for
+// any incidental or consequential damages arising out of the use or inability
+// to use the software.
+
+#ifndef STARTUP_PROFILER_H
+#define STARTUP_PROFILER_H
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <iomanip>
+#include <iostream>
+
+// Times each step of the bring-up sequence in main(), and the events that
+// follow DDS_Entity_enable() (discovery, first match, first sample
+// written/received).
+// Phases are recorded by the main thread only; events may be recorded from
+// listener threads and are stored as atomics.
+class StartupProfiler {
+public:
+    static const int k_max_phases = 24;
+
+    enum Event {
+        EVENT_PARTICIPANT_DISCOVERED = 0,
+        EVENT_FIRST_MATCH,
+        EVENT_WRITER_ALIVE,
+        EVENT_FIRST_SAMPLE,
+        EVENT_SNAPSHOT_REPUBLISHED,
+        EVENT_COUNT
+    };
+
+    StartupProfiler()
+        : start_(clock::now()),
+          last_(start_),
+          phase_count_(0),
+          enable_ns_(0)
+    {
+        for (auto &event : event_ns_) {
+            event.store(0, std::memory_order_relaxed);
+        }
+    }
+
+    // close the current phase; name must be a string literal
+    void mark(const char *name)
+    {
+        auto now = clock::now();
+        if (phase_count_ < k_max_phases) {
+            phases_[phase_count_].name = name;
+            phases_[phase_count_].ns = to_ns(now - last_);
+            ++phase_count_;
+        }
+        last_ = now;
+    }
+
+    // close the enable phase and start the clock for the post-enable events
+    void mark_enabled()
+    {
+        mark("enable");
+        enable_ns_ = to_ns(last_ - start_);
+    }
+
+    // record the first occurrence of an event; later calls are ignored.
+    // Returns true for the call that recorded it.
+    bool record_once(Event event)
+    {
+        std::int64_t expected = 0;
+        auto now = to_ns(clock::now() - start_);
+        return event_ns_[event].compare_exchange_strong(
+                expected,
+                now,
+                std::memory_order_relaxed);
+    }
+
+    bool has(Event event) const
+    {
+        return event_ns_[event].load(std::memory_order_relaxed) != 0;
+    }
+
+    // milliseconds between DDS_Entity_enable() returning and the event
+    double ms_after_enable(Event event) const
+    {
+        auto ns = event_ns_[event].load(std::memory_order_relaxed);
+        return ns ? (ns - enable_ns_) / 1e6 : -1.0;
+    }
+
+    // milliseconds between the profiler's construction and the event
+    double ms_after_start(Event event) const
+    {
+        auto ns = event_ns_[event].load(std::memory_order_relaxed);
+        return ns ? ns / 1e6 : -1.0;
+    }
+
+    void print_phases(std::ostream &os) const
+    {
+        auto flags = os.flags();
+        auto precision = os.precision();
+        os << "startup phases:" << std::endl;
+        std::int64_t total = 0;
+        for (auto i = 0; i < phase_count_; ++i) {
+            total += phases_[i].ns;
+            os << "\t" << std::left << std::setw(28) << phases_[i].name
+                    << std::right << std::fixed << std::setprecision(3)
+                    << std::setw(10) << phases_[i].ns / 1e6 << " ms"
+                    << std::endl;
+        }
+        os << "\t" << std::left << std::setw(28) << "total (start to enable)"
+                << std::right << std::setw(10) << total / 1e6 << " ms"
+                << std::endl;
+        os.flags(flags);
+        os.precision(precision);
+    }
+
+    void print_event(std::ostream &os, Event event) const
+    {
+        static const char *names[EVENT_COUNT] = {
+            "participant discovered", 
+            "first match", 
+            "remote writer alive",
+            "first sample",
+            "snapshot republished"
+        };
+        os << "startup: " << names[event] << " "
+                << ms_after_enable(event) << " ms after enable" << std::endl;
+    }
+
+private:
+    typedef std::chrono::steady_clock clock;
+
+    struct Phase {
+        const char *name;
+        std::int64_t ns;
+    };
+
+    static std::int64_t to_ns(clock::duration d)
+    {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(d).count();
+    }
+
+    const clock::time_point start_;
+    clock::time_point last_;
+    Phase phases_[k_max_phases];
+    int phase_count_;
+    std::int64_t enable_ns_;
+    std::atomic<std::int64_t> event_ns_[EVENT_COUNT];
+};
+
+#endif
@@ -0,0 +1,84 @@
+// (c) Copyright, Real-Time Innovations, 2021.  All rights reserved.
+// RTI grants Licensee a license to use, modify, compile, and create derivative
+// works of the software solely for use with RTI Connext DDS. Licensee may
+// redistribute copies of the software provided that all such copies are subject
+// to this license. The software is provided "as is", with no warranty of any
+// type, including any warranty for fitness for any purpose. RTI is under no
+// obligation to maintain or support the software. RTI shall not be liable for
+// any incidental or consequential damages arising out of the use or inability
+// to use the software.
+
+#ifndef STATS_REPORT_H
+#define STATS_REPORT_H
+
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <sys/resource.h>
+
+#include "latency_stats.h"
+
+// End-of-run statistics in a machine-readable form: one "key = value" line
+// each, the same syntax as the files in config/. The applications write
+// one to report.stats_output on exit for benchmark_runner.sh, which reads
+// every process's file and aggregates them; the human-readable lines on
+// std::cout are unchanged.
+class StatsReport {
+public:
+    template <typename T>
+    void add(const char *key, const T &value)
+    {
+        text_ << key << " = " << value << "\n";
+    }
+
+    // count, avg/max and the log2 histogram (bucket counts separated by
+    // spaces), so reports from several processes can be merged exactly
+    void add_latency(const char *prefix, const LatencyStats::Snapshot &stats)
+    {
+        text_ << prefix << "_samples = " << stats.count << "\n"
+                << prefix << "_avg_us = "
+                << (stats.count ? stats.total_ns / 1000.0 / stats.count
+                        : 0.0) << "\n"
+                << prefix << "_p50_us = " << stats.percentile_us(0.5) << "\n"
+                << prefix << "_p99_us = " << stats.percentile_us(0.99) << "\n"
+                << prefix << "_max_us = " << stats.max_ns / 1000.0 << "\n"
+                << prefix << "_histogram =";
+        for (auto bucket : stats.histogram) {
+            text_ << " " << bucket;
+        }
+        text_ << "\n";
+    }
+
+    // CPU time and peak resident set size of this process so far
+    void add_process_usage()
+    {
+        struct rusage usage;
+        if (getrusage(RUSAGE_SELF, &usage) != 0) {
+            return;
+        }
+        add("cpu_user_s", usage.ru_utime.tv_sec +
+                usage.ru_utime.tv_usec / 1e6);
+        add("cpu_system_s", usage.ru_stime.tv_sec +
+                usage.ru_stime.tv_usec / 1e6);
+        add("max_rss_kb", usage.ru_maxrss);
+    }
+
+    bool write(const std::string &path, std::ostream &errors) const
+    {
+        std::ofstream file(path.c_str());
+        file << text_.str();
+        file.close();
+        if (!file) {
+            errors << "ERROR: failed to write stats to " << path
+                    << std::endl;
+            return false;
+        }
+        return true;
+    }
+
+private:
+    std::ostringstream text_;
+};
+
+#endif
@@ -0,0 +1,116 @@
+// (c) Copyright, Real-Time Innovations, 2021.  All rights reserved.
+// RTI grants Licensee a license to use, modify, compile, and create derivative
+// works of the software solely for use with RTI Connext DDS. Licensee may
+// redistribute copies of the software provided that all such copies are subject
+// to this license. The software is provided "as is", with no warranty of any
+// type, including any warranty for fitness for any purpose. RTI is under no
+// obligation to maintain or support the software. RTI shall not be liable for
+// any incidental or consequential damages arising out of the use or inability
+// to use the software.
+
+#ifndef TOKEN_BUCKET_H
+#define TOKEN_BUCKET_H
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <iostream>
+#include <thread>
+
+// Token bucket in front of the DataWriter: a sustained rate in bytes/s and
+// a burst size in bytes. Implemented as the equivalent virtual-scheduling
+// form (GCRA): the only state is the theoretical time at which the bucket
+// would be full again, advanced with a compare-and-swap, so any number of
+// writer threads can share one bucket without a lock.
+//
+// acquire() returns once the bytes may be sent, sleeping if the bucket is
+// empty; the sleep is the queueing delay the flow controller adds.
+class TokenBucket {
+public:
+    // bytes_per_second == 0 disables flow control
+    TokenBucket(std::int64_t bytes_per_second, std::int64_t burst_bytes)
+        : ns_per_byte_(bytes_per_second > 0
+                ? 1e9 / static_cast<double>(bytes_per_second) : 0.0),
+          burst_ns_(static_cast<std::int64_t>(ns_per_byte_ * burst_bytes)),
+          full_at_ns_(0)
+    {
+    }
+
+    bool enabled() const { return ns_per_byte_ > 0; }
+
+    void acquire(std::uint32_t bytes)
+    {
+        if (!enabled()) {
+            return;
+        }
+        auto cost_ns = static_cast<std::int64_t>(ns_per_byte_ * bytes);
+        auto now = now_ns();
+        auto full_at = full_at_ns_.load(std::memory_order_relaxed);
+        std::int64_t wait_ns;
+        do {
+            auto start = full_at > now ? full_at : now;
+            // anything beyond the burst allowance has to wait for it
+            wait_ns = start + cost_ns - now - burst_ns_;
+            if (wait_ns < 0) {
+                wait_ns = 0;
+            }
+            // on failure full_at is reloaded and the wait recomputed
+            if (full_at_ns_.compare_exchange_weak(
+                        full_at,
+                        start + cost_ns,
+                        std::memory_order_relaxed)) {
+                break;
+            }
+        } while (true);
+
+        bytes_.fetch_add(bytes, std::memory_order_relaxed);
+        acquired_.fetch_add(1, std::memory_order_relaxed);
+        if (wait_ns > 0) {
+            throttled_.fetch_add(1, std::memory_order_relaxed);
+            delay_ns_.fetch_add(wait_ns, std::memory_order_relaxed);
+            auto max = max_delay_ns_.load(std::memory_order_relaxed);
+            while (wait_ns > max &&
+                    !max_delay_ns_.compare_exchange_weak(
+                            max, wait_ns, std::memory_order_relaxed)) {
+            }
+            std::this_thread::sleep_for(std::chrono::nanoseconds(wait_ns));
+        }
+    }
+
+    void print_stats(std::ostream &os) const
+    {
+        if (!enabled()) {
+            return;
+        }
+        auto acquired = acquired_.load(std::memory_order_relaxed);
+        auto throttled = throttled_.load(std::memory_order_relaxed);
+        os << "flow control: samples = " << acquired
+                << ", bytes = " << bytes_.load(std::memory_order_relaxed)
+                << ", throttled = " << throttled
+                << ", avg queueing delay = "
+                << (throttled ? delay_ns_.load(std::memory_order_relaxed)
+                        / 1000.0 / throttled : 0.0)
+                << " us, max queueing delay = "
+                << max_delay_ns_.load(std::memory_order_relaxed) / 1000.0
+                << " us" << std::endl;
+    }
+
+private:
+    static std::int64_t now_ns()
+    {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+
+    const double ns_per_byte_;
+    const std::int64_t burst_ns_;
+    std::atomic<std::int64_t> full_at_ns_;
+
+    std::atomic<std::uint64_t> acquired_{0};
+    std::atomic<std::uint64_t> bytes_{0};
+    std::atomic<std::uint64_t> throttled_{0};
+    std::atomic<std::int64_t> delay_ns_{0};
+    std::atomic<std::int64_t> max_delay_ns_{0};
+};
+
+#endif
@@ -0,0 +1,231 @@
+// (c) Copyright, Real-Time Innovations, 2021.  All rights reserved.
+// RTI grants Licensee a license to use, modify, compile, and create derivative
+// works of the software solely for use with RTI Connext DDS. Licensee may
+// redistribute copies of the software provided that all such copies are subject
+// to this license. The software is provided "as is", with no warranty of any
+// type, including any warranty for fitness for any purpose. RTI is under no
+// obligation to maintain or support the software. RTI shall not be liable for
+// any incidental or consequential damages arising out of the use or inability
+// to use the software.
+
+#include "trace.h"
+
+#ifdef EXAMPLE_ENABLE_TRACING
+
+#include <atomic>
+#include <cstring>
+#include <fstream>
+#include <mutex>
+#include <vector>
+#include <unistd.h>
+
+namespace {
+
+struct TraceEvent {
+    const char *name;
+    std::int64_t start_ns;
+    std::int64_t duration_ns;
+    std::int64_t arg;
+};
+
+// Single producer (the owning thread), read by the exporter. head counts
+// every event ever recorded; slot head % k_trace_ring_size is written next.
+struct TraceRing {
+    unsigned int thread_number;
+    std::atomic<const char *> thread_name;
+    std::atomic<std::uint64_t> head;
+    TraceEvent events[k_trace_ring_size];
+
+    TraceRing() : thread_number(0), thread_name(NULL), head(0)
+    {
+        // touch every page now rather than on the first tracepoints
+        std::memset(events, 0, sizeof(events));
+    }
+};
+
+// rings trace_preallocate_rings() allocates: main's, the DDS receive and
+// event threads' and a few spare
+const std::size_t k_preallocated_rings = 8;
+
+// The registry and its rings are never freed: DDS receive threads are not
+// joined and may still hit a tracepoint while static destructors run at
+// exit, and the exporter reads the rings of threads that have ended.
+struct TraceRegistry {
+    std::mutex mutex;
+    std::vector<TraceRing *> rings;
+    // allocated but not yet handed to a thread
+    std::vector<TraceRing *> free_rings;
+};
+
+TraceRegistry &trace_registry()
+{
+    static auto registry = new TraceRegistry();
+    return *registry;
+}
+
+TraceRing *this_thread_ring()
+{
+    static thread_local TraceRing *ring = NULL;
+    if (ring == NULL) {
+        auto &registry = trace_registry();
+        std::lock_guard<std::mutex> lock(registry.mutex);
+        if (!registry.free_rings.empty()) {
+            ring = registry.free_rings.back();
+            registry.free_rings.pop_back();
+        } else {
+            ring = new TraceRing();
+        }
+        ring->thread_number = registry.rings.size() + 1;
+        registry.rings.push_back(ring);
+    }
+    return ring;
+}
+
+void write_json_string(std::ostream &os, const char *text)
+{
+    os << '"';
+    for (const char *c = text; *c != '\0'; ++c) {
+        if (*c == '"' || *c == '\\') {
+            os << '\\';
+        }
+        os << *c;
+    }
+    os << '"';
+}
+
+// Chrome trace timestamps are in microseconds; keep the nanoseconds
+void write_us(std::ostream &os, std::int64_t ns)
+{
+    if (ns < 0) {
+        os << '-';
+        ns = -ns;
+    }
+    auto fraction = ns % 1000;
+    os << ns / 1000 << '.' << (fraction < 100 ? "0" : "")
+            << (fraction < 10 ? "0" : "") << fraction;
+}
+
+}  // namespace
+
+void trace_preallocate_rings()
+{
+    auto &registry = trace_registry();
+    std::lock_guard<std::mutex> lock(registry.mutex);
+    registry.rings.reserve(k_preallocated_rings * 2);
+    while (registry.free_rings.size() < k_preallocated_rings) {
+        registry.free_rings.push_back(new TraceRing());
+    }
+}
+
+void trace_record(
+        const char *name,
+        std::int64_t start_ns,
+        std::int64_t duration_ns,
+        std::int64_t arg)
+{
+    auto ring = this_thread_ring();
+    auto head = ring->head.load(std::memory_order_relaxed);
+    auto &event = ring->events[head % k_trace_ring_size];
+    event.name = name;
+    event.start_ns = start_ns;
+    event.duration_ns = duration_ns;
+    event.arg = arg;
+    ring->head.store(head + 1, std::memory_order_release);
+}
+
+void trace_set_thread_name(const char *name)
+{
+    this_thread_ring()->thread_name.store(name, std::memory_order_relaxed);
+}
+
+bool trace_export_chrome_json(const std::string &path, std::ostream &errors)
+{
+    std::ofstream out(path.c_str());
+    if (!out) {
+        errors << "ERROR: failed to open trace file " << path << std::endl;
+        return false;
+    }
+
+    auto pid = getpid();
+    auto &registry = trace_registry();
+    std::lock_guard<std::mutex> lock(registry.mutex);
+    std::uint64_t exported = 0;
+    std::uint64_t overwritten = 0;
+
+    out << "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[";
+    const char *separator = "\n";
+    std::vector<TraceEvent> events;
+    for (auto ring : registry.rings) {
+        // Copy the ring, then drop whatever its thread may have overwritten
+        // while we were copying: the copy is only trusted from
+        // head_after - k_trace_ring_size + 1 on, since the thread may be
+        // writing event head_after into the slot of the one before.
+        auto head = ring->head.load(std::memory_order_acquire);
+        auto first = head > k_trace_ring_size ? head - k_trace_ring_size : 0;
+        events.clear();
+        for (auto i = first; i < head; ++i) {
+            events.push_back(ring->events[i % k_trace_ring_size]);
+        }
+        auto head_after = ring->head.load(std::memory_order_acquire);
+        auto valid_from = head_after >= k_trace_ring_size
+                ? head_after - k_trace_ring_size + 1 : 0;
+        overwritten += first;
+
+        auto name = ring->thread_name.load(std::memory_order_relaxed);
+        out << separator << "{\"ph\":\"M\",\"name\":\"thread_name\",\"pid\":"
+                << pid << ",\"tid\":" << ring->thread_number
+                << ",\"args\":{\"name\":";
+        if (name != NULL) {
+            write_json_string(out, name);
+        } else {
+            out << "\"thread " << ring->thread_number << '"';
+        }
+        out << "}}";
+        separator = ",\n";
+
+        for (auto i = first; i < head; ++i) {
+            if (i < valid_from) {
+                ++overwritten;
+                continue;
+            }
+            const auto &event = events[i - first];
+            out << separator << "{\"name\":";
+            write_json_string(out, event.name);
+            out << ",\"pid\":" << pid << ",\"tid\":" << ring->thread_number
+                    << ",\"ts\":";
+            write_us(out, event.start_ns);
+            if (event.duration_ns < 0) {
+                out << ",\"ph\":\"i\",\"s\":\"t\"";
+            } else {
+                out << ",\"ph\":\"X\",\"dur\":";
+                write_us(out, event.duration_ns);
+            }
+            out << ",\"args\":{\"arg\":" << event.arg << "}}";
+            ++exported;
+        }
+    }
+    out << "\n]}\n";
+    out.close();
+    if (!out) {
+        errors << "ERROR: failed to write trace file " << path << std::endl;
+        return false;
+    }
+
+    std::cout << "trace: " << exported << " events written to " << path;
+    if (overwritten > 0) {
+        std::cout << " (" << overwritten << " older events overwritten)";
+    }
+    std::cout << std::endl;
+    return true;
+}
+
+#else
+
+bool trace_export_chrome_json(const std::string &path, std::ostream &errors)
+{
+    errors << "ERROR: not writing " << path
+            << ": built without EXAMPLE_ENABLE_TRACING" << std::endl;
+    return false;
+}
+
+#endif
@@ -0,0 +1,109 @@
+// (c) Copyright, Real-Time Innovations, 2021.  All rights reserved.
+// RTI grants Licensee a license to use, modify, compile, and create derivative
+// works of the software solely for use with RTI Connext DDS. Licensee may
+// redistribute copies of the software provided that all such copies are subject
+// to this license. The software is provided "as is", with no warranty of any
+// type, including any warranty for fitness for any purpose. RTI is under no
+// obligation to maintain or support the software. RTI shall not be liable for
+// any incidental or consequential damages arising out of the use or inability
+// to use the software.
+
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <iostream>
+#include <string>
+
+// Tracepoints for the write and take paths. They are compiled in only when
+// EXAMPLE_ENABLE_TRACING is defined (cmake -DEXAMPLE_ENABLE_TRACING=ON);
+// otherwise every EXAMPLE_TRACE_* macro expands to nothing.
+//
+// Each thread appends to its own ring buffer, so a tracepoint is two clock
+// reads and a few stores with no lock and no system call. Timestamps come
+// from CLOCK_MONOTONIC, which is shared by every process on the host: the
+// publisher's and the subscriber's traces line up on one timeline when
+// loaded together into chrome://tracing or ui.perfetto.dev.
+//
+//     EXAMPLE_TRACE_SCOPE("write", sample->id);  // until end of the block
+//     EXAMPLE_TRACE_INSTANT("first match", 0);
+//     EXAMPLE_TRACE_THREAD_NAME("main");
+//
+// Names must be string literals (only the pointer is stored).
+//
+// A thread's first tracepoint takes a ring (1 MiB) under a lock.
+// EXAMPLE_TRACE_SETUP(), at the top of main() before any DDS thread
+// exists, allocates rings for the first few threads up front, so those
+// threads only take one from a free list; later threads allocate their
+// own. Rings are never freed.
+
+// Write every buffered event as Chrome trace event JSON. Returns false
+// (and explains why) if tracing is not compiled in or the file can't be
+// written.
+bool trace_export_chrome_json(const std::string &path, std::ostream &errors);
+
+#ifdef EXAMPLE_ENABLE_TRACING
+
+#include <cstdint>
+#include <ctime>
+
+// events each thread keeps; older ones are overwritten
+static const unsigned int k_trace_ring_size = 1 << 15;
+
+inline std::int64_t trace_now_ns()
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return static_cast<std::int64_t>(now.tv_sec) * 1000000000 + now.tv_nsec;
+}
+
+// append a complete event (duration_ns < 0 for an instant event)
+void trace_record(
+        const char *name,
+        std::int64_t start_ns,
+        std::int64_t duration_ns,
+        std::int64_t arg);
+
+void trace_set_thread_name(const char *name);
+
+void trace_preallocate_rings();
+
+class TraceScope {
+public:
+    TraceScope(const char *name, std::int64_t arg)
+        : name_(name), arg_(arg), start_ns_(trace_now_ns())
+    {
+    }
+
+    ~TraceScope()
+    {
+        trace_record(name_, start_ns_, trace_now_ns() - start_ns_, arg_);
+    }
+
+    TraceScope(const TraceScope &) = delete;
+    TraceScope &operator=(const TraceScope &) = delete;
+
+private:
+    const char *name_;
+    std::int64_t arg_;
+    std::int64_t start_ns_;
+};
+
+#define EXAMPLE_TRACE_CONCAT_(a, b) a##b
+#define EXAMPLE_TRACE_CONCAT(a, b) EXAMPLE_TRACE_CONCAT_(a, b)
+#define EXAMPLE_TRACE_SCOPE(name, arg) \
+    TraceScope EXAMPLE_TRACE_CONCAT(trace_scope_, __LINE__)((name), (arg))
+#define EXAMPLE_TRACE_INSTANT(name, arg) \
+    trace_record((name), trace_now_ns(), -1, (arg))
+#define EXAMPLE_TRACE_THREAD_NAME(name) trace_set_thread_name(name)
+#define EXAMPLE_TRACE_SETUP() trace_preallocate_rings()
+
+#else
+
+#define EXAMPLE_TRACE_SCOPE(name, arg)
+#define EXAMPLE_TRACE_INSTANT(name, arg)
+#define EXAMPLE_TRACE_THREAD_NAME(name)
+#define EXAMPLE_TRACE_SETUP()
+
+#endif
+
+#endif
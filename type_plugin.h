@@ -0,0 +1,554 @@
+// (c) Copyright, Real-Time Innovations, 2021.  All rights reserved.
+// RTI grants Licensee a license to use, modify, compile, and create derivative
+// works of the software solely for use with RTI Connext DDS. Licensee may
+// redistribute copies of the software provided that all such copies are subject
+// to this license. The software is provided "as is", with no warranty of any
+// type, including any warranty for fitness for any purpose. RTI is under no
+// obligation to maintain or support the software. RTI shall not be liable for
+// any incidental or consequential damages arising out of the use or inability
+// to use the software.
+
+#ifndef TYPE_PLUGIN_H
+#define TYPE_PLUGIN_H
+
+#include "rti_me_c.h"
+
+// Builds the NDDS_Type_Plugin that rtiddsgen would generate (examplePlugin.c)
+// from a C struct and a compile-time list of its fields. Each field type
+// knows how to serialize, size, initialize and copy itself with the same CDR
+// calls the generated code makes, so the wire format is identical; every call
+// is resolved at compile time and inlined into one function per plugin entry.
+//
+//     struct MyTypeDescription {
+//         typedef my_type Struct;
+//         typedef type_plugin::Fields<
+//                 type_plugin::LongField<my_type, &my_type::id, true>,
+//                 type_plugin::StringField<my_type, &my_type::msg, 128>>
+//             Members;
+//     };
+//     DDS_DomainParticipant_register_type(
+//             dp, "my_type",
+//             type_plugin::TypePlugin<MyTypeDescription>::get());
+//
+// Supported members are CDR_Long, CDR_UnsignedLong, bounded strings and
+// bounded octet sequences; key members are marked with a true last template
+// argument.
+namespace type_plugin {
+
+// padding needed to align offset to a multiple of alignment
+constexpr RTI_UINT32 padding(RTI_UINT32 offset, RTI_UINT32 alignment)
+{
+    return (alignment - offset % alignment) % alignment;
+}
+
+// the CDR call for each primitive, picked by overload
+inline RTI_BOOL serialize_primitive(
+        struct CDR_Stream_t *stream,
+        const CDR_Long *value)
+{
+    return CDR_Stream_serialize_long(stream, value);
+}
+
+inline RTI_BOOL serialize_primitive(
+        struct CDR_Stream_t *stream,
+        const CDR_UnsignedLong *value)
+{
+    return CDR_Stream_serialize_unsigned_long(stream, value);
+}
+
+inline RTI_BOOL deserialize_primitive(
+        struct CDR_Stream_t *stream,
+        CDR_Long *value)
+{
+    return CDR_Stream_deserialize_long(stream, value);
+}
+
+inline RTI_BOOL deserialize_primitive(
+        struct CDR_Stream_t *stream,
+        CDR_UnsignedLong *value)
+{
+    return CDR_Stream_deserialize_unsigned_long(stream, value);
+}
+
+// a 4-byte primitive member
+template <typename Struct, typename T, T Struct::*Member, bool Key>
+struct Primitive32Field {
+    static const bool is_key = Key;
+
+    static constexpr RTI_UINT32 max_size(RTI_UINT32 alignment)
+    {
+        return padding(alignment, 4) + 4;
+    }
+
+    static RTI_BOOL serialize(struct CDR_Stream_t *stream, const Struct &s)
+    {
+        return serialize_primitive(stream, &(s.*Member));
+    }
+
+    static RTI_BOOL deserialize(struct CDR_Stream_t *stream, Struct &s)
+    {
+        return deserialize_primitive(stream, &(s.*Member));
+    }
+
+    static RTI_BOOL initialize(Struct &s)
+    {
+        s.*Member = 0;
+        return RTI_TRUE;
+    }
+
+    static RTI_BOOL copy(Struct &dst, const Struct &src)
+    {
+        dst.*Member = src.*Member;
+        return RTI_TRUE;
+    }
+
+#ifndef RTI_CERT
+    static void finalize(Struct &)
+    {
+    }
+#endif
+
+    // append the member to a key hash as big-endian CDR
+    static void to_key_hash(const Struct &s, DDS_Octet *hash, RTI_UINT32 &pos)
+    {
+        auto value = static_cast<RTI_UINT32>(s.*Member);
+        pos += padding(pos, 4);
+        hash[pos++] = static_cast<DDS_Octet>(value >> 24);
+        hash[pos++] = static_cast<DDS_Octet>(value >> 16);
+        hash[pos++] = static_cast<DDS_Octet>(value >> 8);
+        hash[pos++] = static_cast<DDS_Octet>(value);
+    }
+};
+
+template <typename Struct, CDR_Long Struct::*Member, bool Key = false>
+using LongField = Primitive32Field<Struct, CDR_Long, Member, Key>;
+
+template <typename Struct, CDR_UnsignedLong Struct::*Member, bool Key = false>
+using UnsignedLongField =
+        Primitive32Field<Struct, CDR_UnsignedLong, Member, Key>;
+
+// string<Bound>: a length (including the terminating NUL) and the characters
+template <
+        typename Struct,
+        CDR_String Struct::*Member,
+        RTI_UINT32 Bound,
+        bool Key = false>
+struct StringField {
+    static const bool is_key = Key;
+
+    static constexpr RTI_UINT32 max_size(RTI_UINT32 alignment)
+    {
+        return padding(alignment, 4) + 4 + Bound + 1;
+    }
+
+    static RTI_BOOL serialize(struct CDR_Stream_t *stream, const Struct &s)
+    {
+        return CDR_Stream_serialize_string(stream, s.*Member, Bound);
+    }
+
+    static RTI_BOOL deserialize(struct CDR_Stream_t *stream, Struct &s)
+    {
+        return CDR_Stream_deserialize_string(stream, s.*Member, Bound);
+    }
+
+    static RTI_BOOL initialize(Struct &s)
+    {
+        return CDR_String_initialize(&(s.*Member), Bound);
+    }
+
+    static RTI_BOOL copy(Struct &dst, const Struct &src)
+    {
+        return CDR_String_copy(&(dst.*Member), &(src.*Member), Bound);
+    }
+
+#ifndef RTI_CERT
+    static void finalize(Struct &s)
+    {
+        CDR_String_finalize(&(s.*Member));
+    }
+#endif
+
+    static void to_key_hash(const Struct &s, DDS_Octet *hash, RTI_UINT32 &pos)
+    {
+        const char *text = s.*Member;
+        RTI_UINT32 length = 0;
+        while (text[length] != '\0' && length < Bound) {
+            ++length;
+        }
+        pos += padding(pos, 4);
+        auto with_nul = length + 1;
+        hash[pos++] = static_cast<DDS_Octet>(with_nul >> 24);
+        hash[pos++] = static_cast<DDS_Octet>(with_nul >> 16);
+        hash[pos++] = static_cast<DDS_Octet>(with_nul >> 8);
+        hash[pos++] = static_cast<DDS_Octet>(with_nul);
+        for (RTI_UINT32 i = 0; i < length; ++i) {
+            hash[pos++] = static_cast<DDS_Octet>(text[i]);
+        }
+        hash[pos++] = 0;
+    }
+};
+
+// sequence<octet, Bound>: a length and the bytes. The sequence gets its
+// full maximum when the sample is created, so deserializing never
+// allocates. Not usable as a key.
+template <
+        typename Struct,
+        struct DDS_OctetSeq Struct::*Member,
+        RTI_UINT32 Bound>
+struct OctetSeqField {
+    static const bool is_key = false;
+
+    static constexpr RTI_UINT32 max_size(RTI_UINT32 alignment)
+    {
+        return padding(alignment, 4) + 4 + Bound;
+    }
+
+    static RTI_BOOL serialize(struct CDR_Stream_t *stream, const Struct &s)
+    {
+        return CDR_Stream_serialize_OctetSeq(stream, &(s.*Member), Bound);
+    }
+
+    static RTI_BOOL deserialize(struct CDR_Stream_t *stream, Struct &s)
+    {
+        return CDR_Stream_deserialize_OctetSeq(stream, &(s.*Member), Bound);
+    }
+
+    static RTI_BOOL initialize(Struct &s)
+    {
+        return DDS_OctetSeq_initialize(&(s.*Member)) &&
+                DDS_OctetSeq_set_maximum(&(s.*Member), Bound);
+    }
+
+    static RTI_BOOL copy(Struct &dst, const Struct &src)
+    {
+        return DDS_OctetSeq_copy(&(dst.*Member), &(src.*Member));
+    }
+
+#ifndef RTI_CERT
+    static void finalize(Struct &s)
+    {
+        DDS_OctetSeq_finalize(&(s.*Member));
+    }
+#endif
+
+    static void to_key_hash(const Struct &, DDS_Octet *, RTI_UINT32 &)
+    {
+    }
+};
+
+// The members of a struct, in IDL order. Each operation recurses over the
+// list at compile time; keys_only restricts it to the key members.
+template <typename... Members>
+struct Fields;
+
+template <>
+struct Fields<> {
+    static const bool has_key = false;
+
+    static constexpr RTI_UINT32 max_size(RTI_UINT32, bool)
+    {
+        return 0;
+    }
+
+    template <typename Struct>
+    static RTI_BOOL serialize(struct CDR_Stream_t *, const Struct &, bool)
+    {
+        return RTI_TRUE;
+    }
+
+    template <typename Struct>
+    static RTI_BOOL deserialize(struct CDR_Stream_t *, Struct &, bool)
+    {
+        return RTI_TRUE;
+    }
+
+    template <typename Struct>
+    static RTI_BOOL initialize(Struct &)
+    {
+        return RTI_TRUE;
+    }
+
+    template <typename Struct>
+    static RTI_BOOL copy(Struct &, const Struct &)
+    {
+        return RTI_TRUE;
+    }
+
+#ifndef RTI_CERT
+    template <typename Struct>
+    static void finalize(Struct &)
+    {
+    }
+#endif
+
+    template <typename Struct>
+    static void to_key_hash(const Struct &, DDS_Octet *, RTI_UINT32 &)
+    {
+    }
+};
+
+template <typename First, typename... Rest>
+struct Fields<First, Rest...> {
+    typedef Fields<Rest...> Tail;
+
+    static const bool has_key = First::is_key || Tail::has_key;
+
+    // serialized size of the members (or of the key members) starting at
+    // the given alignment, in the worst case
+    static constexpr RTI_UINT32 max_size(RTI_UINT32 alignment, bool keys_only)
+    {
+        return (keys_only && !First::is_key)
+                ? Tail::max_size(alignment, keys_only)
+                : First::max_size(alignment)
+                        + Tail::max_size(
+                                alignment + First::max_size(alignment),
+                                keys_only);
+    }
+
+    template <typename Struct>
+    static RTI_BOOL serialize(
+            struct CDR_Stream_t *stream,
+            const Struct &s,
+            bool keys_only)
+    {
+        if (!(keys_only && !First::is_key) && !First::serialize(stream, s)) {
+            return RTI_FALSE;
+        }
+        return Tail::serialize(stream, s, keys_only);
+    }
+
+    template <typename Struct>
+    static RTI_BOOL deserialize(
+            struct CDR_Stream_t *stream,
+            Struct &s,
+            bool keys_only)
+    {
+        if (!(keys_only && !First::is_key) && !First::deserialize(stream, s)) {
+            return RTI_FALSE;
+        }
+        return Tail::deserialize(stream, s, keys_only);
+    }
+
+    template <typename Struct>
+    static RTI_BOOL initialize(Struct &s)
+    {
+        return First::initialize(s) && Tail::initialize(s);
+    }
+
+    template <typename Struct>
+    static RTI_BOOL copy(Struct &dst, const Struct &src)
+    {
+        return First::copy(dst, src) && Tail::copy(dst, src);
+    }
+
+#ifndef RTI_CERT
+    template <typename Struct>
+    static void finalize(Struct &s)
+    {
+        First::finalize(s);
+        Tail::finalize(s);
+    }
+#endif
+
+    template <typename Struct>
+    static void to_key_hash(const Struct &s, DDS_Octet *hash, RTI_UINT32 &pos)
+    {
+        if (First::is_key) {
+            First::to_key_hash(s, hash, pos);
+        }
+        Tail::to_key_hash(s, hash, pos);
+    }
+};
+
+// The plugin for Description::Struct, laid out like the generated
+// my_typeTypePlugin. As with the generated code, samples can only be
+// deleted outside RTI_CERT.
+template <typename Description>
+class TypePlugin {
+public:
+    typedef typename Description::Struct Struct;
+    typedef typename Description::Members Members;
+
+    static const bool has_key = Members::has_key;
+
+    // worst-case serialized sizes from offset 0, usable for static buffers
+    static constexpr RTI_UINT32 max_serialized_size()
+    {
+        return Members::max_size(0, false);
+    }
+    static constexpr RTI_UINT32 max_serialized_key_size()
+    {
+        return Members::max_size(0, true);
+    }
+
+    static struct NDDS_Type_Plugin *get() { return &plugin_; }
+
+    static RTI_BOOL serialize(
+            struct CDR_Stream_t *stream,
+            const void *sample,
+            void *)
+    {
+        if (stream == NULL || sample == NULL) {
+            return RTI_FALSE;
+        }
+        return Members::serialize(
+                stream, *static_cast<const Struct *>(sample), false);
+    }
+
+    static RTI_BOOL deserialize(
+            struct CDR_Stream_t *stream,
+            void *sample,
+            void *)
+    {
+        if (stream == NULL || sample == NULL) {
+            return RTI_FALSE;
+        }
+        return Members::deserialize(
+                stream, *static_cast<Struct *>(sample), false);
+    }
+
+    static RTI_UINT32 get_serialized_sample_max_size(
+            struct NDDS_Type_Plugin *,
+            RTI_UINT32 current_alignment,
+            void *)
+    {
+        return Members::max_size(current_alignment, false);
+    }
+
+    static RTI_BOOL serialize_key(
+            struct CDR_Stream_t *stream,
+            const void *sample,
+            void *)
+    {
+        if (stream == NULL || sample == NULL) {
+            return RTI_FALSE;
+        }
+        return Members::serialize(
+                stream, *static_cast<const Struct *>(sample), true);
+    }
+
+    static RTI_BOOL deserialize_key(
+            struct CDR_Stream_t *stream,
+            void *sample,
+            void *)
+    {
+        if (stream == NULL || sample == NULL) {
+            return RTI_FALSE;
+        }
+        return Members::deserialize(
+                stream, *static_cast<Struct *>(sample), true);
+    }
+
+    static RTI_UINT32 get_serialized_key_max_size(
+            struct NDDS_Type_Plugin *,
+            RTI_UINT32 current_alignment,
+            void *)
+    {
+        return Members::max_size(current_alignment, true);
+    }
+
+    static RTI_BOOL create_sample(
+            struct NDDS_Type_Plugin *,
+            void **sample,
+            void *)
+    {
+        Struct *created;
+        OSAPI_Heap_allocate_struct(&created, Struct);
+        if (created != NULL && !Members::initialize(*created)) {
+            OSAPI_Heap_free_struct(created);
+            created = NULL;
+        }
+        *sample = created;
+        return created != NULL;
+    }
+
+#ifndef RTI_CERT
+    static RTI_BOOL delete_sample(
+            struct NDDS_Type_Plugin *,
+            void *sample,
+            void *)
+    {
+        // like my_typePlugin_delete_sample, sample is assumed to be valid
+        auto deleted = static_cast<Struct *>(sample);
+        Members::finalize(*deleted);
+        OSAPI_Heap_free_struct(deleted);
+        return RTI_TRUE;
+    }
+#endif
+
+    static RTI_BOOL copy_sample(
+            struct NDDS_Type_Plugin *,
+            void *dst,
+            const void *src,
+            void *)
+    {
+        if (dst == NULL || src == NULL) {
+            return RTI_FALSE;
+        }
+        return Members::copy(
+                *static_cast<Struct *>(dst),
+                *static_cast<const Struct *>(src));
+    }
+
+    // A key that always fits in 16 bytes is its own hash: the big-endian
+    // CDR of the key members, zero-padded. Longer keys are left to the
+    // generic helper, which hashes them.
+    static RTI_BOOL instance_to_keyhash(
+            struct NDDS_Type_Plugin *plugin,
+            struct CDR_Stream_t *stream,
+            DDS_KeyHash_t *key_hash,
+            const void *instance,
+            void *param)
+    {
+        if (max_serialized_key_size() > sizeof(key_hash->value)) {
+            return PluginHelper_instance_to_keyhash(
+                    plugin, stream, key_hash, instance, param);
+        }
+        if (key_hash == NULL || instance == NULL) {
+            return RTI_FALSE;
+        }
+        RTI_UINT32 pos = 0;
+        Members::to_key_hash(
+                *static_cast<const Struct *>(instance), key_hash->value, pos);
+        while (pos < sizeof(key_hash->value)) {
+            key_hash->value[pos++] = 0;
+        }
+        return RTI_TRUE;
+    }
+
+private:
+    static NDDSCDREncapsulation encapsulation_[];
+    static struct NDDS_Type_Plugin plugin_;
+};
+
+template <typename Description>
+NDDSCDREncapsulation TypePlugin<Description>::encapsulation_[] = { {0, 0} };
+
+template <typename Description>
+struct NDDS_Type_Plugin TypePlugin<Description>::plugin_ = {
+    {0, 0},                     // NDDS_Type_PluginVersion
+    NULL,                       // DDS_TypeCode_t*
+    TypePlugin<Description>::encapsulation_,
+    TypePlugin<Description>::has_key
+            ? NDDS_TYPEPLUGIN_USER_KEY : NDDS_TYPEPLUGIN_NO_KEY,
+    TypePlugin<Description>::serialize,
+    TypePlugin<Description>::deserialize,
+    TypePlugin<Description>::get_serialized_sample_max_size,
+    TypePlugin<Description>::serialize_key,
+    TypePlugin<Description>::deserialize_key,
+    TypePlugin<Description>::get_serialized_key_max_size,
+    TypePlugin<Description>::create_sample,
+#ifndef RTI_CERT
+    TypePlugin<Description>::delete_sample,
+#else
+    NULL,
+#endif
+    TypePlugin<Description>::copy_sample,
+    PluginHelper_get_key_kind,
+    TypePlugin<Description>::instance_to_keyhash,
+    NULL, NULL, NULL, NULL      // endpoint wrappers not used in C
+};
+
+}  // namespace type_plugin
+
+#endif
@@ -0,0 +1,67 @@
+#!/bin/bash
+# (c) Copyright, Real-Time Innovations, 2021.  All rights reserved.
+# RTI grants Licensee a license to use, modify, compile, and create derivative
+# works of the software solely for use with RTI Connext DDS. Licensee may
+# redistribute copies of the software provided that all such copies are subject
+# to this license. The software is provided "as is", with no warranty of any
+# type, including any warranty for fitness for any purpose. RTI is under no
+# obligation to maintain or support the software. RTI shall not be liable for
+# any incidental or consequential damages arising out of the use or inability
+# to use the software.
+
+
+
+# The generated my_type plugin against the C++ template one
+# (my_type_plugin.h) under load. For each payload in PAYLOADS, runs
+# benchmark_runner.sh (one publisher, one subscriber) once with
+# type.template_plugin=false and once with it true, then prints one line per
+# run: samples delivered per second, loss, the latency p50/p99, the take
+# cost per sample and both processes' CPU use. Set type.plugin_check=true in
+# SETTINGS to also have the publisher compare the two plugins byte for byte
+# and time them in isolation before each run.
+#
+#     ./type_plugin_benchmark.sh objs/x64Linux4gcc7.3.0_cert
+#
+# Environment: PAYLOADS (publisher.payload_bytes values, default "0 64
+# 128"), STREAMS (the schedule.streams value, default "20000:1"), DURATION
+# (seconds per run, default 10), CORES, SETTINGS and CONFIG as for
+# benchmark_runner.sh.
+
+set -u
+
+BIN_DIR=${1:-objs/${RTIME_TARGET_NAME:-x64Linux4gcc7.3.0_cert}}
+PAYLOADS=${PAYLOADS:-"0 64 128"}
+LOG_DIR=$(mktemp -d /tmp/type_plugin_benchmark.XXXXXX)
+
+source "$(dirname "$0")/benchmark_common.sh"
+require_binaries
+
+printf "%-9s %-8s %12s %8s %9s %9s %9s %8s %8s\n" plugin payload \
+        delivered/s loss% p50_us p99_us take_ns pub_cpu% sub_cpu%
+for payload in $PAYLOADS; do
+    for plugin in generated template; do
+        settings="${SETTINGS:-} subscriber.min_samples_per_take=1"
+        if [ "$plugin" = template ]; then
+            settings+=" type.template_plugin=true"
+        else
+            settings+=" type.template_plugin=false"
+        fi
+        report=$LOG_DIR/${plugin}_$payload.txt
+        if ! run_point "${plugin}_$payload" "${STREAMS:-"20000:1"}" \
+                "$payload" "$settings"; then
+            echo "ERROR: no report for the $plugin plugin with payload" \
+                    "$payload, see $LOG_DIR"
+            continue
+        fi
+        printf "%-9s %-8s %12s %8s %9s %9s %9s %8s %8s\n" \
+                "$plugin" "$payload" \
+                "$(report_value "$report" delivered_per_s)" \
+                "$(report_value "$report" loss_pct)" \
+                "$(report_value "$report" latency_p50_us)" \
+                "$(report_value "$report" latency_p99_us)" \
+                "$(report_value "$report" take_ns_per_sample)" \
+                "$(report_value "$report" publisher_cpu_pct)" \
+                "$(report_value "$report" subscriber_cpu_pct)"
+    done
+done
+echo "logs in $LOG_DIR"